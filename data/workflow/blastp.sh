@@ -55,6 +55,16 @@ while [ "$STEP" -lt "$STEPS" ]; do
     SENS_PARAM=SENSE_${STEP}
     eval SENS="\$$SENS_PARAM"
 
+    # 1.+2. Prefilter and align each query right away without writing the prefilter result
+    if [ -n "$PREFILTER_ALIGN_PAR" ] && [ "$STEPS" -eq 1 ]; then
+        if notExists "$3.dbtype"; then
+            # shellcheck disable=SC2086
+            $RUNNER "$MMSEQS" prefilteralign "$INPUT" "$TARGET" "$3" $PREFILTER_ALIGN_PAR -s "$SENS" \
+                || fail "Prefilter and alignment died"
+        fi
+        break
+    fi
+
     # 1. Prefilter hits
     if notExists "$TMP_PATH/pref_$STEP.dbtype"; then
       if [ "$PREFMODE" = "EXHAUSTIVE" ]; then
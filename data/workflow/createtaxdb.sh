@@ -101,13 +101,9 @@ if notExists "${TAXDBNAME}_mapping"; then
         MAPPINGFILE="${TMP_PATH}/taxidmapping"
     fi
 
-    if [ "$MAPPINGMODE" = "0" ]; then
-        awk 'NR == FNR { f[$1] = $2; next } $2 in f { print $1"\t"f[$2] }' \
-            "$MAPPINGFILE" "${TAXDBNAME}.lookup" > "${TAXDBNAME}_mapping"
-    else
-        awk 'FNR == 1 { fidx++; } fidx == 1 { tax[$1] = $2; next; } fidx == 2 { source[$1] = tax[$2]; next; } fidx == 3 { print $1"\t"source[$3]; next; }' \
-            "$MAPPINGFILE" "${TAXDBNAME}.source" "${TAXDBNAME}.lookup" > "${TAXDBNAME}_mapping"
-    fi
+    # shellcheck disable=SC2086
+    "${MMSEQS}" createtaxmapping "$MAPPINGFILE" "${TAXDBNAME}" "${TAXDBNAME}_mapping" --tax-mapping-mode "$MAPPINGMODE" ${THREADS_PAR} \
+        || fail "createtaxmapping failed"
 fi
 
 if [ -n "$REMOVE_TMP" ]; then
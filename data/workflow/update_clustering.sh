@@ -44,6 +44,8 @@ OLDCLUST="$(abspath "$3")"
 NEWMAPDB="$(abspath "$4")"
 NEWCLUST="$(abspath "$5")"
 TMP_PATH="$(abspath "$6")"
+OLDREP="${OLDCLUST}_rep"
+NEWREP="${NEWCLUST}_rep"
 
 if notExists "${TMP_PATH}/removedSeqs"; then
     # shellcheck disable=SC2086
@@ -158,7 +160,12 @@ if notExists "${TMP_PATH}/NEWDB.newSeqs.dbtype"; then
         || fail "createsubdb died"
 fi
 
-if notExists "${TMP_PATH}/OLDDB.repSeq.dbtype"; then
+# representatives kept by a previous update stay valid as long as none of them was deleted
+REPSEQ="${TMP_PATH}/OLDDB.repSeq"
+if [ -n "${KEEP_REP_INDEX}" ] && [ -f "${OLDREP}.dbtype" ] && [ ! -s "${TMP_PATH}/REMOVEDMEMBERS.index" ]; then
+    log "=== Reuse representative sequences of previous update"
+    REPSEQ="${OLDREP}"
+elif notExists "${TMP_PATH}/OLDDB.repSeq.dbtype"; then
     log "=== Extract representative sequences"
     # shellcheck disable=SC2086
     "$MMSEQS" result2repseq "$OLDDB" "$OLDCLUST" "${TMP_PATH}/OLDDB.repSeq" ${RESULT2REPSEQ_PAR} \
@@ -168,7 +175,7 @@ fi
 if notExists "${TMP_PATH}/newSeqsHits.dbtype"; then
     log "=== Search new sequences against representatives"
     # shellcheck disable=SC2086
-    "$MMSEQS" search "${TMP_PATH}/NEWDB.newSeqs" "${TMP_PATH}/OLDDB.repSeq" "${TMP_PATH}/newSeqsHits" "${TMP_PATH}/search" ${SEARCH_PAR} \
+    "$MMSEQS" search "${TMP_PATH}/NEWDB.newSeqs" "${REPSEQ}" "${TMP_PATH}/newSeqsHits" "${TMP_PATH}/search" ${SEARCH_PAR} \
         || fail "search died"
 fi
 
@@ -224,6 +231,49 @@ else
     "$MMSEQS" mvdb "${UPDATEDCLUST}" "$NEWCLUST" ${VERBOSITY}
 fi
 
+if [ -n "${KEEP_REP_INDEX}" ] && notExists "${NEWREP}.dbtype"; then
+    # NEWREP is assembled in tmp and only moved to its place once its index is built,
+    # an interrupted run starts over from the kept representatives
+    # shellcheck disable=SC2086
+    "$MMSEQS" rmdb "${TMP_PATH}/NEWREP" ${VERBOSITY}
+    # shellcheck disable=SC2086
+    "$MMSEQS" rmdb "${TMP_PATH}/NEWREP.idx" ${VERBOSITY}
+    # shellcheck disable=SC2086
+    "$MMSEQS" cpdb "${REPSEQ}" "${TMP_PATH}/NEWREP" ${VERBOSITY} \
+        || fail "cpdb died"
+    # the headers are extracted again from NEWDB below, appenddb must not append them
+    # shellcheck disable=SC2086
+    "$MMSEQS" rmdb "${TMP_PATH}/NEWREP_h" ${VERBOSITY}
+    # only the representatives of the new clusters are extracted and appended as a new data segment
+    if [ -f "${TMP_PATH}/newClusters.dbtype" ]; then
+        log "=== Append representatives of new clusters"
+        if notExists "${TMP_PATH}/newClusters.repSeq.dbtype"; then
+            # shellcheck disable=SC2086
+            "$MMSEQS" result2repseq "$NEWDB" "${TMP_PATH}/newClusters" "${TMP_PATH}/newClusters.repSeq" ${RESULT2REPSEQ_PAR} \
+                || fail "result2repseq died"
+        fi
+        # shellcheck disable=SC2086
+        "$MMSEQS" appenddb "${TMP_PATH}/NEWREP" "${TMP_PATH}/newClusters.repSeq" ${VERBOSITY} \
+            || fail "appenddb died"
+    fi
+    # the index does not contain headers, these are only linked for createindex
+    # shellcheck disable=SC2086
+    "$MMSEQS" createsubdb "${TMP_PATH}/NEWREP.index" "${NEWDB}_h" "${TMP_PATH}/NEWREP_h" --subdb-mode 1 ${VERBOSITY} \
+        || fail "createsubdb died"
+    # shellcheck disable=SC2086
+    "$MMSEQS" createindex "${TMP_PATH}/NEWREP" "${TMP_PATH}/index" ${CREATEINDEX_PAR} \
+        || fail "createindex died"
+    # shellcheck disable=SC2086
+    "$MMSEQS" mvdb "${TMP_PATH}/NEWREP.idx" "${NEWREP}.idx" ${VERBOSITY} \
+        || fail "mvdb died"
+    # shellcheck disable=SC2086
+    "$MMSEQS" mvdb "${TMP_PATH}/NEWREP_h" "${NEWREP}_h" ${VERBOSITY} \
+        || fail "mvdb died"
+    # shellcheck disable=SC2086
+    "$MMSEQS" mvdb "${TMP_PATH}/NEWREP" "${NEWREP}" ${VERBOSITY} \
+        || fail "mvdb died"
+fi
+
 if [ -n "$REMOVE_TMP" ]; then
     rm -f "${TMP_PATH}/newSeqs.mapped" "${TMP_PATH}/mappingSeqs.reverse" "${TMP_PATH}/newMappingSeqs"
     rm -f "${TMP_PATH}/noHitSeqList" "${TMP_PATH}/mappingSeqs" "${TMP_PATH}/newSeqs" "${TMP_PATH}/removedSeqs"
@@ -256,8 +306,14 @@ if [ -n "$REMOVE_TMP" ]; then
     # shellcheck disable=SC2086
     "$MMSEQS" rmdb "${TMP_PATH}/OLDDB.repSeq" ${VERBOSITY}
     # shellcheck disable=SC2086
+    "$MMSEQS" rmdb "${TMP_PATH}/newClusters.repSeq" ${VERBOSITY}
+    # shellcheck disable=SC2086
+    "$MMSEQS" rmdb "${TMP_PATH}/newClusters.repSeq_h" ${VERBOSITY}
+    # shellcheck disable=SC2086
+    "$MMSEQS" rmdb "${TMP_PATH}/NEWREP" ${VERBOSITY}
+    # shellcheck disable=SC2086
     "$MMSEQS" rmdb "${TMP_PATH}/updatedClust" ${VERBOSITY}
 
-    rm -rf "${TMP_PATH}/search" "${TMP_PATH}/cluster"
+    rm -rf "${TMP_PATH}/search" "${TMP_PATH}/cluster" "${TMP_PATH}/index"
     rm -f "${TMP_PATH}/update_clustering.sh"
 fi
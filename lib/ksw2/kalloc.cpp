@@ -0,0 +1,126 @@
+#include "kalloc.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// 16 bytes keep the blocks aligned like malloc does
+struct km_header_t {
+	size_t size;
+	size_t heap; // 1 if the block did not fit into the buffer and was malloc'ed
+};
+
+struct kmem_t {
+	char *buf;
+	size_t cap;
+	size_t used;
+	size_t live;
+	size_t peak; // bytes requested since the last rewind, buffer size needed to serve them all
+};
+
+static size_t km_round(size_t size) {
+	return (size + sizeof(km_header_t) - 1) / sizeof(km_header_t) * sizeof(km_header_t);
+}
+
+void *km_init(void) {
+	return calloc(1, sizeof(kmem_t));
+}
+
+void km_destroy(void *_km) {
+	kmem_t *km = (kmem_t*)_km;
+	if (km == NULL) {
+		return;
+	}
+	free(km->buf);
+	free(km);
+}
+
+void *kmalloc(void *_km, size_t size) {
+	kmem_t *km = (kmem_t*)_km;
+	if (km == NULL) {
+		return malloc(size);
+	}
+	const size_t need = sizeof(km_header_t) + km_round(size);
+	km_header_t *h;
+	if (km->used + need <= km->cap) {
+		h = (km_header_t*)(km->buf + km->used);
+		h->heap = 0;
+		km->used += need;
+	} else {
+		h = (km_header_t*)malloc(need);
+		if (h == NULL) {
+			return NULL;
+		}
+		h->heap = 1;
+	}
+	h->size = size;
+	km->live++;
+	km->peak += need;
+	return h + 1;
+}
+
+void *kcalloc(void *km, size_t count, size_t size) {
+	void *ptr = kmalloc(km, count * size);
+	if (ptr != NULL) {
+		memset(ptr, 0, count * size);
+	}
+	return ptr;
+}
+
+void *krealloc(void *_km, void *ptr, size_t size) {
+	kmem_t *km = (kmem_t*)_km;
+	if (km == NULL) {
+		return realloc(ptr, size);
+	}
+	if (ptr == NULL) {
+		return kmalloc(km, size);
+	}
+	km_header_t *h = (km_header_t*)ptr - 1;
+	// the last block of the buffer can grow in place
+	const size_t oldNeed = sizeof(km_header_t) + km_round(h->size);
+	const size_t newNeed = sizeof(km_header_t) + km_round(size);
+	if (h->heap == 0 && (char*)h + oldNeed == km->buf + km->used
+		&& km->used - oldNeed + newNeed <= km->cap) {
+		km->used = km->used - oldNeed + newNeed;
+		if (newNeed > oldNeed) {
+			km->peak += newNeed - oldNeed;
+		}
+		h->size = size;
+		return ptr;
+	}
+	void *newPtr = kmalloc(km, size);
+	if (newPtr == NULL) {
+		return NULL;
+	}
+	memcpy(newPtr, ptr, h->size < size ? h->size : size);
+	kfree(km, ptr);
+	return newPtr;
+}
+
+void kfree(void *_km, void *ptr) {
+	kmem_t *km = (kmem_t*)_km;
+	if (km == NULL) {
+		free(ptr);
+		return;
+	}
+	if (ptr == NULL) {
+		return;
+	}
+	km_header_t *h = (km_header_t*)ptr - 1;
+	if (h->heap) {
+		free(h);
+	}
+	km->live--;
+	if (km->live == 0) {
+		// everything is released: rewind and make room for the whole working set
+		if (km->peak > km->cap) {
+			free(km->buf);
+			km->cap = km->peak + km->peak / 4;
+			km->buf = (char*)malloc(km->cap);
+			if (km->buf == NULL) {
+				km->cap = 0;
+			}
+		}
+		km->used = 0;
+		km->peak = 0;
+	}
+}
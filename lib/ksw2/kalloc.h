@@ -0,0 +1,27 @@
+#ifndef KALLOC_H
+#define KALLOC_H
+
+// Arena allocator behind the kmalloc/kfree interface that ksw2 expects when built with HAVE_KALLOC.
+// Allocations are carved from one buffer that is rewound once every block has been freed again.
+// The buffer grows to the high-water mark, so repeated alignments with one arena stop calling malloc.
+// A NULL arena falls back to the libc allocator.
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void *km_init(void);
+void km_destroy(void *km);
+
+void *kmalloc(void *km, size_t size);
+void *kcalloc(void *km, size_t count, size_t size);
+void *krealloc(void *km, void *ptr, size_t size);
+void kfree(void *km, void *ptr);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
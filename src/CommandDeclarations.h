@@ -37,6 +37,8 @@ extern int mvdb(int argc, const char **argv, const Command& command);
 extern int cpdb(int argc, const char **argv, const Command& command);
 extern int lndb(int argc, const char **argv, const Command& command);
 extern int aliasdb(int argc, const char **argv, const Command& command);
+extern int appenddb(int argc, const char **argv, const Command& command);
+extern int compactdb(int argc, const char **argv, const Command& command);
 extern int createtsv(int argc, const char **argv, const Command& command);
 extern int databases(int argc, const char **argv, const Command& command);
 extern int dbtype(int argc, const char **argv, const Command& command);
@@ -92,6 +94,7 @@ extern int orftocontig(int argc, const char **argv, const Command& command);
 extern int touchdb(int argc, const char **argv, const Command& command);
 extern int pickconsensusrep(int argc, const char **argv, const Command& command);
 extern int prefilter(int argc, const char **argv, const Command& command);
+extern int prefilteralign(int argc, const char **argv, const Command& command);
 extern int prefixid(int argc, const char **argv, const Command& command);
 extern int profile2cs(int argc, const char **argv, const Command& command);
 extern int profile2pssm(int argc, const char **argv, const Command& command);
@@ -135,6 +138,7 @@ extern int createtaxdb(int argc, const char **argv, const Command& command);
 extern int createbintaxonomy(int argc, const char **argv, const Command& command);
 extern int createdmptaxonomy(int argc, const char **argv, const Command& command);
 extern int createbintaxmapping(int argc, const char **argv, const Command& command);
+extern int createtaxmapping(int argc, const char **argv, const Command& command);
 extern int translateaa(int argc, const char **argv, const Command& command);
 extern int translatenucs(int argc, const char **argv, const Command& command);
 extern int tsv2db(int argc, const char **argv, const Command& command);
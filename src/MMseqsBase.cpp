@@ -437,6 +437,14 @@ std::vector<Command> baseCommands = {
                 "<i:taxonomyMapping> <o:taxonomyMapping>",
                 CITATION_TAXONOMY, {{"taxonomyMapping", DbType::ACCESS_MODE_INPUT, DbType::NEED_DATA, &DbValidator::flatfile  },
                                            {"taxonomyMapping", DbType::ACCESS_MODE_OUTPUT, DbType::NEED_DATA, &DbValidator::flatfile  }}},
+        {"createtaxmapping",     createtaxmapping,     &par.createtaxmapping,     COMMAND_TAXONOMY | COMMAND_EXPERT,
+                "Create binary taxonomy mapping from accession2taxid files",
+                NULL,
+                "Milot Mirdita <milot@mirdita.de>",
+                "<i:accession2taxid1> ... <i:accession2taxidN> <i:sequenceDB> <o:taxonomyMapping>",
+                CITATION_TAXONOMY, {{"accession2taxid", DbType::ACCESS_MODE_INPUT, DbType::NEED_DATA|DbType::VARIADIC, &DbValidator::flatfile },
+                                    {"sequenceDB", DbType::ACCESS_MODE_INPUT, DbType::NEED_DATA, &DbValidator::sequenceDb },
+                                    {"taxonomyMapping", DbType::ACCESS_MODE_OUTPUT, DbType::NEED_DATA, &DbValidator::flatfile }}},
         {"addtaxonomy",          addtaxonomy,          &par.addtaxonomy,          COMMAND_TAXONOMY | COMMAND_EXPERT,
                 "Add taxonomic labels to result DB",
                 NULL,
@@ -523,7 +531,7 @@ std::vector<Command> baseCommands = {
                                                            {"taxResPerSeqDB",   DbType::ACCESS_MODE_INPUT, DbType::NEED_DATA, &DbValidator::taxResult },
                                                            {"taxAlnResPerSeqDB",   DbType::ACCESS_MODE_INPUT, DbType::NEED_DATA, &DbValidator::resultDb },
                                                            {"taxResPerSetDB",   DbType::ACCESS_MODE_OUTPUT, DbType::NEED_DATA, &DbValidator::taxResult }}},
-        {"lcaalign",             lcaalign,             &par.align,                COMMAND_TAXONOMY,
+        {"lcaalign",             lcaalign,             &par.lcaalign,                COMMAND_TAXONOMY,
                 "Efficient gapped alignment for lca computation",
                 NULL,
                 "Milot Mirdita <milot@mirdita.de>",
@@ -614,6 +622,15 @@ std::vector<Command> baseCommands = {
                                                            {"targetDB", DbType::ACCESS_MODE_INPUT, DbType::NEED_DATA, &DbValidator::sequenceDb },
                                                            {"prefilterDB", DbType::ACCESS_MODE_OUTPUT, DbType::NEED_DATA, &DbValidator::prefilterDb }}},
 
+        {"prefilteralign",       prefilteralign,       &par.prefilteralign,       COMMAND_HIDDEN,
+                "Double consecutive diagonal k-mer search followed by gapped local alignment without a prefilter DB",
+                NULL,
+                "Martin Steinegger <martin.steinegger@snu.ac.kr> & Maria Hauser",
+                "<i:queryDB> <i:targetDB> <o:alignmentDB>",
+                CITATION_MMSEQS2, {{"queryDB", DbType::ACCESS_MODE_INPUT, DbType::NEED_DATA, &DbValidator::sequenceDb },
+                                                           {"targetDB", DbType::ACCESS_MODE_INPUT, DbType::NEED_DATA, &DbValidator::sequenceDb },
+                                                           {"alignmentDB", DbType::ACCESS_MODE_OUTPUT, DbType::NEED_DATA, &DbValidator::alignmentDb }}},
+
         {"ungappedprefilter",    ungappedprefilter,    &par.ungappedprefilter,    COMMAND_PREFILTER,
                 "Optimal diagonal score search",
                 NULL,
@@ -794,6 +811,24 @@ std::vector<Command> baseCommands = {
                 "<i:srcDB> <o:dstDB>",
                 CITATION_MMSEQS2, {{"DB", DbType::ACCESS_MODE_INPUT, DbType::NEED_DATA, NULL },
                                           {"DB", DbType::ACCESS_MODE_OUTPUT, DbType::NEED_DATA, &DbValidator::allDb }}},
+        {"appenddb",             appenddb,             &par.onlyverbosity,        COMMAND_STORAGE,
+                "Append a DB as new data segments to another DB",
+                "# Only the data of appendDB is copied, existing data files are not rewritten\n"
+                "# Keys of appendDB must not already exist in DB\n"
+                "# If both DB_h and appendDB_h exist, the headers of the appended entries are appended too\n"
+                "mmseqs appenddb DB appendDB\n\n"
+                "# Merge all segments into one data file\n"
+                "mmseqs compactdb DB\n",
+                "Milot Mirdita <milot@mirdita.de>",
+                "<i:DB> <i:appendDB>",
+                CITATION_MMSEQS2, {{"DB", DbType::ACCESS_MODE_INPUT, DbType::NEED_DATA, &DbValidator::allDb },
+                                          {"DB", DbType::ACCESS_MODE_INPUT, DbType::NEED_DATA, &DbValidator::allDb }}},
+        {"compactdb",            compactdb,            &par.onlyverbosity,        COMMAND_STORAGE,
+                "Merge the data segments of a DB into one data file",
+                NULL,
+                "Milot Mirdita <milot@mirdita.de>",
+                "<i:DB>",
+                CITATION_MMSEQS2, {{"DB", DbType::ACCESS_MODE_INPUT, DbType::NEED_DATA, &DbValidator::allDb }}},
         {"unpackdb",             unpackdb,             &par.unpackdbs,        COMMAND_STORAGE,
                 "Unpack a DB into separate files",
                 NULL,
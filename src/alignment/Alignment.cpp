@@ -1,4 +1,5 @@
 #include "Alignment.h"
+#include "AlignmentLcaHook.h"
 #include "Util.h"
 #include "Debug.h"
 #include "Matcher.h"
@@ -25,7 +26,7 @@ Alignment::Alignment(const std::string &querySeqDB, const std::string &targetSeq
         threads(static_cast<unsigned int>(par.threads)), compressed(par.compressed), outDB(outDB), outDBIndex(outDBIndex),
         maxSeqLen(par.maxSeqLen), compBiasCorrection(par.compBiasCorrection), compBiasCorrectionScale(par.compBiasCorrectionScale), altAlignment(par.altAlignment), alignmentOutputMode(par.alignmentOutputMode),
         maxAccept(static_cast<unsigned int>(par.maxAccept)), maxReject(static_cast<unsigned int>(par.maxRejected)), wrappedScoring(par.wrappedScoring),
-        lcaAlign(lcaAlign), qdbr(NULL), qDbrIdx(NULL), tdbr(NULL), tDbrIdx(NULL) {
+        lcaAlign(lcaAlign), lcaHook(NULL), qdbr(NULL), qDbrIdx(NULL), tdbr(NULL), tDbrIdx(NULL) {
     unsigned int alignmentMode = par.alignmentMode;
     if (alignmentMode == Parameters::ALIGNMENT_MODE_UNGAPPED) {
         Debug(Debug::ERROR) << "Use rescorediagonal for ungapped alignment mode.\n";
@@ -42,6 +43,9 @@ Alignment::Alignment(const std::string &querySeqDB, const std::string &targetSeq
         realignScoreBias = 0.0f;
         realignMaxSeqs = 1;
         addBacktrace = false;
+        if (par.lcaEarlyExit) {
+            lcaHook = new AlignmentLcaHook(targetSeqDB, par.blacklist);
+        }
     }
 
     if (realign == true) {
@@ -55,7 +59,8 @@ Alignment::Alignment(const std::string &querySeqDB, const std::string &targetSeq
         }
     }
 
-    uint16_t extended = DBReader<unsigned int>::getExtendedDbtype(FileUtil::parseDbType(prefDB.c_str()));
+    // without a prefilter DB the hits are handed over by the caller, e.g. the fused prefilter
+    uint16_t extended = prefDB.empty() ? 0 : DBReader<unsigned int>::getExtendedDbtype(FileUtil::parseDbType(prefDB.c_str()));
     bool touch = (par.preloadMode != Parameters::PRELOAD_MODE_MMAP);
     tDbrIdx = new IndexReader(targetSeqDB, par.threads,
                               extended & Parameters::DBTYPE_EXTENDED_INDEX_NEED_SRC ? IndexReader::SRC_SEQUENCES : IndexReader::SEQUENCES,
@@ -136,9 +141,13 @@ Alignment::Alignment(const std::string &querySeqDB, const std::string &targetSeq
     Debug(Debug::INFO) << "Query database size: "  << qdbr->getSize() << " type: " << Parameters::getDbTypeName(querySeqType) << "\n";
     Debug(Debug::INFO) << "Target database size: " << tdbr->getSize() << " type: " << Parameters::getDbTypeName(targetSeqType) << "\n";
 
-    prefdbr = new DBReader<unsigned int>(prefDB.c_str(), prefDBIndex.c_str(), threads, DBReader<unsigned int>::USE_DATA|DBReader<unsigned int>::USE_INDEX);
-    prefdbr->open(DBReader<unsigned int>::LINEAR_ACCCESS);
-    reversePrefilterResult = Parameters::isEqualDbtype(prefdbr->getDbtype(), Parameters::DBTYPE_PREFILTER_REV_RES);
+    prefdbr = NULL;
+    reversePrefilterResult = false;
+    if (prefDB.empty() == false) {
+        prefdbr = new DBReader<unsigned int>(prefDB.c_str(), prefDBIndex.c_str(), threads, DBReader<unsigned int>::USE_DATA|DBReader<unsigned int>::USE_INDEX);
+        prefdbr->open(DBReader<unsigned int>::LINEAR_ACCCESS);
+        reversePrefilterResult = Parameters::isEqualDbtype(prefdbr->getDbtype(), Parameters::DBTYPE_PREFILTER_REV_RES);
+    }
 
     correlationScoreWeight = par.correlationScoreWeight;
     if (Parameters::isEqualDbtype(querySeqType, Parameters::DBTYPE_NUCLEOTIDES)) {
@@ -191,6 +200,9 @@ unsigned int Alignment::initSWMode(unsigned int alignmentMode, float covThr, flo
 }
 
 Alignment::~Alignment() {
+    if (lcaHook != NULL) {
+        delete lcaHook;
+    }
     if (realign_m != NULL) {
         delete realign_m;
     }
@@ -212,8 +224,10 @@ Alignment::~Alignment() {
         }
     }
 
-    prefdbr->close();
-    delete prefdbr;
+    if (prefdbr != NULL) {
+        prefdbr->close();
+        delete prefdbr;
+    }
 }
 
 void Alignment::run(const unsigned int mpiRank, const unsigned int mpiNumProc) {
@@ -245,13 +259,51 @@ void Alignment::run() {
     run(outDB, outDBIndex, 0, prefdbr->getSize(), false);
 }
 
-void Alignment::run(const std::string &outDB, const std::string &outDBIndex, const size_t dbFrom, const size_t dbSize, bool merge) {
+Alignment::ThreadData::ThreadData(const Alignment &aln, EvalueComputation *evaluer) :
+        qSeq(aln.maxSeqLen, aln.querySeqType, aln.m, 0, false, aln.compBiasCorrection),
+        dbSeq(aln.maxSeqLen, aln.targetSeqType, aln.m, 0, false, aln.compBiasCorrection),
+        matcher(aln.querySeqType,
+                Parameters::isEqualDbtype(aln.querySeqType, Parameters::DBTYPE_NUCLEOTIDES)
+                    ? aln.maxSeqLen : std::max(aln.tdbr->getMaxSeqLen(), aln.qdbr->getMaxSeqLen()),
+                aln.m, evaluer, aln.compBiasCorrection, aln.compBiasCorrectionScale, aln.gapOpen, aln.gapExtend,
+                aln.correlationScoreWeight, aln.zdrop),
+        realigner(NULL), alignmentsNum(0), passedNum(0), lcaExitedQueries(0), lcaSkippedHits(0) {
+    swResults.reserve(300);
+    queryToWrap.reserve(aln.maxSeqLen * 2);
+    if (aln.realign == true) {
+        swRealignResults.reserve(300);
+        realigner = &matcher;
+        if (aln.realign_m != NULL) {
+            const size_t maxMatcherSeqLen = Parameters::isEqualDbtype(aln.querySeqType, Parameters::DBTYPE_NUCLEOTIDES)
+                                            ? aln.maxSeqLen : std::max(aln.tdbr->getMaxSeqLen(), aln.qdbr->getMaxSeqLen());
+            realigner = new Matcher(aln.querySeqType, maxMatcherSeqLen, aln.realign_m, evaluer, aln.compBiasCorrection, aln.compBiasCorrectionScale, aln.gapOpen, aln.gapExtend, 0.0, aln.zdrop);
+        }
+    }
+}
+
+Alignment::ThreadData::~ThreadData() {
+    if (realigner != NULL && realigner != &matcher) {
+        delete realigner;
+    }
+}
+
+EvalueComputation *Alignment::createEvalueComputation() {
+    return new EvalueComputation(tdbr->getAminoAcidDBSize(), this->m, gapOpen, gapExtend);
+}
+
+int Alignment::getOutputDbType() {
     int dbtype = Parameters::DBTYPE_ALIGNMENT_RES;
     if (alignmentOutputMode == Parameters::ALIGNMENT_OUTPUT_CLUSTER) {
         dbtype = Parameters::DBTYPE_CLUSTER_RES;
     }
-    dbtype = DBReader<unsigned int>::setExtendedDbtype(dbtype, DBReader<unsigned int>::getExtendedDbtype(prefdbr->getDbtype()));
-    DBWriter dbw(outDB.c_str(), outDBIndex.c_str(), threads, compressed, dbtype);
+    if (prefdbr != NULL) {
+        dbtype = DBReader<unsigned int>::setExtendedDbtype(dbtype, DBReader<unsigned int>::getExtendedDbtype(prefdbr->getDbtype()));
+    }
+    return dbtype;
+}
+
+void Alignment::run(const std::string &outDB, const std::string &outDBIndex, const size_t dbFrom, const size_t dbSize, bool merge) {
+    DBWriter dbw(outDB.c_str(), outDBIndex.c_str(), threads, compressed, getOutputDbType());
     dbw.open();
 
     // handle no alignment case early, below would divide by 0 otherwise
@@ -260,7 +312,7 @@ void Alignment::run(const std::string &outDB, const std::string &outDBIndex, con
         return;
     }
 
-    EvalueComputation evaluer(tdbr->getAminoAcidDBSize(), this->m, gapOpen, gapExtend);
+    EvalueComputation *evaluer = createEvalueComputation();
 
     size_t totalMemory = Util::getTotalSystemMemory();
     size_t flushSize = 1000000;
@@ -271,6 +323,8 @@ void Alignment::run(const std::string &outDB, const std::string &outDBIndex, con
 
     size_t alignmentsNum = 0;
     size_t totalPassedNum = 0;
+    size_t lcaExitedQueries = 0;
+    size_t lcaSkippedHits = 0;
     for (size_t i = 0; i < iterations; i++) {
         size_t start = dbFrom + (i * flushSize);
         size_t bucketSize = std::min(dbSize - (i * flushSize), flushSize);
@@ -284,237 +338,27 @@ void Alignment::run(const std::string &outDB, const std::string &outDBIndex, con
 #endif
             std::string alnResultsOutString;
             alnResultsOutString.reserve(1024*1024);
-            char buffer[1024 + 32768*4];
-            Sequence qSeq(maxSeqLen, querySeqType, m, 0, false, compBiasCorrection);
-            Sequence dbSeq(maxSeqLen, targetSeqType, m, 0, false, compBiasCorrection);
-            const size_t maxMatcherSeqLen = Parameters::isEqualDbtype(querySeqType, Parameters::DBTYPE_NUCLEOTIDES)
-                                            ? maxSeqLen : std::max(tdbr->getMaxSeqLen(), qdbr->getMaxSeqLen());
-
-            std::vector<Matcher::result_t> swResults;
-            swResults.reserve(300);
-            Matcher matcher(querySeqType, maxMatcherSeqLen, m, &evaluer, compBiasCorrection, compBiasCorrectionScale, gapOpen, gapExtend, correlationScoreWeight, zdrop);
-
-            std::vector<Matcher::result_t> swRealignResults;
-            Matcher *realigner = NULL;
-            if (realign == true) {
-                swRealignResults.reserve(300);
-                realigner = &matcher;
-                if (realign_m != NULL) {
-                    realigner = new Matcher(querySeqType, maxMatcherSeqLen, realign_m, &evaluer, compBiasCorrection, compBiasCorrectionScale, gapOpen, gapExtend, 0.0, zdrop);
-                }
-            }
-
-            std::string queryToWrap;
-            queryToWrap.reserve(maxSeqLen * 2);
+            ThreadData td(*this, evaluer);
 
-            const char* words[10];
-
-#pragma omp for schedule(dynamic, 5) reduction(+: alignmentsNum, totalPassedNum)
+#pragma omp for schedule(dynamic, 5)
             for (size_t id = start; id < (start + bucketSize); id++) {
                 progress.updateProgress();
 
                 // get the prefiltering list
-                char *data, *origData;
-                data = origData = prefdbr->getData(id, thread_idx);
+                char *data = prefdbr->getData(id, thread_idx);
                 unsigned int queryDbKey = prefdbr->getDbKey(id);
-                size_t origQueryLen = 0;
-                // only load query data if data != \0
-                if (*data != '\0') {
-                    size_t qId = qdbr->getId(queryDbKey);
-                    char *querySeqData = qdbr->getData(qId, thread_idx);
-                    if (querySeqData == NULL) {
-                        Debug(Debug::ERROR) << "Query sequence " << queryDbKey
-                                            << " is required in the prefiltering, but is not contained in the query sequence database.\nPlease check your database.\n";
-                        EXIT(EXIT_FAILURE);
-                    }
-                    size_t queryLen = qdbr->getSeqLen(qId);
-                    origQueryLen = queryLen;
-                    if (wrappedScoring) {
-                        queryToWrap = std::string(querySeqData, queryLen);
-                        queryToWrap = queryToWrap + queryToWrap;
-                        querySeqData = (char*)(queryToWrap).c_str();
-                        queryLen = origQueryLen*2;
-                    }
-
-                    qSeq.mapSequence(qId, queryDbKey, querySeqData, queryLen);
-                    matcher.initQuery(&qSeq);
-                }
-
-                // parse the prefiltering list and calculate a Smith-Waterman alignment for each sequence in the list
-                size_t passedNum = 0;
-                unsigned int rejected = 0;
-                while (*data != '\0' && passedNum < maxAccept && rejected < maxReject) {
-                    Util::parseKey(data, buffer);
-                    const unsigned int dbKey = (unsigned int) strtoul(buffer, NULL, 10);
-                    size_t elements = Util::getWordsOfLine(data, words, 10);
-
-                    short diagonal = 0;
-                    bool isReverse = false;
-                    // Prefilter result (need to make this better)
-                    if (elements == 3) {
-                        hit_t hit = QueryMatcher::parsePrefilterHit(data);
-                        isReverse = reversePrefilterResult && (hit.prefScore < 0);
-                        diagonal = static_cast<short>(hit.diagonal);
-                    }
-                    data = Util::skipLine(data);
-
-                    size_t dbId = tdbr->getId(dbKey);
-                    char *dbSeqData = tdbr->getData(dbId, thread_idx);
-                    if (dbSeqData == NULL) {
-                        Debug(Debug::ERROR) << "Sequence " << dbKey << " is required in the prefiltering, but is not contained in the target sequence database!\nPlease check your database.\n";
-                        EXIT(EXIT_FAILURE);
-                    }
-                    dbSeq.mapSequence(dbId, dbKey, dbSeqData, tdbr->getSeqLen(dbId));
-
-                    // check if the sequences could pass the coverage threshold
-                    if (Util::canBeCovered(canCovThr, covMode, static_cast<float>(origQueryLen), static_cast<float>(dbSeq.L)) == false) {
-                        rejected++;
-                        continue;
-                    }
-
-                    const bool isIdentity = (queryDbKey == dbKey && (includeIdentity || sameQTDB)) ? true : false;
-
-                    // calculate Smith-Waterman alignment
-
-                    Matcher::result_t res = matcher.getSWResult(&dbSeq, static_cast<int>(diagonal), isReverse, covMode, covThr, evalThr, swMode, seqIdMode, isIdentity, wrappedScoring);
-                    alignmentsNum++;
-
-                    if (isIdentity) {
-                        // set coverage and seqid of identity
-                        res.qcov = 1.0f;
-                        res.dbcov = 1.0f;
-                        res.seqId = 1.0f;
-                    }
-
-                    if (checkCriteria(res, isIdentity, evalThr, seqIdThr, alnLenThr, covMode, covThr)) {
-                        swResults.emplace_back(res);
-                        passedNum++;
-                        totalPassedNum++;
-                        rejected = 0;
-                    } else {
-                        rejected++;
-                    }
-                }
-
-                if (altAlignment > 0 && realign == false && wrappedScoring == false) {
-                    computeAlternativeAlignment(queryDbKey, dbSeq, swResults, matcher, covThr, evalThr, swMode, thread_idx);
-                }
-
-                if (swResults.size() > 1) {
-                    SORT_SERIAL(swResults.begin(), swResults.end(), Matcher::compareHits);
-                }
-
-                std::vector<Matcher::result_t> *returnRes = &swResults;
-                if (realign == true && *origData != '\0') {
-                    realigner->initQuery(&qSeq);
-                    int realignAccepted = 0;
-                    for (size_t result = 0; result < swResults.size() && realignAccepted < realignMaxSeqs; result++) {
-                        size_t dbId = tdbr->getId(swResults[result].dbKey);
-                        char *dbSeqData = tdbr->getData(dbId, thread_idx);
-                        if (dbSeqData == NULL) {
-                            Debug(Debug::ERROR) << "Sequence " << swResults[result].dbKey <<" is required in the prefiltering, but is not contained in the target sequence database!\nPlease check your database.\n";
-                            EXIT(EXIT_FAILURE);
-                        }
-                        dbSeq.mapSequence(dbId, swResults[result].dbKey, dbSeqData, tdbr->getSeqLen(dbId));
-
-                        // recompute alignment boundaries (without changing evalue)
-                        const bool isIdentity = (queryDbKey == swResults[result].dbKey && (includeIdentity || sameQTDB)) ? true : false;
-                        Matcher::result_t res = realigner->getSWResult(&dbSeq, INT_MAX, false, covMode, realignCov, FLT_MAX, realignSwMode, seqIdMode, isIdentity);
-
-                        const bool covOK = Util::hasCoverage(realignCov, covMode, res.qcov, res.dbcov);
-                        if (covOK == true || isIdentity) {
-                            res.score = swResults[result].score;
-                            res.eval  = swResults[result].eval;
-                            swRealignResults.emplace_back(res);
-                            realignAccepted++;
-                        }
-                    }
-
-                    if (altAlignment > 0) {
-                        computeAlternativeAlignment(queryDbKey, dbSeq, swRealignResults, *realigner, realignCov, FLT_MAX, realignSwMode, thread_idx);
-                    }
-
-                    if (swRealignResults.size() > 1) {
-                        SORT_SERIAL(swRealignResults.begin(), swRealignResults.end(), Matcher::compareHits);
-                    }
-
-                    returnRes = &swRealignResults;
-                }
-
-                if (lcaAlign == true && swRealignResults.size() > 0) {
-                    Matcher::result_t& topHit = swRealignResults[0];
-                    const unsigned int topHitKey = topHit.dbKey;
-                    size_t dbId = tdbr->getId(topHitKey);
-                    char *qSeqData = tdbr->getData(dbId, thread_idx);
-                    if (qSeqData == NULL) {
-                        Debug(Debug::ERROR) << "Sequence " << topHitKey << " is required in the prefiltering, but is not contained in the target sequence database!\nPlease check your database.\n";
-                        EXIT(EXIT_FAILURE);
-                    }
-                    qSeq.mapSequence(dbId, topHitKey, qSeqData + topHit.dbStartPos, topHit.dbEndPos - topHit.dbStartPos + 1);
-                    realigner->initQuery(&qSeq);
-
-                    const double topHitEval = topHit.eval;
-                    swRealignResults.clear();
-
-                    data = origData;
-                    unsigned int rejected = 0;
-                    while (*data != '\0' && rejected < maxReject) {
-                        Util::parseKey(data, buffer);
-                        const unsigned int dbKey = (unsigned int) strtoul(buffer, NULL, 10);
-//                        size_t elements = Util::getWordsOfLine(data, words, 10);
-//                        short diagonal = 0;
-//                        bool isReverse = false;
-//                        // Prefilter result (need to make this better)
-//                        if (elements == 3) {
-//                            hit_t hit = QueryMatcher::parsePrefilterHit(data);
-//                            isReverse = reversePrefilterResult && (hit.prefScore < 0);
-//                            diagonal = static_cast<short>(hit.diagonal);
-//                        }
-                        data = Util::skipLine(data);
-
-                        dbId = tdbr->getId(dbKey);
-                        char* dbSeqData = tdbr->getData(dbId, thread_idx);
-                        if (dbSeqData == NULL) {
-                            Debug(Debug::ERROR) << "Sequence " << dbKey << " is required in the prefiltering, but is not contained in the target sequence database!\nPlease check your database.\n";
-                            EXIT(EXIT_FAILURE);
-                        }
-                        dbSeq.mapSequence(dbId, dbKey, dbSeqData, tdbr->getSeqLen(dbId));
-
-                        Matcher::result_t res = realigner->getSWResult(&dbSeq, INT_MAX, false, covMode, realignCov, topHitEval, lcaSwMode, seqIdMode, false);
-
-                        if (checkCriteria(res, false, topHitEval, seqIdThr, alnLenThr, covMode, realignCov)) {
-                            swRealignResults.emplace_back(res);
-                            rejected = 0;
-                        } else {
-                            rejected++;
-                        }
-                    }
-
-                    if (swRealignResults.size() > 1) {
-                        SORT_SERIAL(swRealignResults.begin(), swRealignResults.end(), Matcher::compareHits);
-                    }
-
-                    returnRes = &swRealignResults;
-                }
-                if(alignmentOutputMode == Parameters::ALIGNMENT_OUTPUT_CLUSTER) {
-                    for (size_t result = 0; result < returnRes->size(); result++) {
-                        alnResultsOutString.append(SSTR((*returnRes)[result].dbKey));
-                        alnResultsOutString.push_back('\n');
-                    }
-                }else{
-                    for (size_t result = 0; result < returnRes->size(); result++) {
-                        size_t len = Matcher::resultToBuffer(buffer, (*returnRes)[result], addBacktrace);
-                        alnResultsOutString.append(buffer, len);
-                    }
-                }
+                alignQuery(td, queryDbKey, data, alnResultsOutString, thread_idx);
                 dbw.writeData(alnResultsOutString.c_str(), alnResultsOutString.length(), queryDbKey, thread_idx);
                 alnResultsOutString.clear();
-                swResults.clear();
-                swRealignResults.clear();
-            }
-            if (realigner != NULL && realigner != &matcher) {
-                delete realigner;
             }
+#pragma omp atomic
+            alignmentsNum += td.alignmentsNum;
+#pragma omp atomic
+            totalPassedNum += td.passedNum;
+#pragma omp atomic
+            lcaExitedQueries += td.lcaExitedQueries;
+#pragma omp atomic
+            lcaSkippedHits += td.lcaSkippedHits;
             // only remap if we have more than one iteration and we are not at the last iteration
             if (i != (iterations - 1)) {
 #pragma omp barrier
@@ -526,7 +370,19 @@ void Alignment::run(const std::string &outDB, const std::string &outDBIndex, con
         }
     }
     dbw.close(merge);
+    delete evaluer;
 
+    printStatistics(alignmentsNum, totalPassedNum, dbSize);
+    if (lcaHook != NULL) {
+        Debug(Debug::INFO) << lcaExitedQueries << " queries reached the root LCA early, " << lcaSkippedHits << " hits were not aligned";
+        if (lcaExitedQueries > 0) {
+            Debug(Debug::INFO) << " (" << ((float) lcaSkippedHits / (float) lcaExitedQueries) << " per query)";
+        }
+        Debug(Debug::INFO) << "\n";
+    }
+}
+
+void Alignment::printStatistics(size_t alignmentsNum, size_t totalPassedNum, size_t dbSize) {
     Debug(Debug::INFO) << alignmentsNum << " alignments calculated\n";
     Debug(Debug::INFO) << totalPassedNum << " sequence pairs passed the thresholds";
     if (alignmentsNum > 0) {
@@ -541,6 +397,219 @@ void Alignment::run(const std::string &outDB, const std::string &outDBIndex, con
     }
 }
 
+void Alignment::alignQuery(ThreadData &td, unsigned int queryDbKey, char *data, std::string &alnResultsOutString, unsigned int thread_idx) {
+    Sequence &qSeq = td.qSeq;
+    Sequence &dbSeq = td.dbSeq;
+    Matcher &matcher = td.matcher;
+    Matcher *realigner = td.realigner;
+    std::vector<Matcher::result_t> &swResults = td.swResults;
+    std::vector<Matcher::result_t> &swRealignResults = td.swRealignResults;
+    std::string &queryToWrap = td.queryToWrap;
+    char *buffer = td.buffer;
+    const char* words[10];
+
+    char *origData = data;
+    size_t origQueryLen = 0;
+    // only load query data if data != \0
+    if (*data != '\0') {
+        size_t qId = qdbr->getId(queryDbKey);
+        char *querySeqData = qdbr->getData(qId, thread_idx);
+        if (querySeqData == NULL) {
+            Debug(Debug::ERROR) << "Query sequence " << queryDbKey
+                                << " is required in the prefiltering, but is not contained in the query sequence database.\nPlease check your database.\n";
+            EXIT(EXIT_FAILURE);
+        }
+        size_t queryLen = qdbr->getSeqLen(qId);
+        origQueryLen = queryLen;
+        if (wrappedScoring) {
+            queryToWrap = std::string(querySeqData, queryLen);
+            queryToWrap = queryToWrap + queryToWrap;
+            querySeqData = (char*)(queryToWrap).c_str();
+            queryLen = origQueryLen*2;
+        }
+
+        qSeq.mapSequence(qId, queryDbKey, querySeqData, queryLen);
+        matcher.initQuery(&qSeq);
+    }
+
+    // parse the prefiltering list and calculate a Smith-Waterman alignment for each sequence in the list
+    size_t passedNum = 0;
+    unsigned int rejected = 0;
+    while (*data != '\0' && passedNum < maxAccept && rejected < maxReject) {
+        Util::parseKey(data, buffer);
+        const unsigned int dbKey = (unsigned int) strtoul(buffer, NULL, 10);
+        size_t elements = Util::getWordsOfLine(data, words, 10);
+
+        short diagonal = 0;
+        bool isReverse = false;
+        // Prefilter result (need to make this better)
+        if (elements == 3) {
+            hit_t hit = QueryMatcher::parsePrefilterHit(data);
+            isReverse = reversePrefilterResult && (hit.prefScore < 0);
+            diagonal = static_cast<short>(hit.diagonal);
+        }
+        data = Util::skipLine(data);
+
+        size_t dbId = tdbr->getId(dbKey);
+        char *dbSeqData = tdbr->getData(dbId, thread_idx);
+        if (dbSeqData == NULL) {
+            Debug(Debug::ERROR) << "Sequence " << dbKey << " is required in the prefiltering, but is not contained in the target sequence database!\nPlease check your database.\n";
+            EXIT(EXIT_FAILURE);
+        }
+        dbSeq.mapSequence(dbId, dbKey, dbSeqData, tdbr->getSeqLen(dbId));
+
+        // check if the sequences could pass the coverage threshold
+        if (Util::canBeCovered(canCovThr, covMode, static_cast<float>(origQueryLen), static_cast<float>(dbSeq.L)) == false) {
+            rejected++;
+            continue;
+        }
+
+        const bool isIdentity = (queryDbKey == dbKey && (includeIdentity || sameQTDB)) ? true : false;
+
+        // calculate Smith-Waterman alignment
+
+        Matcher::result_t res = matcher.getSWResult(&dbSeq, static_cast<int>(diagonal), isReverse, covMode, covThr, evalThr, swMode, seqIdMode, isIdentity, wrappedScoring);
+        td.alignmentsNum++;
+
+        if (isIdentity) {
+            // set coverage and seqid of identity
+            res.qcov = 1.0f;
+            res.dbcov = 1.0f;
+            res.seqId = 1.0f;
+        }
+
+        if (checkCriteria(res, isIdentity, evalThr, seqIdThr, alnLenThr, covMode, covThr)) {
+            swResults.emplace_back(res);
+            passedNum++;
+            td.passedNum++;
+            rejected = 0;
+        } else {
+            rejected++;
+        }
+    }
+
+    if (altAlignment > 0 && realign == false && wrappedScoring == false) {
+        computeAlternativeAlignment(queryDbKey, dbSeq, swResults, matcher, covThr, evalThr, swMode, thread_idx);
+    }
+
+    if (swResults.size() > 1) {
+        SORT_SERIAL(swResults.begin(), swResults.end(), Matcher::compareHits);
+    }
+
+    std::vector<Matcher::result_t> *returnRes = &swResults;
+    if (realign == true && *origData != '\0') {
+        // without a separate realignment matrix the realigner is the matcher, which already holds the profile of qSeq
+        if (realigner != &matcher) {
+            realigner->initQuery(&qSeq);
+        }
+        int realignAccepted = 0;
+        for (size_t result = 0; result < swResults.size() && realignAccepted < realignMaxSeqs; result++) {
+            size_t dbId = tdbr->getId(swResults[result].dbKey);
+            char *dbSeqData = tdbr->getData(dbId, thread_idx);
+            if (dbSeqData == NULL) {
+                Debug(Debug::ERROR) << "Sequence " << swResults[result].dbKey <<" is required in the prefiltering, but is not contained in the target sequence database!\nPlease check your database.\n";
+                EXIT(EXIT_FAILURE);
+            }
+            dbSeq.mapSequence(dbId, swResults[result].dbKey, dbSeqData, tdbr->getSeqLen(dbId));
+
+            // recompute alignment boundaries (without changing evalue)
+            const bool isIdentity = (queryDbKey == swResults[result].dbKey && (includeIdentity || sameQTDB)) ? true : false;
+            Matcher::result_t res = realigner->getSWResult(&dbSeq, INT_MAX, false, covMode, realignCov, FLT_MAX, realignSwMode, seqIdMode, isIdentity);
+
+            const bool covOK = Util::hasCoverage(realignCov, covMode, res.qcov, res.dbcov);
+            if (covOK == true || isIdentity) {
+                res.score = swResults[result].score;
+                res.eval  = swResults[result].eval;
+                swRealignResults.emplace_back(res);
+                realignAccepted++;
+            }
+        }
+
+        if (altAlignment > 0) {
+            computeAlternativeAlignment(queryDbKey, dbSeq, swRealignResults, *realigner, realignCov, FLT_MAX, realignSwMode, thread_idx);
+        }
+
+        if (swRealignResults.size() > 1) {
+            SORT_SERIAL(swRealignResults.begin(), swRealignResults.end(), Matcher::compareHits);
+        }
+
+        returnRes = &swRealignResults;
+    }
+
+    if (lcaAlign == true && swRealignResults.size() > 0) {
+        Matcher::result_t& topHit = swRealignResults[0];
+        const unsigned int topHitKey = topHit.dbKey;
+        size_t dbId = tdbr->getId(topHitKey);
+        char *qSeqData = tdbr->getData(dbId, thread_idx);
+        if (qSeqData == NULL) {
+            Debug(Debug::ERROR) << "Sequence " << topHitKey << " is required in the prefiltering, but is not contained in the target sequence database!\nPlease check your database.\n";
+            EXIT(EXIT_FAILURE);
+        }
+        qSeq.mapSequence(dbId, topHitKey, qSeqData + topHit.dbStartPos, topHit.dbEndPos - topHit.dbStartPos + 1);
+        realigner->initQuery(&qSeq);
+
+        const double topHitEval = topHit.eval;
+        swRealignResults.clear();
+
+        data = origData;
+        unsigned int rejected = 0;
+        TaxID lca = 0;
+        while (*data != '\0' && rejected < maxReject) {
+            Util::parseKey(data, buffer);
+            const unsigned int dbKey = (unsigned int) strtoul(buffer, NULL, 10);
+            data = Util::skipLine(data);
+
+            dbId = tdbr->getId(dbKey);
+            char* dbSeqData = tdbr->getData(dbId, thread_idx);
+            if (dbSeqData == NULL) {
+                Debug(Debug::ERROR) << "Sequence " << dbKey << " is required in the prefiltering, but is not contained in the target sequence database!\nPlease check your database.\n";
+                EXIT(EXIT_FAILURE);
+            }
+            dbSeq.mapSequence(dbId, dbKey, dbSeqData, tdbr->getSeqLen(dbId));
+
+            Matcher::result_t res = realigner->getSWResult(&dbSeq, INT_MAX, false, covMode, realignCov, topHitEval, lcaSwMode, seqIdMode, false);
+
+            if (checkCriteria(res, false, topHitEval, seqIdThr, alnLenThr, covMode, realignCov)) {
+                swRealignResults.emplace_back(res);
+                rejected = 0;
+                if (lcaHook != NULL) {
+                    lca = lcaHook->addHit(lca, dbKey);
+                    if (lcaHook->isRoot(lca)) {
+                        // further hits cannot change the LCA anymore
+                        td.lcaExitedQueries++;
+                        while (*data != '\0') {
+                            data = Util::skipLine(data);
+                            td.lcaSkippedHits++;
+                        }
+                        break;
+                    }
+                }
+            } else {
+                rejected++;
+            }
+        }
+
+        if (swRealignResults.size() > 1) {
+            SORT_SERIAL(swRealignResults.begin(), swRealignResults.end(), Matcher::compareHits);
+        }
+
+        returnRes = &swRealignResults;
+    }
+    if(alignmentOutputMode == Parameters::ALIGNMENT_OUTPUT_CLUSTER) {
+        for (size_t result = 0; result < returnRes->size(); result++) {
+            alnResultsOutString.append(SSTR((*returnRes)[result].dbKey));
+            alnResultsOutString.push_back('\n');
+        }
+    }else{
+        for (size_t result = 0; result < returnRes->size(); result++) {
+            size_t len = Matcher::resultToBuffer(buffer, (*returnRes)[result], addBacktrace);
+            alnResultsOutString.append(buffer, len);
+        }
+    }
+    swResults.clear();
+    swRealignResults.clear();
+}
+
 size_t Alignment::estimateHDDMemoryConsumption(int dbSize, int maxSeqs) {
     return 2 * (dbSize * maxSeqs * 21 * 1.75);
 }
@@ -7,6 +7,8 @@
 #include "BaseMatrix.h"
 #include "Matcher.h"
 
+class AlignmentLcaHook;
+
 class Alignment {
 public:
     Alignment(const std::string &querySeqDB,
@@ -29,6 +31,35 @@ public:
 
     static unsigned int initSWMode(unsigned int alignmentMode, float covThr, float seqIdThr);
 
+    // state of one thread aligning the prefilter hits of one query at a time
+    struct ThreadData {
+        ThreadData(const Alignment &aln, EvalueComputation *evaluer);
+        ~ThreadData();
+
+        Sequence qSeq;
+        Sequence dbSeq;
+        Matcher matcher;
+        Matcher *realigner;
+        std::vector<Matcher::result_t> swResults;
+        std::vector<Matcher::result_t> swRealignResults;
+        std::string queryToWrap;
+        char buffer[1024 + 32768*4];
+        size_t alignmentsNum;
+        size_t passedNum;
+        // queries that stopped at a root LCA and their prefilter hits that were not aligned
+        size_t lcaExitedQueries;
+        size_t lcaSkippedHits;
+    };
+
+    EvalueComputation *createEvalueComputation();
+
+    // aligns the newline separated prefilter hits in data and appends the formatted results to out
+    void alignQuery(ThreadData &td, unsigned int queryDbKey, char *data, std::string &out, unsigned int thread_idx);
+
+    int getOutputDbType();
+
+    void printStatistics(size_t alignmentsNum, size_t totalPassedNum, size_t dbSize);
+
 private:
     // sequence coverage threshold
     double covThr;
@@ -106,6 +137,8 @@ private:
     int zdrop;
 
     bool lcaAlign;
+    // stops the LCA alignment of a query once its LCA is the root, NULL if disabled
+    AlignmentLcaHook *lcaHook;
 
     // needed for realignment
     BaseMatrix *realign_m;
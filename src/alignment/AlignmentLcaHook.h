@@ -0,0 +1,54 @@
+#ifndef ALIGNMENT_LCA_HOOK_H
+#define ALIGNMENT_LCA_HOOK_H
+
+#include "NcbiTaxonomy.h"
+#include "MappingReader.h"
+#include "QueryMatcherTaxonomyHook.h"
+
+// Follows the LCA of the hits accepted by lcaalign the same way the lca module computes it from the result.
+// Hits without a taxon, with a blocked taxon or with a taxon missing in the taxonomy do not change it.
+// The LCA can only move towards the root, once it reached the root further hits cannot change it.
+class AlignmentLcaHook {
+public:
+    AlignmentLcaHook(const std::string &targetPath, const std::string &blacklistString) {
+        std::string targetName = QueryMatcherTaxonomyHook::dbPathWithoutIndex(targetPath);
+        taxonomy = NcbiTaxonomy::openTaxonomy(targetName);
+        taxonomyMapping = new MappingReader(targetName);
+        blacklist = taxonomy->parseBlacklist(blacklistString);
+        // the root is the only node that is its own parent
+        rootTaxon = 0;
+        if (taxonomy->maxNodes > 0) {
+            const TaxonNode *node = &taxonomy->taxonNodes[0];
+            while (node->parentTaxId != node->taxId) {
+                node = taxonomy->taxonNode(node->parentTaxId);
+            }
+            rootTaxon = node->taxId;
+        }
+    }
+
+    ~AlignmentLcaHook() {
+        delete taxonomy;
+        delete taxonomyMapping;
+    }
+
+    // LCA of lca and the taxon of dbKey, 0 if no hit had a usable taxon yet
+    TaxID addHit(TaxID lca, unsigned int dbKey) {
+        TaxID taxon = taxonomyMapping->lookup(dbKey);
+        if (taxon == 0 || taxonomy->nodeExists(taxon) == false || taxonomy->isBlacklisted(blacklist, taxon)) {
+            return lca;
+        }
+        return taxonomy->LCA(lca, taxon);
+    }
+
+    bool isRoot(TaxID lca) const {
+        return lca == rootTaxon;
+    }
+
+private:
+    NcbiTaxonomy* taxonomy;
+    MappingReader* taxonomyMapping;
+    std::vector<TaxID> blacklist;
+    TaxID rootTaxon;
+};
+
+#endif
@@ -7,6 +7,7 @@
 #include "Parameters.h"
 #include "DistanceCalculator.h"
 #include "ksw2.h"
+#include "kalloc.h"
 #include "BandedNucleotideAligner.h"
 
 #include "Util.h"
@@ -35,6 +36,7 @@ BandedNucleotideAligner::BandedNucleotideAligner(BaseMatrix * subMat, size_t max
     this->gape = gape;
     this->gapo = gapo;
     this->zdrop = zdrop;
+    km = km_init();
 }
 
 BandedNucleotideAligner::~BandedNucleotideAligner(){
@@ -46,6 +48,7 @@ BandedNucleotideAligner::~BandedNucleotideAligner(){
     delete [] fastMatrix.matrixData;
     delete [] fastMatrix.matrix;
     delete [] mat;
+    km_destroy(km);
 }
 
 void BandedNucleotideAligner::initQuery(Sequence * query){
@@ -164,6 +167,7 @@ s_align BandedNucleotideAligner::align(Sequence * targetSeqObj,
     int tStartRev = (targetSeqObj->L - dbUngappedEndPos) - 1;
 
     ksw_extz_t ez;
+    memset(&ez, 0, sizeof(ksw_extz_t));
     int flag = 0;
     flag |= KSW_EZ_SCORE_ONLY;
     flag |= KSW_EZ_EXTZ_ONLY;
@@ -173,7 +177,7 @@ s_align BandedNucleotideAligner::align(Sequence * targetSeqObj,
         queryRevLenToAlign = origQueryLen;
     }
 
-    ksw_extz2_sse(0, queryRevLenToAlign, querySeqRevAlign + qStartRev, targetSeqObj->L - tStartRev, targetSeqRev + tStartRev, 5, mat, gapo, gape, 64, zdrop, flag, &ez);
+    ksw_extz2_sse(km, queryRevLenToAlign, querySeqRevAlign + qStartRev, targetSeqObj->L - tStartRev, targetSeqRev + tStartRev, 5, mat, gapo, gape, 64, zdrop, flag, &ez);
 
     int qStartPos = querySeqObj->L  - ( qStartRev + ez.max_q ) -1;
     int tStartPos = targetSeqObj->L - ( tStartRev + ez.max_t ) -1;
@@ -189,7 +193,7 @@ s_align BandedNucleotideAligner::align(Sequence * targetSeqObj,
     int queryLenToAlign = querySeqObj->L-qStartPos;
     if (wrappedScoring && queryLenToAlign > origQueryLen)
         queryLenToAlign = origQueryLen;
-    ksw_extz2_sse(0, queryLenToAlign, querySeqAlign+qStartPos, targetSeqObj->L-tStartPos, targetSeq+tStartPos, 5,
+    ksw_extz2_sse(km, queryLenToAlign, querySeqAlign+qStartPos, targetSeqObj->L-tStartPos, targetSeq+tStartPos, 5,
                   mat, gapo, gape, 64, zdrop, alignFlag, &ezAlign);
 
     std::string letterCode = "MID";
@@ -197,7 +201,7 @@ s_align BandedNucleotideAligner::align(Sequence * targetSeqObj,
 
     if (ez.max_q > ezAlign.max_q && ez.max_t > ezAlign.max_t){
 
-        ksw_extz2_sse(0, queryRevLenToAlign, querySeqRevAlign + qStartRev, targetSeqObj->L - tStartRev,
+        ksw_extz2_sse(km, queryRevLenToAlign, querySeqRevAlign + qStartRev, targetSeqObj->L - tStartRev,
                       targetSeqRev + tStartRev, 5, mat, gapo, gape, 64, zdrop, alignFlag, &ezAlign);
 
         retCigar = new uint32_t[ezAlign.n_cigar];
@@ -256,7 +260,7 @@ s_align BandedNucleotideAligner::align(Sequence * targetSeqObj,
         }
     }
     result.identicalAACnt = aaIds;
-    free(ezAlign.cigar);
+    kfree(km, ezAlign.cigar);
     return result;
 //        std::cout << static_cast<float>(aaIds)/ static_cast<float>(alignment.len) << std::endl;
 
@@ -43,4 +43,6 @@ private:
     int gapo;
     int gape;
     int zdrop;
+    // ksw2 memory arena, reused by all alignments of this aligner
+    void * km;
 };
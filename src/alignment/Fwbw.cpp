@@ -67,9 +67,16 @@ inline simd_float simdf32_prefixsum(simd_float a) {
 //     return simdf32_loadu(buf);
 }
 
+// grow buffers at least by half of their current capacity to amortize reallocations
+// over a stream of increasingly long pairs, rounded up to a multiple of the block length
+static inline size_t growCapacity(size_t newLen, size_t capacity, size_t length) {
+    size_t newCapacity = std::max(newLen, capacity + capacity / 2);
+    return ((newCapacity + length - 1) / length) * length;
+}
+
 // FwBwAligner Constructor for general case: use profile scoring matrix
 FwBwAligner::FwBwAligner(SubstitutionMatrix &subMat, float gapOpen, float gapExtend, float temperature, float mact, size_t rowsCapacity, size_t colsCapacity, size_t length, int backtrace)
-                : temperature(temperature), length(length), gapOpen(gapOpen), gapExtend(gapExtend), mact(mact), rowsCapacity(rowsCapacity), colsCapacity(colsCapacity) {    
+                : temperature(temperature), length(length), gapOpen(gapOpen), gapExtend(gapExtend), mact(mact), rowsCapacity(rowsCapacity), colsCapacity(colsCapacity), profileColsCapacity(colsCapacity) {
     blockCapacity = colsCapacity / length;
     // ZM
     zm = malloc_matrix<float>(rowsCapacity, colsCapacity);
@@ -119,7 +126,7 @@ FwBwAligner::FwBwAligner(SubstitutionMatrix &subMat, float gapOpen, float gapExt
 
 // FwBwAligner Constructor for user-defined scoring matrix
 FwBwAligner::FwBwAligner(float gapOpen, float gapExtend, float temperature, float mact, size_t rowsCapacity, size_t colsCapacity, size_t length, int backtrace)
-                    : temperature(temperature), length(length), gapOpen(gapOpen), gapExtend(gapExtend), mact(mact), rowsCapacity(rowsCapacity), colsCapacity(colsCapacity) {
+                    : temperature(temperature), length(length), gapOpen(gapOpen), gapExtend(gapExtend), mact(mact), rowsCapacity(rowsCapacity), colsCapacity(colsCapacity), profileColsCapacity(colsCapacity) {
     
     // scoreForward
     scoreForward = malloc_matrix<float>(rowsCapacity, colsCapacity);
@@ -205,7 +212,8 @@ FwBwAligner::~FwBwAligner(){
 }
 
 //Reallocatation or Resizing
-void FwBwAligner::reallocateProfile(size_t newColsCapacity) { // reallocate profile when colSeqLen(queryLen in general) exceeds colsCapacity
+void FwBwAligner::reallocateProfile(size_t newColsCapacity) { // reallocate profile when colSeqLen(queryLen in general) exceeds profileColsCapacity
+    profileColsCapacity = newColsCapacity;
     free(scoreForwardProfile); scoreForwardProfile = malloc_matrix<float>(21, newColsCapacity);
     free(scoreForwardProfile_exp); scoreForwardProfile_exp = malloc_matrix<float>(21, newColsCapacity);
     free(scoreBackwardProfile_exp); scoreBackwardProfile_exp = malloc_matrix<float>(21, newColsCapacity);
@@ -222,8 +230,8 @@ void FwBwAligner::resizeMatrix<true,true>(size_t newRowLen, size_t newColLen) {
     size_t newRowsCapacity;
     size_t newColsCapacity;
     if (resizeRows || resizeCols) { 
-        newRowsCapacity = resizeRows ? ((newRowLen + length - 1) / length) * length : rowsCapacity;
-        newColsCapacity = resizeCols ? ((newColLen + length - 1) / length) * length : colsCapacity;
+        newRowsCapacity = resizeRows ? growCapacity(newRowLen, rowsCapacity, length) : rowsCapacity;
+        newColsCapacity = resizeCols ? growCapacity(newColLen, colsCapacity, length) : colsCapacity;
     } else {
         return; // no need to resize
     }
@@ -252,8 +260,8 @@ void FwBwAligner::resizeMatrix<true,false>(size_t newRowLen, size_t newColLen) {
     size_t newRowsCapacity;
     size_t newColsCapacity;
     if (resizeRows || resizeCols) { 
-        newRowsCapacity = resizeRows ? ((newRowLen + length - 1) / length) * length : rowsCapacity;
-        newColsCapacity = resizeCols ? ((newColLen + length - 1) / length) * length : colsCapacity;
+        newRowsCapacity = resizeRows ? growCapacity(newRowLen, rowsCapacity, length) : rowsCapacity;
+        newColsCapacity = resizeCols ? growCapacity(newColLen, colsCapacity, length) : colsCapacity;
     } else {
         return; // no need to resize
     }
@@ -279,8 +287,8 @@ void FwBwAligner::resizeMatrix<false,true>(size_t newRowLen, size_t newColLen) {
     size_t newRowsCapacity;
     size_t newColsCapacity;
     if (resizeRows || resizeCols) { 
-        newRowsCapacity = resizeRows ? ((newRowLen + length - 1) / length) * length : rowsCapacity;
-        newColsCapacity = resizeCols ? ((newColLen + length - 1) / length) * length : colsCapacity;
+        newRowsCapacity = resizeRows ? growCapacity(newRowLen, rowsCapacity, length) : rowsCapacity;
+        newColsCapacity = resizeCols ? growCapacity(newColLen, colsCapacity, length) : colsCapacity;
     } else {
         return; // no need to resize
     }
@@ -312,8 +320,8 @@ void FwBwAligner::resizeMatrix<false,false>(size_t newRowLen, size_t newColLen)
     size_t newRowsCapacity;
     size_t newColsCapacity;
     if (resizeRows || resizeCols) { 
-        newRowsCapacity = resizeRows ? ((newRowLen + length - 1) / length) * length : rowsCapacity;
-        newColsCapacity = resizeCols ? ((newColLen + length - 1) / length) * length : colsCapacity;
+        newRowsCapacity = resizeRows ? growCapacity(newRowLen, rowsCapacity, length) : rowsCapacity;
+        newColsCapacity = resizeCols ? growCapacity(newColLen, colsCapacity, length) : colsCapacity;
     } else {
         return; // no need to resize
     }
@@ -384,9 +392,8 @@ void FwBwAligner::initProfile(unsigned char* colAANum, size_t colAALen) {
     colSeqAANum = colAANum; colSeqLen = colAALen;
     colSeqLen_padding = ((colSeqLen + VECSIZE_FLOAT -1) / VECSIZE_FLOAT) * VECSIZE_FLOAT;
     blocks = (colSeqLen / length) + (colSeqLen % length != 0);
-    if (colSeqLen > colsCapacity) {
-        size_t newColsCapacity = ((colSeqLen + length-1)/length)* length;
-        reallocateProfile(newColsCapacity);
+    if (colSeqLen > profileColsCapacity) {
+        reallocateProfile(growCapacity(colSeqLen, profileColsCapacity, length));
     }
     
     //scoreForward : 21 * qlen
@@ -1088,6 +1095,7 @@ int fwbw(int argc, const char **argv, const Command &command) {
     }
     SubstitutionMatrix subMat = SubstitutionMatrix(par.scoringMatrixFile.values.aminoacid().c_str(), 2.0, par.scoreBias); // Check : par.scoreBias = 0.0
     
+    const bool restrictToRegion = par.fwbwMargin >= 0;
     const size_t flushSize = 100000000;
     size_t iterations = static_cast<int>(ceil(static_cast<double>(alnRes.getSize()) / static_cast<double>(flushSize)));
     Debug(Debug::INFO) << "Processing " << iterations << " iterations\n";
@@ -1109,6 +1117,7 @@ int fwbw(int argc, const char **argv, const Command &command) {
             const size_t assignSeqLen = VECSIZE_FLOAT * sizeof(float) * 20; 
             FwBwAligner fwbwaligner(subMat, -par.fwbwGapopen, -par.fwbwGapextend, par.temperature, par.mact, assignSeqLen, assignSeqLen, length, true);
             char entrybuffer[1024 + 32768*4];
+            const char *words[255];
             std::string alnResultsOutString;
             char buffer[1024 + 32768*4];
             std::vector<Matcher::result_t> localFwbwResults;
@@ -1126,7 +1135,9 @@ int fwbw(int argc, const char **argv, const Command &command) {
                 size_t queryLen = qdbr.getSeqLen(queryId);
 
                 qSeq.mapSequence(queryId, key, querySeq, queryLen);
-                fwbwaligner.initProfile(qSeq.numSequence, queryLen);
+                if (restrictToRegion == false) {
+                    fwbwaligner.initProfile(qSeq.numSequence, queryLen);
+                }
                 fwbwAlnWriter.writeStart(thread_idx);
 
                 while (*alnData != '\0'){
@@ -1137,8 +1148,28 @@ int fwbw(int argc, const char **argv, const Command &command) {
                     size_t targetLen = tdbr.getSeqLen(targetId);
 
                     dbSeq.mapSequence(targetId, targetKey, targetSeq, targetLen);
+
+                    // restrict forward-backward to the SW alignment region plus margin
+                    // matrices then scale with the aligned region instead of queryLen x targetLen
+                    size_t qOffset = 0;
+                    size_t dbOffset = 0;
+                    size_t qRegionLen = queryLen;
+                    size_t dbRegionLen = targetLen;
+                    if (restrictToRegion) {
+                        if (Util::getWordsOfLine(alnData, words, 255) >= Matcher::ALN_RES_WITHOUT_BT_COL_CNT) {
+                            Matcher::result_t swRes = Matcher::parseAlignmentRecord(alnData);
+                            if (swRes.qStartPos >= 0 && swRes.dbStartPos >= 0
+                                && swRes.qEndPos < static_cast<int>(queryLen) && swRes.dbEndPos < static_cast<int>(targetLen)) {
+                                qOffset = static_cast<size_t>(std::max(0, swRes.qStartPos - par.fwbwMargin));
+                                dbOffset = static_cast<size_t>(std::max(0, swRes.dbStartPos - par.fwbwMargin));
+                                qRegionLen = std::min(queryLen, static_cast<size_t>(swRes.qEndPos + par.fwbwMargin + 1)) - qOffset;
+                                dbRegionLen = std::min(targetLen, static_cast<size_t>(swRes.dbEndPos + par.fwbwMargin + 1)) - dbOffset;
+                            }
+                        }
+                        fwbwaligner.initProfile(qSeq.numSequence + qOffset, qRegionLen);
+                    }
                     //Init target & Resizing memory
-                    fwbwaligner.initAlignment(dbSeq.numSequence, targetLen, queryLen); 
+                    fwbwaligner.initAlignment(dbSeq.numSequence + dbOffset, dbRegionLen, qRegionLen);
                     switch(par.fwbwBacktraceMode) {
                         case 0: fwbwaligner.runFwBw<true,0>(); break;
                         case 1: fwbwaligner.runFwBw<true,1>(); break;
@@ -1149,14 +1180,14 @@ int fwbw(int argc, const char **argv, const Command &command) {
                     // Map s_align values to result_t 
                     FwBwAligner::s_align fwbwAlignment = fwbwaligner.getFwbwAlnResult();
                     
-                    float qcov = fwbwAlignment.qCov;
-                    float dbcov = fwbwAlignment.dbCov;
                     float evalue = 0;
                     const int score = fwbwAlignment.score2;
-                    const unsigned int qStartPos = fwbwAlignment.qStartPos1;
-                    const unsigned int dbStartPos = fwbwAlignment.dbStartPos1;
-                    const unsigned int qEndPos = fwbwAlignment.qEndPos1;
-                    const unsigned int dbEndPos = fwbwAlignment.dbEndPos1;
+                    const unsigned int qStartPos = fwbwAlignment.qStartPos1 + qOffset;
+                    const unsigned int dbStartPos = fwbwAlignment.dbStartPos1 + dbOffset;
+                    const unsigned int qEndPos = fwbwAlignment.qEndPos1 + qOffset;
+                    const unsigned int dbEndPos = fwbwAlignment.dbEndPos1 + dbOffset;
+                    float qcov = SmithWaterman::computeCov(qStartPos, qEndPos, queryLen);
+                    float dbcov = SmithWaterman::computeCov(dbStartPos, dbEndPos, targetLen);
                     std::string backtrace = fwbwAlignment.cigar;
                     unsigned int alnLength = backtrace.size();
                     float seqId = Util::computeSeqId(par.seqIdMode, fwbwAlignment.identicalAACnt, queryLen, targetLen, alnLength);
@@ -106,6 +106,7 @@ private:
     // float temperature;
     size_t rowsCapacity;
     size_t colsCapacity;
+    size_t profileColsCapacity;
 
     size_t blockCapacity;
     size_t blocks;
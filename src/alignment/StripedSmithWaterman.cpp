@@ -33,6 +33,7 @@
 #include "Debug.h"
 #include "block_aligner.h"
 #include <iostream>
+#include <vector>
 
 #define MAX_SIZE 4096
 
@@ -78,6 +79,8 @@ struct s_block {
 	PosBias* query_bias;
 	AAMatrix* mat_aa;
 	BlockHandle block_trace;
+	// the trace buffer grows with query + target length, so it is only allocated when needed
+	size_t block_trace_len;
 	int16_t* query_bias_arr;
 };
 
@@ -655,6 +658,7 @@ SmithWaterman::SmithWaterman(size_t maxSequenceLength, int aaSize, bool aaBiasCo
                              float aaBiasCorrectionScale, SubstitutionMatrix * subMat) {
 	maxSequenceLength += 1;
 	this->subMat = subMat;
+	this->linearSpaceBacktraceCells = LINEAR_SPACE_BACKTRACE_CELLS;
     this->aaBiasCorrectionScale = aaBiasCorrectionScale;
 	this->aaBiasCorrection = aaBiasCorrection;
 
@@ -706,7 +710,8 @@ SmithWaterman::SmithWaterman(size_t maxSequenceLength, int aaSize, bool aaBiasCo
 	block->query = block_new_padded_aa(maxSequenceLength, MAX_SIZE);
 	block->query_bias = block_new_pos_bias(maxSequenceLength, MAX_SIZE);
 	block->mat_aa = block_new_simple_aamatrix(1, -1);
-	block->block_trace = block_new_aa_trace_xdrop(maxSequenceLength, maxSequenceLength, MAX_SIZE);
+	block->block_trace = NULL;
+	block->block_trace_len = 0;
 	block->query_bias_arr = new int16_t[maxSequenceLength];
 
 	profile->pos_aa_rev = new int8_t[maxSequenceLength * 32];
@@ -743,7 +748,9 @@ SmithWaterman::~SmithWaterman(){
 	block_free_padded_aa(block->query);
 	block_free_pos_bias(block->query_bias);
 	block_free_aamatrix(block->mat_aa);
-	block_free_aa_trace_xdrop(block->block_trace);
+	if (block->block_trace != NULL) {
+		block_free_aa_trace_xdrop(block->block_trace);
+	}
 	delete [] block->query_bias_arr;
 	delete block;
 }
@@ -864,7 +871,8 @@ s_align SmithWaterman::ssw_align_private (
 
 	// run very shot and long overflowing alignments with SW instead of block aligner
 	// short alignments are very fast with byte SW, long alignments produce slightly different scores FIXME
-	if (align.word != 1) {
+	// very large alignments are traced back in linear space by alignStartPosBacktrace
+	if (align.word != 1 || useLinearSpaceBacktrace(align.qEndPos1 + 1, align.dbEndPos1 + 1)) {
 		return alignStartPosBacktrace<type>(db_sequence, db_length, gap_open, gap_extend, alignmentMode, backtrace, align, evaluer, covMode, covThr, correlationScoreWeight, maskLen);
 	}
 
@@ -1016,6 +1024,15 @@ s_align SmithWaterman::alignStartPosBacktraceBlock(
 		target_bias = block_new_pos_bias(targetAlnLen, MAX_SIZE); // fill 0
 	}
 
+	// the block aligner only requires query + target length to fit into the trace
+	if (block->block_trace == NULL || static_cast<size_t>(queryAlnLen + targetAlnLen) > block->block_trace_len) {
+		if (block->block_trace != NULL) {
+			block_free_aa_trace_xdrop(block->block_trace);
+		}
+		block->block_trace_len = std::max(static_cast<size_t>(queryAlnLen + targetAlnLen), 2 * block->block_trace_len);
+		block->block_trace = block_new_aa_trace_xdrop(block->block_trace_len, 0, MAX_SIZE);
+	}
+
 	// substitute profile values to queryProfile
 	AlignResult res;
 	size_t min_size = 32;
@@ -1223,7 +1240,9 @@ s_align SmithWaterman::alignStartPosBacktrace (
     int32_t band_width = abs(db_length - query_length) + 1;
 
     cigar* path;
-    if (type == PROFILE_SEQ) {
+    if (useLinearSpaceBacktrace(query_length, db_length)) {
+        path = linear_space_sw<type>(db_sequence + r.dbStartPos1, db_length, query_length, r.qStartPos1, gap_open, gap_extend);
+    } else if (type == PROFILE_SEQ) {
         path = banded_sw<type>(db_sequence + r.dbStartPos1, profile->query_sequence + r.qStartPos1, profile->composition_bias + r.qStartPos1, db_length,
 							   query_length, r.qStartPos1, r.score1, gap_open, gap_extend,
 							   band_width, profile->mat, profile->query_length);
@@ -1691,6 +1710,204 @@ SmithWaterman::cigar * SmithWaterman::banded_sw(const unsigned char *db_sequence
 #undef set_u
 #undef set_d
 }
+// Myers-Miller divide and conquer global alignment with affine gaps in linear space
+// Aligns query[queryStart, queryStart + M) against the target region found by the forward and reverse SW passes.
+// Costs are negated scores, a gap of length k costs g + h * k with g = gap_open - gap_extend and h = gap_extend.
+// 'I' consumes a query residue, 'D' a target residue (same as banded_sw).
+template <unsigned int type>
+class LinearSpaceAligner {
+public:
+	LinearSpaceAligner(const s_profile *profile, const unsigned char *db_sequence, int32_t db_length, int32_t queryStart,
+					   int32_t gap_open, int32_t gap_extend, std::string &ops)
+		: profile(profile), db_sequence(db_sequence), queryStart(queryStart),
+		  g(gap_open - gap_extend), h(gap_extend), ops(ops),
+		  CC(db_length + 1), DD(db_length + 1), RR(db_length + 1), SS(db_length + 1) {}
+
+	void align(int32_t query_length, int32_t db_length) {
+		diff(0, 0, query_length, db_length, g, g);
+	}
+
+private:
+	const s_profile *profile;
+	const unsigned char *db_sequence;
+	const int32_t queryStart;
+	const int32_t g;
+	const int32_t h;
+	std::string &ops;
+	std::vector<int32_t> CC;
+	std::vector<int32_t> DD;
+	std::vector<int32_t> RR;
+	std::vector<int32_t> SS;
+
+	// cost of matching query position i with target position j, both relative to the region start
+	inline int32_t w(int32_t i, int32_t j) const {
+		if (type == SmithWaterman::PROFILE_SEQ) {
+			return -profile->mat[db_sequence[j] * profile->query_length + queryStart + i];
+		}
+		const int32_t q = profile->query_sequence[queryStart + i];
+		return -(profile->mat[q * profile->alphabetSize + db_sequence[j]] + profile->composition_bias[queryStart + i]);
+	}
+
+	inline int32_t gap(int32_t k) const {
+		return (k <= 0) ? 0 : g + h * k;
+	}
+
+	// align query[a, a + M) with target[b, b + N)
+	// tb and te are the gap open costs of a query gap touching the begin and end of the subproblem
+	void diff(int32_t a, int32_t b, int32_t M, int32_t N, int32_t tb, int32_t te) {
+		if (N <= 0) {
+			if (M > 0) {
+				ops.append(M, 'I');
+			}
+			return;
+		}
+		if (M <= 1) {
+			if (M <= 0) {
+				ops.append(N, 'D');
+				return;
+			}
+			const bool gapFirst = tb < te;
+			int32_t midc = std::min(tb, te) + h + gap(N);
+			int32_t midj = 0;
+			for (int32_t j = 1; j <= N; j++) {
+				int32_t c = gap(j - 1) + w(a, b + j - 1) + gap(N - j);
+				if (c < midc) {
+					midc = c;
+					midj = j;
+				}
+			}
+			if (midj == 0) {
+				if (gapFirst) {
+					ops.push_back('I');
+					ops.append(N, 'D');
+				} else {
+					ops.append(N, 'D');
+					ops.push_back('I');
+				}
+			} else {
+				ops.append(midj - 1, 'D');
+				ops.push_back('M');
+				ops.append(N - midj, 'D');
+			}
+			return;
+		}
+
+		// forward phase: costs of the best paths from (0,0) to row midi
+		const int32_t midi = M / 2;
+		int32_t c, d, e, s, t;
+		CC[0] = 0;
+		t = g;
+		for (int32_t j = 1; j <= N; j++) {
+			CC[j] = t = t + h;
+			DD[j] = t + g;
+		}
+		t = tb;
+		for (int32_t i = 1; i <= midi; i++) {
+			s = CC[0];
+			CC[0] = c = t = t + h;
+			e = t + g;
+			for (int32_t j = 1; j <= N; j++) {
+				if ((c = c + g + h) < (e = e + h)) {
+					e = c;
+				}
+				if ((c = CC[j] + g + h) < (d = DD[j] + h)) {
+					d = c;
+				}
+				c = s + w(a + i - 1, b + j - 1);
+				c = std::min(c, std::min(d, e));
+				s = CC[j];
+				CC[j] = c;
+				DD[j] = d;
+			}
+		}
+		DD[0] = CC[0];
+
+		// reverse phase: costs of the best paths from row midi to (M,N)
+		RR[N] = 0;
+		t = g;
+		for (int32_t j = N - 1; j >= 0; j--) {
+			RR[j] = t = t + h;
+			SS[j] = t + g;
+		}
+		t = te;
+		for (int32_t i = M - 1; i >= midi; i--) {
+			s = RR[N];
+			RR[N] = c = t = t + h;
+			e = t + g;
+			for (int32_t j = N - 1; j >= 0; j--) {
+				if ((c = c + g + h) < (e = e + h)) {
+					e = c;
+				}
+				if ((c = RR[j] + g + h) < (d = SS[j] + h)) {
+					d = c;
+				}
+				c = s + w(a + i, b + j);
+				c = std::min(c, std::min(d, e));
+				s = RR[j];
+				RR[j] = c;
+				SS[j] = d;
+			}
+		}
+		SS[N] = RR[N];
+
+		// find the optimal midpoint, either on a match path or inside a query gap crossing row midi
+		int32_t midc = CC[0] + RR[0];
+		int32_t midj = 0;
+		bool inGap = false;
+		for (int32_t j = 0; j <= N; j++) {
+			c = CC[j] + RR[j];
+			if (c <= midc && (c < midc || (CC[j] != DD[j] && RR[j] == SS[j]))) {
+				midc = c;
+				midj = j;
+			}
+		}
+		for (int32_t j = N; j >= 0; j--) {
+			c = DD[j] + SS[j] - g;
+			if (c < midc) {
+				midc = c;
+				midj = j;
+				inGap = true;
+			}
+		}
+
+		if (inGap == false) {
+			diff(a, b, midi, midj, tb, g);
+			diff(a + midi, b + midj, M - midi, N - midj, g, te);
+		} else {
+			diff(a, b, midi - 1, midj, tb, 0);
+			ops.append(2, 'I');
+			diff(a + midi + 1, b + midj, M - midi - 1, N - midj, 0, te);
+		}
+	}
+};
+
+template <unsigned int type>
+SmithWaterman::cigar * SmithWaterman::linear_space_sw(const unsigned char *db_sequence, int32_t db_length,
+													  int32_t query_length, int32_t queryStart,
+													  const uint32_t gap_open, const uint32_t gap_extend) {
+	std::string ops;
+	ops.reserve(query_length + db_length);
+	LinearSpaceAligner<type> aligner(profile, db_sequence, db_length, queryStart, gap_open, gap_extend, ops);
+	aligner.align(query_length, db_length);
+
+	size_t runs = 0;
+	for (size_t i = 0; i < ops.size(); i++) {
+		runs += (i == 0 || ops[i] != ops[i - 1]);
+	}
+	cigar* result = new cigar();
+	result->seq = new uint32_t[runs];
+	result->length = 0;
+	uint32_t len = 0;
+	for (size_t i = 0; i < ops.size(); i++) {
+		len++;
+		if (i + 1 == ops.size() || ops[i + 1] != ops[i]) {
+			result->seq[result->length++] = to_cigar_int(len, ops[i]);
+			len = 0;
+		}
+	}
+	return result;
+}
+
 uint32_t SmithWaterman::to_cigar_int(uint32_t length, char op_letter) {
 	uint32_t res;
 	uint8_t op_code;
@@ -245,6 +245,13 @@ public:
         */
     static uint32_t to_cigar_int (uint32_t length, char op_letter);
 
+    // alignments spanning more DP cells than this are traced back in linear space
+    const static size_t LINEAR_SPACE_BACKTRACE_CELLS = 16 * 1024 * 1024;
+
+    void setLinearSpaceBacktraceCells(size_t cells) {
+        linearSpaceBacktraceCells = cells;
+    }
+
     // ssw_init
     const static unsigned int SUBSTITUTIONMATRIX = 1;
     const static unsigned int PROFILE = 2;
@@ -285,8 +292,18 @@ private:
                                     int32_t score, const uint32_t gap_open, const uint32_t gap_extend,
                                     int32_t band_width, const int8_t *mat, const int32_t qry_n);
 
+    template <unsigned int type>
+    SmithWaterman::cigar *linear_space_sw(const unsigned char *db_sequence, int32_t db_length,
+                                          int32_t query_length, int32_t queryStart,
+                                          const uint32_t gap_open, const uint32_t gap_extend);
+
+    bool useLinearSpaceBacktrace(int32_t query_length, int32_t db_length) const {
+        return static_cast<size_t>(query_length) * static_cast<size_t>(db_length) > linearSpaceBacktraceCells;
+    }
+
     s_profile* profile;
     s_block* block;
+    size_t linearSpaceBacktraceCells;
 
     float *tmp_composition_bias;
     int8_t * scorePerCol;
@@ -12,7 +12,9 @@ Clustering::Clustering(const std::string &seqDB, const std::string &seqDBIndex,
                        const std::string &alnDB, const std::string &alnDBIndex,
                        const std::string &outDB, const std::string &outDBIndex,
                        const std::string &sequenceWeightFile,
-                       unsigned int maxIteration, int similarityScoreType, int threads, int compressed, bool needSET) : needSET(needSET),
+                       unsigned int maxIteration, int similarityScoreType, int threads, int compressed, bool needSET,
+                       bool addMissingLinks) : needSET(needSET),
+                                                               addMissingLinks(addMissingLinks),
                                                                maxIteration(maxIteration),
                                                                similarityScoreType(similarityScoreType),
                                                                threads(threads),
@@ -190,7 +192,8 @@ void Clustering::run(int mode) {
     std::pair<unsigned int, unsigned int> * ret;
     ClusteringAlgorithms *algorithm = new ClusteringAlgorithms(seqDbr, alnDbr,
                                                                threads, similarityScoreType,
-                                                               maxIteration, keyToSet, sourceOffsets, sourceLookupTable, sourceList, seqnum, needSET);
+                                                               maxIteration, keyToSet, sourceOffsets, sourceLookupTable, sourceList, seqnum, needSET,
+                                                               addMissingLinks, outDB);
 
     if (mode == Parameters::GREEDY) {
         Debug(Debug::INFO) << "Clustering mode: Greedy\n";
@@ -201,6 +204,9 @@ void Clustering::run(int mode) {
     } else if (mode == Parameters::SET_COVER) {
         Debug(Debug::INFO) << "Clustering mode: Set Cover\n";
         ret = algorithm->execute(1);
+    } else if (mode == Parameters::SET_COVER_PARALLEL) {
+        Debug(Debug::INFO) << "Clustering mode: Parallel Set Cover\n";
+        ret = algorithm->execute(5);
     } else if (mode == Parameters::CONNECTED_COMPONENT) {
         Debug(Debug::INFO) << "Clustering mode: Connected Component\n";
         ret = algorithm->execute(3);
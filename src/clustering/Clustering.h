@@ -12,7 +12,8 @@ public:
                const std::string &alnResultsDB, const std::string &alnResultsDBIndex,
                const std::string &outDB, const std::string &outDBIndex,
                const std::string &weightFileName,
-               unsigned int maxIteration, int similarityScoreType, int threads, int compressed, bool needSET);
+               unsigned int maxIteration, int similarityScoreType, int threads, int compressed, bool needSET,
+               bool addMissingLinks);
 
     void run(int mode);
 
@@ -27,6 +28,7 @@ private:
     DBReader<unsigned int> *alnDbr;
 
     bool needSET;
+    bool addMissingLinks;
     unsigned int seqnum;
     unsigned int *keyToSet;
     size_t *sourceOffsets;
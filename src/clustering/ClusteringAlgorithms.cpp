@@ -3,12 +3,15 @@
 #include "Debug.h"
 #include "AlignmentSymmetry.h"
 #include "Timer.h"
+#include "FileUtil.h"
 
 #include <queue>
 #include <algorithm>
 #include <climits>
+#include <cmath>
 #include <unordered_map>
 #include <FastSort.h>
+#include <sys/mman.h>
 
 #ifdef OPENMP
 #include <omp.h>
@@ -16,7 +19,7 @@
 
 ClusteringAlgorithms::ClusteringAlgorithms(DBReader<unsigned int>* seqDbr, DBReader<unsigned int>* alnDbr,
                                            int threads, int scoretype, int maxiterations,
-                                           unsigned int *keyToSet, size_t *sourceOffsets, unsigned int **sourceLookupTable, unsigned int *sourceList, unsigned int sourceLen, bool needSET){
+                                           unsigned int *keyToSet, size_t *sourceOffsets, unsigned int **sourceLookupTable, unsigned int *sourceList, unsigned int sourceLen, bool needSET, bool addMissingLinks, const std::string &tmpPrefix){
     this->seqDbr=seqDbr;
     if(seqDbr->getSize() != alnDbr->getSize() && needSET == false){
         Debug(Debug::ERROR) << "Sequence db size != result db size\n";
@@ -33,6 +36,8 @@ ClusteringAlgorithms::ClusteringAlgorithms(DBReader<unsigned int>* seqDbr, DBRea
     this->sourceList=sourceList;
     this->sourceLen=sourceLen;
     this->needSET=needSET;
+    this->addMissingLinks=addMissingLinks;
+    this->tmpPrefix=tmpPrefix;
     ///time
     this->clustersizes=new int[dbSize];
     std::fill_n(clustersizes, dbSize, 0);
@@ -54,6 +59,9 @@ std::pair<unsigned int, unsigned int> * ClusteringAlgorithms::execute(int mode)
     //time
     if (mode==4 || mode==2) {
         greedyIncrementalLowMem(assignedcluster);
+    } else if (mode == 3 && maxiterations <= 0) {
+        Debug(Debug::INFO) << "connected component mode (union-find)" << "\n";
+        connectedComponentUnionFind(assignedcluster);
     } else {
         size_t elementCount = 0;
 #pragma omp parallel reduction (+:elementCount)
@@ -87,6 +95,8 @@ std::pair<unsigned int, unsigned int> * ClusteringAlgorithms::execute(int mode)
         ClusteringAlgorithms::initClustersizes();
         if (mode == 1) {
             setCover(elementLookupTable, scoreLookupTable, assignedcluster, bestscore, elementOffsets);
+        } else if (mode == 5) {
+            parallelSetCover(elementLookupTable, scoreLookupTable, assignedcluster, elementOffsets);
         } else if (mode == 3) {
             Debug(Debug::INFO) << "connected component mode" << "\n";
             for (int cl_size = dbSize - 1; cl_size >= 0; cl_size--) {
@@ -277,11 +287,363 @@ void ClusteringAlgorithms::setCover(unsigned int **elementLookupTable, unsigned
     }
 }
 
+// sets whose size is within this factor of the largest one are selected in the same round
+static const float SET_COVER_BUCKET_RATIO = 1.25f;
+
+static inline unsigned int setCoverBucket(int size) {
+    return (size <= 1) ? 0 : 1 + static_cast<unsigned int>(log(static_cast<float>(size)) / log(SET_COVER_BUCKET_RATIO));
+}
+
+static inline void atomicMax(uint64_t *target, uint64_t value) {
+    uint64_t current = __atomic_load_n(target, __ATOMIC_RELAXED);
+    while (value > current && __sync_bool_compare_and_swap(target, current, value) == false) {
+        current = __atomic_load_n(target, __ATOMIC_RELAXED);
+    }
+}
+
+void ClusteringAlgorithms::parallelSetCover(unsigned int **elementLookupTable, unsigned short **elementScoreLookupTable,
+                                            unsigned int *assignedcluster, size_t *offsets) {
+    Timer timer;
+    // clustersizes holds the number of uncovered members of each set, the graph is symmetric so the
+    // sets containing an element are the members of its own set
+    unsigned char *covered = new(std::nothrow) unsigned char[dbSize];
+    Util::checkAllocation(covered, "Can not allocate covered memory in ClusteringAlgorithms::parallelSetCover");
+    std::fill_n(covered, dbSize, 0);
+    uint64_t *owner = new(std::nothrow) uint64_t[dbSize];
+    Util::checkAllocation(owner, "Can not allocate owner memory in ClusteringAlgorithms::parallelSetCover");
+    std::fill_n(owner, dbSize, 0);
+
+    std::vector<std::vector<unsigned int>> buckets(setCoverBucket(maxClustersize) + 1);
+    for (size_t i = 0; i < dbSize; i++) {
+        buckets[setCoverBucket(clustersizes[i])].push_back(i);
+    }
+
+    std::vector<unsigned int> representatives;
+    std::vector<unsigned int> candidates;
+    std::vector<unsigned char> selected;
+    size_t rounds = 0;
+    for (int64_t bucket = buckets.size() - 1; bucket >= 0; bucket--) {
+        std::vector<unsigned int> &current = buckets[bucket];
+        while (current.empty() == false) {
+            // drop covered sets and move shrunken ones down to their bucket
+            candidates.clear();
+            for (size_t i = 0; i < current.size(); i++) {
+                const unsigned int id = current[i];
+                if (covered[id]) {
+                    continue;
+                }
+                const unsigned int idBucket = setCoverBucket(clustersizes[id]);
+                if (idBucket < static_cast<unsigned int>(bucket)) {
+                    buckets[idBucket].push_back(id);
+                } else {
+                    candidates.push_back(id);
+                }
+            }
+            current.swap(candidates);
+            if (current.empty()) {
+                break;
+            }
+            rounds++;
+
+            // every uncovered element goes to the largest candidate containing it (ties by the larger id,
+            // as in the serial order), a candidate is selected if it won all of them
+#pragma omp parallel for schedule(dynamic, 100) num_threads(threads)
+            for (size_t i = 0; i < current.size(); i++) {
+                const unsigned int id = current[i];
+                const uint64_t key = (static_cast<uint64_t>(clustersizes[id]) << 32) | id;
+                atomicMax(&owner[id], key);
+                const size_t elementSize = offsets[id + 1] - offsets[id];
+                for (size_t elementId = 0; elementId < elementSize; elementId++) {
+                    const unsigned int element = elementLookupTable[id][elementId];
+                    if (covered[element] == 0) {
+                        atomicMax(&owner[element], key);
+                    }
+                }
+            }
+            selected.assign(current.size(), 0);
+#pragma omp parallel for schedule(dynamic, 100) num_threads(threads)
+            for (size_t i = 0; i < current.size(); i++) {
+                const unsigned int id = current[i];
+                const uint64_t key = (static_cast<uint64_t>(clustersizes[id]) << 32) | id;
+                bool wonAll = (owner[id] == key);
+                const size_t elementSize = offsets[id + 1] - offsets[id];
+                for (size_t elementId = 0; elementId < elementSize && wonAll; elementId++) {
+                    const unsigned int element = elementLookupTable[id][elementId];
+                    wonAll = (covered[element] != 0 || owner[element] == key);
+                }
+                selected[i] = wonAll;
+            }
+#pragma omp parallel for schedule(dynamic, 100) num_threads(threads)
+            for (size_t i = 0; i < current.size(); i++) {
+                const unsigned int id = current[i];
+                owner[id] = 0;
+                const size_t elementSize = offsets[id + 1] - offsets[id];
+                for (size_t elementId = 0; elementId < elementSize; elementId++) {
+                    owner[elementLookupTable[id][elementId]] = 0;
+                }
+            }
+
+            // selected sets are disjoint in their uncovered elements, cover them concurrently
+            const size_t representativeStart = representatives.size();
+            for (size_t i = 0; i < current.size(); i++) {
+                if (selected[i]) {
+                    representatives.push_back(current[i]);
+                }
+            }
+#pragma omp parallel for schedule(dynamic, 10) num_threads(threads)
+            for (size_t i = representativeStart; i < representatives.size(); i++) {
+                const unsigned int id = representatives[i];
+                std::vector<unsigned int> newlyCovered;
+                if (covered[id] == 0) {
+                    covered[id] = 1;
+                    newlyCovered.push_back(id);
+                }
+                const size_t elementSize = offsets[id + 1] - offsets[id];
+                for (size_t elementId = 0; elementId < elementSize; elementId++) {
+                    const unsigned int element = elementLookupTable[id][elementId];
+                    if (covered[element] == 0) {
+                        covered[element] = 1;
+                        newlyCovered.push_back(element);
+                    }
+                }
+                for (size_t j = 0; j < newlyCovered.size(); j++) {
+                    const unsigned int element = newlyCovered[j];
+                    const size_t containingSize = offsets[element + 1] - offsets[element];
+                    for (size_t elementId = 0; elementId < containingSize; elementId++) {
+                        __sync_fetch_and_sub(&clustersizes[elementLookupTable[element][elementId]], 1);
+                    }
+                }
+            }
+        }
+    }
+
+    // like the serial set cover, members move to the selected set they score best with, earlier sets win ties
+    std::fill_n(owner, dbSize, 0);
+#pragma omp parallel for schedule(dynamic, 10) num_threads(threads)
+    for (size_t i = 0; i < representatives.size(); i++) {
+        const unsigned int id = representatives[i];
+        const uint64_t rank = UINT_MAX - i;
+        const size_t elementSize = offsets[id + 1] - offsets[id];
+        for (size_t elementId = 0; elementId < elementSize; elementId++) {
+            const short seqId = elementScoreLookupTable[id][elementId];
+            const uint64_t key = (static_cast<uint64_t>(seqId - SHRT_MIN + 1) << 32) | rank;
+            atomicMax(&owner[elementLookupTable[id][elementId]], key);
+        }
+    }
+#pragma omp parallel for schedule(static) num_threads(threads)
+    for (size_t i = 0; i < dbSize; i++) {
+        assignedcluster[i] = (owner[i] == 0) ? i : representatives[UINT_MAX - (owner[i] & 0xFFFFFFFF)];
+    }
+#pragma omp parallel for schedule(static) num_threads(threads)
+    for (size_t i = 0; i < representatives.size(); i++) {
+        assignedcluster[representatives[i]] = representatives[i];
+    }
+    delete [] owner;
+    delete [] covered;
+    Debug(Debug::INFO) << "Parallel set cover selected " << representatives.size() << " representatives in "
+                       << rounds << " rounds: " << timer.lap() << "\n";
+}
+
+void ClusteringAlgorithms::readAlignmentIds(size_t id, int thread_idx, std::vector<unsigned int> &ids) {
+    char dbKey[255 + 1];
+    const unsigned int clusterKey = seqDbr->getDbKey(id);
+    if (needSET) {
+        const size_t len = sourceOffsets[clusterKey + 1] - sourceOffsets[clusterKey];
+        for (size_t j = 0; j < len; ++j) {
+            const unsigned int value = sourceLookupTable[clusterKey][j];
+            if (value != UINT_MAX) {
+                const size_t alnId = alnDbr->getId(value);
+                char *data = alnDbr->getData(alnId, thread_idx);
+                while (*data != '\0') {
+                    Util::parseKey(data, dbKey);
+                    const unsigned int key = keyToSet[(unsigned int) strtoul(dbKey, NULL, 10)];
+                    ids.push_back(seqDbr->getId(key));
+                    data = Util::skipLine(data);
+                }
+            }
+        }
+    } else {
+        const size_t alnId = alnDbr->getId(clusterKey);
+        char *data = alnDbr->getData(alnId, thread_idx);
+        while (*data != '\0') {
+            Util::parseKey(data, dbKey);
+            const unsigned int key = (unsigned int) strtoul(dbKey, NULL, 10);
+            ids.push_back(seqDbr->getId(key));
+            data = Util::skipLine(data);
+        }
+    }
+}
+
+typedef std::pair<unsigned int, unsigned int> ReversedEdge;
+
+static void writeReversedEdgeRun(std::vector<ReversedEdge> &edges, const std::string &fileName) {
+    std::sort(edges.begin(), edges.end());
+    FILE *file = FileUtil::openFileOrDie(fileName.c_str(), "wb", false);
+    if (edges.empty() == false && fwrite(edges.data(), sizeof(ReversedEdge), edges.size(), file) != edges.size()) {
+        Debug(Debug::ERROR) << "Can not write to file " << fileName << "\n";
+        EXIT(EXIT_FAILURE);
+    }
+    if (fclose(file) != 0) {
+        Debug(Debug::ERROR) << "Can not close file " << fileName << "\n";
+        EXIT(EXIT_FAILURE);
+    }
+    edges.clear();
+}
+
+struct ReversedEdgeRun {
+    ReversedEdge *edges;
+    size_t size;
+    size_t pos;
+    size_t dataSize;
+};
+
+struct CompareReversedEdgeRun {
+    bool operator()(const ReversedEdgeRun *lhs, const ReversedEdgeRun *rhs) const {
+        return lhs->edges[lhs->pos] > rhs->edges[rhs->pos];
+    }
+};
+
+static void openReversedEdgeRun(const std::string &fileName, ReversedEdgeRun &run) {
+    FILE *file = FileUtil::openFileOrDie(fileName.c_str(), "r", true);
+    run.edges = (ReversedEdge *) FileUtil::mmapFile(file, &run.dataSize);
+    fclose(file);
+#if HAVE_POSIX_MADVISE
+    if (run.dataSize > 0 && posix_madvise(run.edges, run.dataSize, POSIX_MADV_SEQUENTIAL) != 0) {
+        Debug(Debug::ERROR) << "posix_madvise returned an error for file " << fileName << "\n";
+    }
+#endif
+    run.size = run.dataSize / sizeof(ReversedEdge);
+    run.pos = 0;
+}
+
+static void closeReversedEdgeRun(const std::string &fileName, ReversedEdgeRun &run) {
+    if (run.dataSize > 0) {
+        FileUtil::munmapData(run.edges, run.dataSize);
+    }
+    FileUtil::remove(fileName.c_str());
+}
+
+// at most this many runs are mapped at the same time, more runs are merged in rounds first
+static const size_t MAX_MERGED_RUNS = 64;
+
+static void mergeReversedEdgeRuns(std::vector<std::string> &runFiles, const std::string &tmpPrefix) {
+    size_t nextRun = runFiles.size();
+    std::vector<ReversedEdge> buffer;
+    buffer.reserve(1 << 16);
+    while (runFiles.size() > MAX_MERGED_RUNS) {
+        std::vector<ReversedEdgeRun> runs(MAX_MERGED_RUNS);
+        std::priority_queue<ReversedEdgeRun *, std::vector<ReversedEdgeRun *>, CompareReversedEdgeRun> runQueue;
+        for (size_t i = 0; i < MAX_MERGED_RUNS; i++) {
+            openReversedEdgeRun(runFiles[i], runs[i]);
+            if (runs[i].size > 0) {
+                runQueue.push(&runs[i]);
+            }
+        }
+        std::string fileName = tmpPrefix + "_reversed_" + SSTR(nextRun++);
+        FILE *file = FileUtil::openFileOrDie(fileName.c_str(), "wb", false);
+        while (runQueue.empty() == false) {
+            ReversedEdgeRun *run = runQueue.top();
+            runQueue.pop();
+            buffer.push_back(run->edges[run->pos]);
+            run->pos++;
+            if (run->pos < run->size) {
+                runQueue.push(run);
+            }
+            if (buffer.size() == buffer.capacity() || runQueue.empty()) {
+                if (fwrite(buffer.data(), sizeof(ReversedEdge), buffer.size(), file) != buffer.size()) {
+                    Debug(Debug::ERROR) << "Can not write to file " << fileName << "\n";
+                    EXIT(EXIT_FAILURE);
+                }
+                buffer.clear();
+            }
+        }
+        if (fclose(file) != 0) {
+            Debug(Debug::ERROR) << "Can not close file " << fileName << "\n";
+            EXIT(EXIT_FAILURE);
+        }
+        for (size_t i = 0; i < MAX_MERGED_RUNS; i++) {
+            closeReversedEdgeRun(runFiles[i], runs[i]);
+        }
+        runFiles.erase(runFiles.begin(), runFiles.begin() + MAX_MERGED_RUNS);
+        runFiles.push_back(fileName);
+    }
+}
+
+std::vector<std::string> ClusteringAlgorithms::writeReversedEdges() {
+    Timer timer;
+    // all threads together never hold more than max(dbSize, 2^20) edges
+    const size_t runSize = std::max(static_cast<size_t>(dbSize), static_cast<size_t>(1) << 20) / threads + 1;
+    std::vector<std::string> runFiles;
+#pragma omp parallel num_threads(threads)
+    {
+        int thread_idx = 0;
+#ifdef OPENMP
+        thread_idx = omp_get_thread_num();
+#endif
+        std::vector<unsigned int> ids;
+        std::vector<ReversedEdge> edges;
+        edges.reserve(runSize);
+#pragma omp for schedule(dynamic, 100)
+        for (size_t i = 0; i < dbSize; i++) {
+            ids.clear();
+            readAlignmentIds(i, thread_idx, ids);
+            for (size_t j = 0; j < ids.size(); j++) {
+                if (ids[j] == i) {
+                    continue;
+                }
+                if (ids[j] == UINT_MAX) {
+                    Debug(Debug::ERROR) << "Element " << i << " links to an element not contained in the sequence database!\n";
+                    EXIT(EXIT_FAILURE);
+                }
+                edges.push_back(ReversedEdge(ids[j], i));
+                if (edges.size() >= runSize) {
+                    std::string fileName;
+#pragma omp critical
+                    {
+                        fileName = tmpPrefix + "_reversed_" + SSTR(runFiles.size());
+                        runFiles.push_back(fileName);
+                    }
+                    writeReversedEdgeRun(edges, fileName);
+                }
+            }
+        }
+        if (edges.empty() == false) {
+            std::string fileName;
+#pragma omp critical
+            {
+                fileName = tmpPrefix + "_reversed_" + SSTR(runFiles.size());
+                runFiles.push_back(fileName);
+            }
+            writeReversedEdgeRun(edges, fileName);
+        }
+    }
+    const size_t writtenRuns = runFiles.size();
+    mergeReversedEdgeRuns(runFiles, tmpPrefix);
+    Debug(Debug::INFO) << "Wrote reversed edges into " << writtenRuns << " sorted runs, merged into " << runFiles.size() << ": " << timer.lap() << "\n";
+    return runFiles;
+}
+
 void ClusteringAlgorithms::greedyIncrementalLowMem( unsigned int *assignedcluster) {
 
     const long BUFFER_SIZE = 100000; // Set this to a suitable value.
     const long numBuffers = (dbSize + BUFFER_SIZE - 1) / BUFFER_SIZE;
 
+    // reversed edges are merged from the sorted runs in the same order the representatives are visited
+    std::vector<std::string> runFiles;
+    std::vector<ReversedEdgeRun> runs;
+    std::priority_queue<ReversedEdgeRun *, std::vector<ReversedEdgeRun *>, CompareReversedEdgeRun> runQueue;
+    std::vector<unsigned int> reversed;
+    if (addMissingLinks) {
+        runFiles = writeReversedEdges();
+        runs.resize(runFiles.size());
+        for (size_t i = 0; i < runFiles.size(); i++) {
+            openReversedEdgeRun(runFiles[i], runs[i]);
+            if (runs[i].size > 0) {
+                runQueue.push(&runs[i]);
+            }
+        }
+    }
+
     // Pre-allocate buffer outside the loop to reuse it
     std::vector<std::pair<unsigned int, std::vector<unsigned int>>> buffer(BUFFER_SIZE);
 
@@ -303,38 +665,7 @@ void ClusteringAlgorithms::greedyIncrementalLowMem( unsigned int *assignedcluste
 #endif
 #pragma omp for schedule(dynamic, 4)
             for (long i = start; i < end; i++) {
-                unsigned int clusterKey = seqDbr->getDbKey(i);
-                std::vector<unsigned int>& keys = buffer[i - start].second;
-                if(needSET) {
-                    size_t start1 = sourceOffsets[clusterKey];
-                    size_t end1 = sourceOffsets[clusterKey+1];
-                    size_t len = end1 - start1;
-                    for (size_t j = 0; j < len; ++j) {
-                        unsigned int value = sourceLookupTable[clusterKey][j];
-                        if (value != UINT_MAX) {
-                            const size_t alnId = alnDbr->getId(value);
-                            char *data = alnDbr->getData(alnId, thread_idx);
-                            while (*data != '\0') {
-                                char dbKey[255 + 1];
-                                Util::parseKey(data, dbKey);
-                                const unsigned int key = keyToSet[(unsigned int)strtoul(dbKey, NULL, 10)];
-                                keys.push_back(key);
-                                data = Util::skipLine(data);
-                            }
-                        }
-                    }
-                } else {
-                    const size_t alnId = alnDbr->getId(clusterKey);
-                    char* data = alnDbr->getData(alnId, thread_idx);
-                    while (*data != '\0') {
-                        char dbKey[255 + 1];
-                        Util::parseKey(data, dbKey);
-                        const unsigned int key = (unsigned int)strtoul(dbKey, NULL, 10);
-                        keys.push_back(key);
-                        data = Util::skipLine(data);
-                    }
-                }
-
+                readAlignmentIds(i, thread_idx, buffer[i - start].second);
                 buffer[i - start].first = i;
             }
         }
@@ -342,19 +673,37 @@ void ClusteringAlgorithms::greedyIncrementalLowMem( unsigned int *assignedcluste
         // Sequential processing of the buffer
         for (long j = 0; j < (end - start); j++) {
             unsigned int clusterId = buffer[j].first;
-            const std::vector<unsigned int>& keys = buffer[j].second;
+            const std::vector<unsigned int>& ids = buffer[j].second;
+
+            reversed.clear();
+            while (runQueue.empty() == false && runQueue.top()->edges[runQueue.top()->pos].first == clusterId) {
+                ReversedEdgeRun *run = runQueue.top();
+                runQueue.pop();
+                reversed.push_back(run->edges[run->pos].second);
+                run->pos++;
+                if (run->pos < run->size) {
+                    runQueue.push(run);
+                }
+            }
 
             if (assignedcluster[clusterId] != UINT_MAX) {
                 continue;
             }
 
-            if (keys.size() <= 1) {
+            if (ids.size() + reversed.size() <= 1) {
                 continue;
             }
 
-            for (unsigned int key : keys) {
-                unsigned int currElement = seqDbr->getId(key);
-
+            // without missing links the representative is only assigned through its own self hit, as before
+            if (addMissingLinks) {
+                assignedcluster[clusterId] = clusterId;
+            }
+            for (unsigned int currElement : ids) {
+                if (assignedcluster[currElement] == UINT_MAX) {
+                    assignedcluster[currElement] = clusterId;
+                }
+            }
+            for (unsigned int currElement : reversed) {
                 if (assignedcluster[currElement] == UINT_MAX) {
                     assignedcluster[currElement] = clusterId;
                 }
@@ -362,6 +711,10 @@ void ClusteringAlgorithms::greedyIncrementalLowMem( unsigned int *assignedcluste
         }
     }
 
+    for (size_t i = 0; i < runFiles.size(); i++) {
+        closeReversedEdgeRun(runFiles[i], runs[i]);
+    }
+
     // correct edges that are not assigned properly
     for (size_t id = 0; id < dbSize; ++id) {
         // check if the assigned clusterid is a rep. sequence
@@ -372,6 +725,130 @@ void ClusteringAlgorithms::greedyIncrementalLowMem( unsigned int *assignedcluste
     }
 }
 
+static inline unsigned int unionFindRoot(unsigned int *parent, unsigned int id) {
+    while (true) {
+        const unsigned int p = __atomic_load_n(&parent[id], __ATOMIC_RELAXED);
+        if (p == id) {
+            return id;
+        }
+        const unsigned int gp = __atomic_load_n(&parent[p], __ATOMIC_RELAXED);
+        if (p != gp) {
+            // path halving, losing the race only costs compression
+            __sync_bool_compare_and_swap(&parent[id], p, gp);
+        }
+        id = gp;
+    }
+}
+
+static inline void unionFindMerge(unsigned int *parent, unsigned int a, unsigned int b) {
+    while (true) {
+        a = unionFindRoot(parent, a);
+        b = unionFindRoot(parent, b);
+        if (a == b) {
+            return;
+        }
+        // always hang the larger root below the smaller one, so concurrent links cannot form a cycle
+        if (a < b) {
+            std::swap(a, b);
+        }
+        if (__sync_bool_compare_and_swap(&parent[a], a, b)) {
+            return;
+        }
+    }
+}
+
+void ClusteringAlgorithms::connectedComponentUnionFind(unsigned int *assignedcluster) {
+    Timer timer;
+    unsigned int *parent = new(std::nothrow) unsigned int[dbSize];
+    Util::checkAllocation(parent, "Can not allocate parent memory in ClusteringAlgorithms::connectedComponentUnionFind");
+    unsigned int *degree = new(std::nothrow) unsigned int[dbSize];
+    Util::checkAllocation(degree, "Can not allocate degree memory in ClusteringAlgorithms::connectedComponentUnionFind");
+    for (size_t i = 0; i < dbSize; i++) {
+        parent[i] = i;
+    }
+
+    // edges are merged straight from the alignment entries, the graph does not need to be symmetric
+#pragma omp parallel num_threads(threads)
+    {
+        int thread_idx = 0;
+#ifdef OPENMP
+        thread_idx = omp_get_thread_num();
+#endif
+        char dbKey[255 + 1];
+#pragma omp for schedule(dynamic, 1000)
+        for (size_t i = 0; i < dbSize; i++) {
+            const unsigned int clusterKey = seqDbr->getDbKey(i);
+            unsigned int edges = 0;
+            if (needSET) {
+                const size_t len = sourceOffsets[clusterKey + 1] - sourceOffsets[clusterKey];
+                for (size_t j = 0; j < len; ++j) {
+                    const unsigned int value = sourceLookupTable[clusterKey][j];
+                    if (value == UINT_MAX) {
+                        continue;
+                    }
+                    const size_t alnId = alnDbr->getId(value);
+                    char *data = alnDbr->getData(alnId, thread_idx);
+                    while (*data != '\0') {
+                        Util::parseKey(data, dbKey);
+                        const unsigned int key = keyToSet[(unsigned int) strtoul(dbKey, NULL, 10)];
+                        const size_t currElement = seqDbr->getId(key);
+                        if (currElement == UINT_MAX) {
+                            Debug(Debug::ERROR) << "Element " << dbKey << " contained in some alignment list, but not contained in the sequence database!\n";
+                            EXIT(EXIT_FAILURE);
+                        }
+                        unionFindMerge(parent, i, currElement);
+                        edges++;
+                        data = Util::skipLine(data);
+                    }
+                }
+            } else {
+                const size_t alnId = alnDbr->getId(clusterKey);
+                char *data = alnDbr->getData(alnId, thread_idx);
+                while (*data != '\0') {
+                    Util::parseKey(data, dbKey);
+                    const unsigned int key = (unsigned int) strtoul(dbKey, NULL, 10);
+                    const size_t currElement = seqDbr->getId(key);
+                    if (currElement == UINT_MAX) {
+                        Debug(Debug::ERROR) << "Element " << dbKey << " contained in some alignment list, but not contained in the sequence database!\n";
+                        EXIT(EXIT_FAILURE);
+                    }
+                    unionFindMerge(parent, i, currElement);
+                    edges++;
+                    data = Util::skipLine(data);
+                }
+            }
+            degree[i] = edges;
+        }
+    }
+
+    // as in the breadth first search, the member with the most edges represents its component
+    // ties are broken like the size sorted order, by the larger id
+    uint64_t *best = new(std::nothrow) uint64_t[dbSize];
+    Util::checkAllocation(best, "Can not allocate best memory in ClusteringAlgorithms::connectedComponentUnionFind");
+    std::fill_n(best, dbSize, 0);
+#pragma omp parallel num_threads(threads)
+    {
+#pragma omp for schedule(static)
+        for (size_t i = 0; i < dbSize; i++) {
+            const unsigned int root = unionFindRoot(parent, i);
+            const uint64_t candidate = (static_cast<uint64_t>(degree[i]) << 32) | static_cast<uint64_t>(i);
+            uint64_t current = __atomic_load_n(&best[root], __ATOMIC_RELAXED);
+            while (candidate > current && __sync_bool_compare_and_swap(&best[root], current, candidate) == false) {
+                current = __atomic_load_n(&best[root], __ATOMIC_RELAXED);
+            }
+        }
+#pragma omp barrier
+#pragma omp for schedule(static)
+        for (size_t i = 0; i < dbSize; i++) {
+            assignedcluster[i] = static_cast<unsigned int>(best[unionFindRoot(parent, i)] & 0xFFFFFFFF);
+        }
+    }
+    delete [] best;
+    delete [] degree;
+    delete [] parent;
+    Debug(Debug::INFO) << "Time for union-find: " << timer.lap() << "\n";
+}
+
 void ClusteringAlgorithms::readInClusterData(unsigned int **elementLookupTable, unsigned int *&elements,
                                              unsigned short **scoreLookupTable, unsigned short *&scores,
                                              size_t *elementOffsets, size_t totalElementCount) {
@@ -14,7 +14,7 @@
 
 class ClusteringAlgorithms {
 public:
-    ClusteringAlgorithms(DBReader<unsigned int>* seqDbr, DBReader<unsigned int>* alnDbr, int threads,int scoretype, int maxiterations, unsigned int *keyToSet, size_t *sourceOffsets, unsigned int **sourceLookupTable, unsigned int *sourceList, unsigned int sourceLen, bool needSET);
+    ClusteringAlgorithms(DBReader<unsigned int>* seqDbr, DBReader<unsigned int>* alnDbr, int threads,int scoretype, int maxiterations, unsigned int *keyToSet, size_t *sourceOffsets, unsigned int **sourceLookupTable, unsigned int *sourceList, unsigned int sourceLen, bool needSET, bool addMissingLinks, const std::string &tmpPrefix);
     ~ClusteringAlgorithms();
     std::pair<unsigned int, unsigned int> * execute(int mode);
 private:
@@ -23,6 +23,9 @@ private:
     DBReader<unsigned int>* alnDbr;
 
     bool needSET;
+    bool addMissingLinks;
+    // prefix of the temporary files holding the sorted reversed edges
+    std::string tmpPrefix;
     int threads;
     int scoretype;
 //datastructures
@@ -52,12 +55,24 @@ private:
     void setCover(unsigned int **elementLookup, unsigned short ** elementScoreLookupTable,
                   unsigned int *assignedcluster, short *bestscore, size_t *offsets);
 
+    // approximate bucketed greedy set cover selecting non-conflicting sets of the top bucket concurrently
+    void parallelSetCover(unsigned int **elementLookup, unsigned short ** elementScoreLookupTable,
+                          unsigned int *assignedcluster, size_t *offsets);
+
     void greedyIncremental(unsigned int **elementLookupTable, size_t *elementOffsets,
                            size_t n, unsigned int *assignedcluster) ;
 
 
     void greedyIncrementalLowMem(unsigned int *assignedcluster) ;
 
+    void readAlignmentIds(size_t id, int thread_idx, std::vector<unsigned int> &ids);
+
+    // writes (target, query) edges in sorted runs of at most O(dbSize) entries and returns the run files
+    std::vector<std::string> writeReversedEdges();
+
+    // unbounded connected components (maxiterations <= 0) with a concurrent union-find
+    void connectedComponentUnionFind(unsigned int *assignedcluster);
+
 
     void readInClusterData(unsigned int **elementLookupTable, unsigned int *&elements,
                            unsigned short **scoreLookupTable, unsigned short *&scores,
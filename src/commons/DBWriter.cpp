@@ -628,22 +628,32 @@ void DBWriter::mergeIndex(const char** indexFilenames, unsigned int fileCount, c
         perror(indexFilenames[0]);
         EXIT(EXIT_FAILURE);
     }
-    size_t globalOffset = dataSizes[0];
+    std::vector<size_t> globalOffsets(fileCount, 0);
+    for (unsigned int fileIdx = 1; fileIdx < fileCount; fileIdx++) {
+        globalOffsets[fileIdx] = globalOffsets[fileIdx - 1] + dataSizes[fileIdx - 1];
+    }
+    // indices are read and formatted in parallel, but appended in file order
+#pragma omp parallel for ordered schedule(dynamic, 1)
     for (unsigned int fileIdx = 1; fileIdx < fileCount; fileIdx++) {
         DBReader<unsigned int> reader(indexFilenames[fileIdx], indexFilenames[fileIdx], 1, DBReader<unsigned int>::USE_INDEX);
         reader.open(DBReader<unsigned int>::HARDNOSORT);
-        if (reader.getSize() > 0) {
-            DBReader<unsigned int>::Index * index = reader.getIndex();
-            for (size_t i = 0; i < reader.getSize(); i++) {
-                size_t currOffset = index[i].offset;
-                index[i].offset = globalOffset + currOffset;
-            }
-            writeIndex(index_file, reader.getSize(), index);
+        std::string buffer;
+        char buff1[1024];
+        DBReader<unsigned int>::Index * index = reader.getIndex();
+        for (size_t i = 0; i < reader.getSize(); i++) {
+            size_t len = indexToBuffer(buff1, index[i].id, globalOffsets[fileIdx] + index[i].offset, index[i].length);
+            buffer.append(buff1, len);
         }
         reader.close();
+#pragma omp ordered
+        {
+            size_t written = fwrite(buffer.c_str(), sizeof(char), buffer.size(), index_file);
+            if (written != buffer.size()) {
+                Debug(Debug::ERROR) << "Cannot write to index file " << indexFilenames[0] << "\n";
+                EXIT(EXIT_FAILURE);
+            }
+        }
         FileUtil::remove(indexFilenames[fileIdx]);
-
-        globalOffset += dataSizes[fileIdx];
     }
     if (fclose(index_file) != 0) {
         Debug(Debug::ERROR) << "Cannot close index file " << indexFilenames[0] << "\n";
@@ -45,6 +45,25 @@ public:
         return openFailed;
     }
 
+    // reads up to size bytes, returns 0 at the end of the input
+    size_t read(char *buffer, size_t size) {
+        if (openFailed) return 0;
+        if (mode == FILE_MODE) {
+            return fread(buffer, sizeof(char), size, file);
+        }
+#ifdef HAVE_ZLIB
+        else if (mode == GZ_MODE) {
+            int bytes = gzread(gzHandle, buffer, size);
+            if (bytes < 0) {
+                Debug(Debug::ERROR) << "Could not decompress input\n";
+                EXIT(EXIT_FAILURE);
+            }
+            return bytes;
+        }
+#endif
+        return 0;
+    }
+
     bool getline(std::string &line) {
         line.clear();
         if (openFailed) return false;
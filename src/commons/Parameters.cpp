@@ -92,14 +92,15 @@ Parameters::Parameters():
 #endif
         PARAM_ZDROP(PARAM_ZDROP_ID, "--zdrop", "Zdrop", "Maximal allowed difference between score values before alignment is truncated  (nucleotide alignment only)", typeid(int), (void*) &zdrop, "^[0-9]{1}[0-9]*$", MMseqsParameter::COMMAND_ALIGN | MMseqsParameter::COMMAND_EXPERT),
         // clustering
-        PARAM_CLUSTER_MODE(PARAM_CLUSTER_MODE_ID, "--cluster-mode", "Cluster mode", "0: Set-Cover (greedy)\n1: Connected component (BLASTclust)\n2,3: Greedy clustering by sequence length (CDHIT)", typeid(int), (void *) &clusteringMode, "[0-3]{1}$", MMseqsParameter::COMMAND_CLUST),
+        PARAM_CLUSTER_MODE(PARAM_CLUSTER_MODE_ID, "--cluster-mode", "Cluster mode", "0: Set-Cover (greedy)\n1: Connected component (BLASTclust)\n2,3: Greedy clustering by sequence length (CDHIT)\n4: Set-Cover (parallel, approximate)", typeid(int), (void *) &clusteringMode, "[0-4]{1}$", MMseqsParameter::COMMAND_CLUST),
         PARAM_CLUSTER_STEPS(PARAM_CLUSTER_STEPS_ID, "--cluster-steps", "Cascaded clustering steps", "Cascaded clustering steps from 1 to -s", typeid(int), (void *) &clusterSteps, "^[1-9]{1}$", MMseqsParameter::COMMAND_CLUST | MMseqsParameter::COMMAND_EXPERT),
         PARAM_CASCADED(PARAM_CASCADED_ID, "--single-step-clustering", "Single step clustering", "Switch from cascaded to simple clustering workflow", typeid(bool), (void *) &singleStepClustering, "", MMseqsParameter::COMMAND_CLUST),
         PARAM_CLUSTER_REASSIGN(PARAM_CLUSTER_REASSIGN_ID, "--cluster-reassign", "Cluster reassign", "Cascaded clustering can cluster sequence that do not fulfill the clustering criteria.\nCluster reassignment corrects these errors", typeid(bool), (void *) &clusterReassignment, "", MMseqsParameter::COMMAND_CLUST),
         PARAM_CLUSTER_SET_MODE(PARAM_CLUSTER_SET_MODE_ID, "--set-mode", "Set mode", "0: Cluster by each entry\n1: Cluster by set", typeid(bool), (void *) &clusteringSetMode, "[0-1]{1}$", MMseqsParameter::COMMAND_CLUST),
+        PARAM_CLUSTER_MISSING_LINKS(PARAM_CLUSTER_MISSING_LINKS_ID, "--cluster-missing-links", "Cluster missing links", "Greedy clustering also assigns members that only list the representative in their own result.\nReversed edges are sorted on disk, memory stays proportional to the number of sequences", typeid(bool), (void *) &clusterMissingLinks, "", MMseqsParameter::COMMAND_CLUST | MMseqsParameter::COMMAND_EXPERT),
         PARAM_CLUSTER_MODULE(PARAM_CLUSTER_MODULE_ID, "--cluster-module", "Cluster module", "0: Linclust\n1: Clust", typeid(int), (void *) &clusterModule, "^[0-1]{1}$", MMseqsParameter::COMMAND_CLUST | MMseqsParameter::COMMAND_CLUST),
         // affinity clustering
-        PARAM_MAXITERATIONS(PARAM_MAXITERATIONS_ID, "--max-iterations", "Max connected component depth", "Maximum depth of breadth first search in connected component clustering", typeid(int), (void *) &maxIteration, "^[1-9]{1}[0-9]*$", MMseqsParameter::COMMAND_CLUST | MMseqsParameter::COMMAND_EXPERT),
+        PARAM_MAXITERATIONS(PARAM_MAXITERATIONS_ID, "--max-iterations", "Max connected component depth", "Maximum depth of breadth first search in connected component clustering (0: unbounded, parallel union-find)", typeid(int), (void *) &maxIteration, "^[0-9]+$", MMseqsParameter::COMMAND_CLUST | MMseqsParameter::COMMAND_EXPERT),
         PARAM_SIMILARITYSCORE(PARAM_SIMILARITYSCORE_ID, "--similarity-type", "Similarity type", "Type of score used for clustering. 1: alignment score 2: sequence identity", typeid(int), (void *) &similarityScoreType, "^[1-2]{1}$", MMseqsParameter::COMMAND_CLUST | MMseqsParameter::COMMAND_EXPERT),
         // logging
         PARAM_V(PARAM_V_ID, "-v", "Verbosity", "Verbosity level: 0: quiet, 1: +errors, 2: +warnings, 3: +info", typeid(int), (void *) &verbosity, "^[0-3]{1}$", MMseqsParameter::COMMAND_COMMON),
@@ -164,6 +165,7 @@ Parameters::Parameters():
         PARAM_RESULT_DIRECTION(PARAM_RESULT_DIRECTION_ID, "--result-direction", "Result direction", "result is 0: query, 1: target centric", typeid(int), (void *) &resultDirection, "^[0-1]{1}$", MMseqsParameter::COMMAND_CLUSTLINEAR | MMseqsParameter::COMMAND_EXPERT),
         PARAM_WEIGHT_FILE(PARAM_WEIGHT_FILE_ID, "--weights", "Weight file name", "Weights used for cluster priorization", typeid(std::string), (void*) &weightFile, "", MMseqsParameter::COMMAND_CLUSTLINEAR | MMseqsParameter::COMMAND_EXPERT ),
         PARAM_WEIGHT_THR(PARAM_WEIGHT_THR_ID, "--cluster-weight-threshold", "Cluster Weight threshold", "Weight threshold used for cluster priorization", typeid(float), (void*) &weightThr, "^[0-9]*(\\.[0-9]+)?$", MMseqsParameter::COMMAND_CLUSTLINEAR | MMseqsParameter::COMMAND_EXPERT ),
+        PARAM_KMER_TABLE(PARAM_KMER_TABLE_ID, "--kmer-table", "k-mer table file", "Store the selected k-mers in this file and reuse them in runs with the same database and k-mer parameters", typeid(std::string), (void*) &kmerTableFile, "", MMseqsParameter::COMMAND_CLUSTLINEAR | MMseqsParameter::COMMAND_EXPERT ),
         // workflow
         PARAM_RUNNER(PARAM_RUNNER_ID, "--mpi-runner", "MPI runner", "Use MPI on compute cluster with this MPI command (e.g. \"mpirun -np 42\")", typeid(std::string), (void *) &runner, "", MMseqsParameter::COMMAND_COMMON | MMseqsParameter::COMMAND_EXPERT),
         PARAM_REUSELATEST(PARAM_REUSELATEST_ID, "--force-reuse", "Force restart with latest tmp", "Reuse tmp filse in tmp/latest folder ignoring parameters and version changes", typeid(bool), (void *) &reuseLatest, "", MMseqsParameter::COMMAND_COMMON | MMseqsParameter::COMMAND_EXPERT),
@@ -180,6 +182,8 @@ Parameters::Parameters():
         PARAM_ORF_FILTER_S(PARAM_ORF_FILTER_S_ID, "--orf-filter-s", "ORF filter sensitivity", "Sensitivity used for query ORF prefiltering", typeid(float), (void *) &orfFilterSens, "^[0-9]*(\\.[0-9]+)?$"),
         PARAM_ORF_FILTER_E(PARAM_ORF_FILTER_E_ID, "--orf-filter-e", "ORF filter e-value", "E-value threshold used for query ORF prefiltering", typeid(double), (void *) &orfFilterEval, "^([-+]?[0-9]*\\.?[0-9]+([eE][-+]?[0-9]+)?)|[0-9]*(\\.[0-9]+)?$"),
         PARAM_LCA_SEARCH(PARAM_LCA_SEARCH_ID, "--lca-search", "LCA search mode", "Efficient search for LCA candidates", typeid(bool), (void *) &lcaSearch, "", MMseqsParameter::COMMAND_PROFILE | MMseqsParameter::COMMAND_EXPERT),
+        PARAM_LCA_EARLY_EXIT(PARAM_LCA_EARLY_EXIT_ID, "--lca-early-exit", "LCA early exit", "Stop aligning hits of a query in the LCA search once the LCA of its accepted hits is the root", typeid(bool), (void *) &lcaEarlyExit, "", MMseqsParameter::COMMAND_ALIGN | MMseqsParameter::COMMAND_EXPERT),
+        PARAM_FUSED_PREFILTER_ALIGN(PARAM_FUSED_PREFILTER_ALIGN_ID, "--fused-prefilter-align", "Fused prefilter and alignment", "Align the prefilter hits of each query right away instead of writing the prefilter result to disk.\nOnly used for single step searches without target splits", typeid(bool), (void *) &fusedPrefilterAlign, "", MMseqsParameter::COMMAND_MISC | MMseqsParameter::COMMAND_EXPERT),
         PARAM_TRANSLATION_MODE(PARAM_TRANSLATION_MODE_ID, "--translation-mode", "Translation mode", "Translation AA seq from nucleotide by 0: ORFs, 1: full reading frames", typeid(int), (void *) &translationMode, "^[0-1]{1}$"),
         // easysearch
         PARAM_GREEDY_BEST_HITS(PARAM_GREEDY_BEST_HITS_ID, "--greedy-best-hits", "Greedy best hits", "Choose the best hits greedily to cover the query", typeid(bool), (void *) &greedyBestHits, ""),
@@ -200,6 +204,7 @@ Parameters::Parameters():
         PARAM_SEARCH_TYPE(PARAM_SEARCH_TYPE_ID, "--search-type", "Search type", "Search type 0: auto 1: amino acid, 2: translated, 3: nucleotide, 4: translated nucleotide alignment", typeid(int), (void *) &searchType, "^[0-4]{1}"),
         PARAM_INDEX_SUBSET(PARAM_INDEX_SUBSET_ID, "--index-subset", "Index subset", "Create specialized index with subset of entries\n0: normal index\n1: index without headers\n2: index without prefiltering data\n4: index without aln (for cluster db)\n8: no sequence lookup (good for GPU only searches)\nFlags can be combined bit wise", typeid(int), (void *) &indexSubset, "^[0-9]{1}[0-9]*$", MMseqsParameter::COMMAND_EXPERT),
         PARAM_INDEX_DBSUFFIX(PARAM_INDEX_DBSUFFIX_ID, "--index-dbsuffix", "Index dbsuffix", "A suffix of the db (used for cluster dbs)", typeid(std::string), (void *) &indexDbsuffix, "", MMseqsParameter::COMMAND_HIDDEN),
+        PARAM_INDEX_TAX_RANK(PARAM_INDEX_TAX_RANK_ID, "--index-tax-rank", "Index taxonomic rank", "Group the k-mer lists of the index by the clades of this rank (e.g. superkingdom), so searches with --taxon-list only read the matching clades. Requires a taxonomy DB", typeid(std::string), (void *) &indexTaxRank, "", MMseqsParameter::COMMAND_EXPERT),
         // createdb
         PARAM_USE_HEADER(PARAM_USE_HEADER_ID, "--use-fasta-header", "Use fasta header", "Use the id parsed from the fasta header as the index key instead of using incrementing numeric identifiers", typeid(bool), (void *) &useHeader, ""),
         PARAM_ID_OFFSET(PARAM_ID_OFFSET_ID, "--id-offset", "Offset of numeric ids", "Numeric ids in index file are offset by this value", typeid(int), (void *) &identifierOffset, "^(0|[1-9]{1}[0-9]*)$"),
@@ -273,6 +278,7 @@ Parameters::Parameters():
         // convertkb
         PARAM_KB_COLUMNS(PARAM_KB_COLUMNS_ID, "--kb-columns", "UniprotKB columns", "list of indices of UniprotKB columns to be extracted", typeid(std::string), (void *) &kbColumns, ""),
         PARAM_RECOVER_DELETED(PARAM_RECOVER_DELETED_ID, "--recover-deleted", "Recover deleted", "Find and recover deleted sequences during updating of clustering", typeid(bool), (void *) &recoverDeleted, ""),
+        PARAM_KEEP_REP_INDEX(PARAM_KEEP_REP_INDEX_ID, "--keep-rep-index", "Keep representative index", "Store the representative sequences and their precomputed index next to the updated clustering (<newClusteringDB>_rep)\nand reuse <oldClusteringDB>_rep instead of extracting all representatives again", typeid(bool), (void *) &keepRepIndex, ""),
         // filtertaxdb
         PARAM_TAXON_LIST(PARAM_TAXON_LIST_ID, "--taxon-list", "Selected taxa", "Taxonomy ID, possibly multiple values separated by ','", typeid(std::string), (void *) &taxonList, ""),
         // view
@@ -319,6 +325,7 @@ Parameters::Parameters():
         PARAM_TEMPERATURE(PARAM_TEMPERATURE_ID, "--temperature", "Temperature", "Temperature for forward-backward", typeid(float), (void *) &temperature, "^(0\\.[0-9]+|[1-9][0-9]*\\.?[0-9]*)$", MMseqsParameter::COMMAND_EXPERT),
         PARAM_BLOCKLEN(PARAM_BLOCKLEN_ID, "--blocklen", "Block length", "Block length for forward-backward", typeid(int), (void *) &blocklen, "^[1-9]{1}[0-9]*$", MMseqsParameter::COMMAND_EXPERT),
         PARAM_FWBW_BACKTRACE_MODE(PARAM_FWBW_BACKTRACE_MODE_ID, "--fwbw-backtrace-mode", "Backtrace mode", "Backtrace mode 0: no backtrace, 1: local", typeid(int), (void *) &fwbwBacktraceMode, "^[01]$", MMseqsParameter::COMMAND_EXPERT),
+        PARAM_FWBW_MARGIN(PARAM_FWBW_MARGIN_ID, "--fwbw-margin", "Region margin", "Restrict forward-backward to the input alignment region extended by this many residues (-1: full matrix)", typeid(int), (void *) &fwbwMargin, "^(-1|[0-9]+)$", MMseqsParameter::COMMAND_EXPERT),
         // touchdb
         PARAM_TOUCH_LOCK(PARAM_TOUCH_LOCK_ID, "--touch-lock", "Touch lock", "Lock touched database or database entries into memory. Process will not exit until killed.", typeid(bool), (void *) &touchLock, "", MMseqsParameter::COMMAND_EXPERT),
         // proteomecluster
@@ -431,6 +438,11 @@ Parameters::Parameters():
     align.push_back(&PARAM_COMPRESSED);
     align.push_back(&PARAM_V);
 
+    // lcaalign
+    lcaalign = align;
+    lcaalign.push_back(&PARAM_LCA_EARLY_EXIT);
+    lcaalign.push_back(&PARAM_BLACKLIST);
+
     // prefilter
     prefilter.push_back(&PARAM_SUB_MAT);
     prefilter.push_back(&PARAM_SEED_SUB_MAT);
@@ -513,6 +525,7 @@ Parameters::Parameters():
     clust.push_back(&PARAM_WEIGHT_FILE);
     clust.push_back(&PARAM_WEIGHT_THR);
     clust.push_back(&PARAM_CLUSTER_SET_MODE);
+    clust.push_back(&PARAM_CLUSTER_MISSING_LINKS);
 
     // rescorediagonal
     rescorediagonal.push_back(&PARAM_SUB_MAT);
@@ -831,6 +844,7 @@ Parameters::Parameters():
     indexdb.push_back(&PARAM_SPLIT);
     indexdb.push_back(&PARAM_SPLIT_MEMORY_LIMIT);
     indexdb.push_back(&PARAM_INDEX_SUBSET);
+    indexdb.push_back(&PARAM_INDEX_TAX_RANK);
     indexdb.push_back(&PARAM_V);
     indexdb.push_back(&PARAM_THREADS);
 
@@ -1049,6 +1063,7 @@ Parameters::Parameters():
     kmermatcher.push_back(&PARAM_V);
     kmermatcher.push_back(&PARAM_WEIGHT_FILE);
     kmermatcher.push_back(&PARAM_WEIGHT_THR);
+    kmermatcher.push_back(&PARAM_KMER_TABLE);
 
     // kmermatcher
     kmersearch.push_back(&PARAM_SEED_SUB_MAT);
@@ -1215,6 +1230,11 @@ Parameters::Parameters():
     createtaxdb.push_back(&PARAM_THREADS);
     createtaxdb.push_back(&PARAM_V);
 
+    // createtaxmapping
+    createtaxmapping.push_back(&PARAM_TAX_MAPPING_MODE);
+    createtaxmapping.push_back(&PARAM_THREADS);
+    createtaxmapping.push_back(&PARAM_V);
+
     // addtaxonomy
     addtaxonomy.push_back(&PARAM_TAXON_ADD_LINEAGE);
     addtaxonomy.push_back(&PARAM_LCA_RANKS);
@@ -1322,6 +1342,7 @@ Parameters::Parameters():
     fwbw.push_back(&PARAM_TEMPERATURE);
     fwbw.push_back(&PARAM_BLOCKLEN);
     fwbw.push_back(&PARAM_FWBW_BACKTRACE_MODE);
+    fwbw.push_back(&PARAM_FWBW_MARGIN);
     fwbw.push_back(&PARAM_E);
     fwbw.push_back(&PARAM_MIN_SEQ_ID);
     fwbw.push_back(&PARAM_MIN_ALN_LEN);
@@ -1368,6 +1389,8 @@ Parameters::Parameters():
     proteomecluster.push_back(&PARAM_V);
 
     // WORKFLOWS
+    prefilteralign = combineList(prefilter, align);
+
     searchworkflow = combineList(align, prefilter);
     searchworkflow = combineList(searchworkflow, ungappedprefilter);
     searchworkflow = combineList(searchworkflow, rescorediagonal);
@@ -1385,6 +1408,9 @@ Parameters::Parameters():
     searchworkflow.push_back(&PARAM_EXHAUSTIVE_SEARCH_FILTER);
     searchworkflow.push_back(&PARAM_STRAND);
     searchworkflow.push_back(&PARAM_LCA_SEARCH);
+    searchworkflow.push_back(&PARAM_LCA_EARLY_EXIT);
+    searchworkflow.push_back(&PARAM_BLACKLIST);
+    searchworkflow.push_back(&PARAM_FUSED_PREFILTER_ALIGN);
     searchworkflow.push_back(&PARAM_DISK_SPACE_LIMIT);
     searchworkflow.push_back(&PARAM_RUNNER);
     searchworkflow.push_back(&PARAM_REUSELATEST);
@@ -1492,7 +1518,8 @@ Parameters::Parameters():
     clusterUpdate.push_back(&PARAM_REUSELATEST);
     clusterUpdate.push_back(&PARAM_USESEQID);
     clusterUpdate.push_back(&PARAM_RECOVER_DELETED);
-    clusterUpdate = combineList(clusterUpdateSearch, clusterUpdateClust);
+    clusterUpdate.push_back(&PARAM_KEEP_REP_INDEX);
+    clusterUpdate = combineList(combineList(clusterUpdateSearch, clusterUpdateClust), clusterUpdate);
     clusterUpdate = removeParameter(clusterUpdate, PARAM_GPU);
     clusterUpdate = removeParameter(clusterUpdate, PARAM_GPU_SERVER);
     clusterUpdate = removeParameter(clusterUpdate, PARAM_GPU_SERVER_WAIT_TIMEOUT);
@@ -2433,6 +2460,8 @@ void Parameters::setDefaults() {
     orfFilterSens = 2.0;
     orfFilterEval = 100;
     lcaSearch = false;
+    lcaEarlyExit = false;
+    fusedPrefilterAlign = false;
     translationMode = PARAM_TRANSLATION_MODE_ORF;
 
     greedyBestHits = false;
@@ -2493,6 +2522,7 @@ void Parameters::setDefaults() {
     realignMaxSeqs = INT_MAX;
     correlationScoreWeight = 0.0;
     clusteringSetMode = 0;
+    clusterMissingLinks = false;
 
     // affinity clustering
     maxIteration=1000;
@@ -2514,6 +2544,7 @@ void Parameters::setDefaults() {
     searchType = SEARCH_TYPE_AUTO;
     indexSubset = INDEX_SUBSET_NORMAL;
     indexDbsuffix = "";
+    indexTaxRank = "";
 
     // createdb
     createdbMode = SEQUENCE_SPLIT_MODE_HARD;
@@ -2647,6 +2678,10 @@ void Parameters::setDefaults() {
     // diff
     useSequenceId = false;
 
+    // clusterupdate
+    recoverDeleted = false;
+    keepRepIndex = false;
+
     // prefixid
     prefix = "";
     tsvOut = false;
@@ -2689,6 +2724,7 @@ void Parameters::setDefaults() {
     resultDirection = Parameters::PARAM_RESULT_DIRECTION_TARGET;
     weightThr = 0.9;
     weightFile = "";
+    kmerTableFile = "";
 
     // result2stats
     stat = "";
@@ -2762,6 +2798,7 @@ void Parameters::setDefaults() {
     temperature = 1;
     blocklen = 16;
     fwbwBacktraceMode = 1;
+    fwbwMargin = -1;
 
     // touchdb
     touchLock = false;
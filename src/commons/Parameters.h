@@ -204,6 +204,7 @@ public:
     static const int CONNECTED_COMPONENT = 1;
     static const int GREEDY = 2;
     static const int GREEDY_MEM = 3;
+    static const int SET_COVER_PARALLEL = 4;
 
     // clustering
     static const int APC_ALIGNMENTSCORE=1;
@@ -479,6 +480,7 @@ public:
     bool   singleStepClustering;
     int    clusterReassignment;
     bool    clusteringSetMode;
+    bool    clusterMissingLinks;
     int    clusterModule;
 
     // SEARCH WORKFLOW
@@ -493,6 +495,8 @@ public:
     float orfFilterSens;
     double orfFilterEval;
     bool lcaSearch;
+    bool lcaEarlyExit;
+    bool fusedPrefilterAlign;
     int translationMode;
 
     // easysearch
@@ -580,12 +584,14 @@ public:
     int resultDirection;
     float weightThr;
     std::string weightFile;
+    std::string kmerTableFile;
 
     // indexdb
     int checkCompatible;
     int searchType;
     int indexSubset;
     std::string indexDbsuffix;
+    std::string indexTaxRank;
 
     // createdb
     int identifierOffset;
@@ -679,6 +685,7 @@ public:
 
     // clusterUpdate;
     bool recoverDeleted;
+    bool keepRepIndex;
 
     // summarize headers
     int headerType;
@@ -742,6 +749,7 @@ public:
     float temperature;
     int blocklen;
     int fwbwBacktraceMode;
+    int fwbwMargin;
 
     // touchdb
     bool touchLock;
@@ -853,6 +861,7 @@ public:
     PARAMETER(PARAM_CASCADED)
     PARAMETER(PARAM_CLUSTER_REASSIGN)
     PARAMETER(PARAM_CLUSTER_SET_MODE)
+    PARAMETER(PARAM_CLUSTER_MISSING_LINKS)
     PARAMETER(PARAM_CLUSTER_MODULE)
 
     // affinity clustering
@@ -930,6 +939,7 @@ public:
     PARAMETER(PARAM_RESULT_DIRECTION)
     PARAMETER(PARAM_WEIGHT_FILE)
     PARAMETER(PARAM_WEIGHT_THR)
+    PARAMETER(PARAM_KMER_TABLE)
 
     // workflow
     PARAMETER(PARAM_RUNNER)
@@ -947,6 +957,8 @@ public:
     PARAMETER(PARAM_ORF_FILTER_S)
     PARAMETER(PARAM_ORF_FILTER_E)
     PARAMETER(PARAM_LCA_SEARCH)
+    PARAMETER(PARAM_LCA_EARLY_EXIT)
+    PARAMETER(PARAM_FUSED_PREFILTER_ALIGN)
     PARAMETER(PARAM_TRANSLATION_MODE)
 
     // easysearch
@@ -970,6 +982,7 @@ public:
     PARAMETER(PARAM_SEARCH_TYPE)
     PARAMETER(PARAM_INDEX_SUBSET)
     PARAMETER(PARAM_INDEX_DBSUFFIX)
+    PARAMETER(PARAM_INDEX_TAX_RANK)
 
     // createdb
     PARAMETER(PARAM_USE_HEADER) // also used by extractorfs
@@ -1067,6 +1080,7 @@ public:
 
     // clusterupdate
     PARAMETER(PARAM_RECOVER_DELETED)
+    PARAMETER(PARAM_KEEP_REP_INDEX)
 
     // filtertaxdb, filtertaxseqdb
     PARAMETER(PARAM_TAXON_LIST)
@@ -1127,6 +1141,7 @@ public:
     PARAMETER(PARAM_TEMPERATURE)
     PARAMETER(PARAM_BLOCKLEN)
     PARAMETER(PARAM_FWBW_BACKTRACE_MODE)
+    PARAMETER(PARAM_FWBW_MARGIN)
 
     // touchdb
     PARAMETER(PARAM_TOUCH_LOCK)
@@ -1167,6 +1182,8 @@ public:
 
     std::vector<MMseqsParameter*> alignall;
     std::vector<MMseqsParameter*> align;
+    std::vector<MMseqsParameter*> lcaalign;
+    std::vector<MMseqsParameter*> prefilteralign;
     std::vector<MMseqsParameter*> rescorediagonal;
     std::vector<MMseqsParameter*> alignbykmer;
     std::vector<MMseqsParameter*> createFasta;
@@ -1250,6 +1267,7 @@ public:
     std::vector<MMseqsParameter*> createsubdb;
     std::vector<MMseqsParameter*> renamedbkeys;
     std::vector<MMseqsParameter*> createtaxdb;
+    std::vector<MMseqsParameter*> createtaxmapping;
     std::vector<MMseqsParameter*> profile2pssm;
     std::vector<MMseqsParameter*> profile2neff;
     std::vector<MMseqsParameter*> profile2seq;
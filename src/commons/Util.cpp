@@ -17,6 +17,7 @@
 #include "simd.h"
 #include "MemoryMapped.h"
 #include "MemoryTracker.h"
+#include "MappingReader.h"
 #include <algorithm>
 #include <sys/mman.h>
 #include <fstream>      // std::ifstream
@@ -35,6 +36,13 @@ int Util::readMapping(std::string mappingFilename, std::vector<std::pair<unsigne
         EXIT(EXIT_FAILURE);
     }
 
+    if (MappingReader::isBinary((char *) indexData.getData(), indexData.size())) {
+        indexData.close();
+        MappingReader reader(mappingFilename, false);
+        reader.getMapping(mapping);
+        return true;
+    }
+
     size_t currPos = 0;
     char* indexDataChar = (char *) indexData.getData();
     const char* cols[3];
@@ -423,33 +423,164 @@ template void swapCenterSequence<0, int>(KmerPosition<int> *kmers, size_t splitK
 template void swapCenterSequence<1, short>(KmerPosition<short> *kmers, size_t splitKmerCount, SequenceWeights &seqWeights);
 template void swapCenterSequence<1, int>(KmerPosition<int> *kmers, size_t splitKmerCount, SequenceWeights &seqWeights);
 
+// checksum over the index entries and all data files, so that a changed database with
+// the same number of entries and residues does not reuse an outdated table
+static uint64_t databaseChecksum(DBReader<unsigned int> &seqDbr) {
+    uint64_t checksum = 0;
+    const size_t blockEntries = 4096;
+    std::vector<uint64_t> block;
+    block.reserve(blockEntries * 3);
+    DBReader<unsigned int>::Index *index = seqDbr.getIndex();
+    for (size_t i = 0; i < seqDbr.getSize(); i++) {
+        block.push_back(index[i].id);
+        block.push_back(index[i].offset);
+        block.push_back(index[i].length);
+        if (block.size() == blockEntries * 3 || i + 1 == seqDbr.getSize()) {
+            checksum = XXH64(block.data(), block.size() * sizeof(uint64_t), checksum);
+            block.clear();
+        }
+    }
+    for (size_t i = 0; i < seqDbr.getDataFileCnt(); i++) {
+        if (seqDbr.getDataForFile(i) != NULL) {
+            checksum = XXH64(seqDbr.getDataForFile(i), seqDbr.getDataSizeForFile(i), checksum);
+        }
+    }
+    return checksum;
+}
+
+// The selected k-mers only depend on the sequences and the k-mer selection parameters, not on the
+// clustering thresholds. The signature identifies the database and these parameters.
+template <typename T>
+std::string kmerTableSignature(DBReader<unsigned int> &seqDbr, Parameters &par, BaseMatrix *subMat,
+                               size_t hashStartRange, size_t hashEndRange) {
+    std::string signature;
+    signature.append("version:2");
+    signature.append(" entry:" + SSTR(sizeof(KmerPosition<T>)));
+    signature.append(" dbtype:" + SSTR(seqDbr.getDbtype()));
+    signature.append(" size:" + SSTR(seqDbr.getSize()));
+    signature.append(" residues:" + SSTR(seqDbr.getAminoAcidDBSize()));
+    signature.append(" lastkey:" + SSTR(seqDbr.getLastKey()));
+    signature.append(" checksum:" + SSTR(databaseChecksum(seqDbr)));
+    signature.append(" k:" + SSTR(par.kmerSize));
+    signature.append(" alphabet:" + SSTR(subMat->alphabetSize));
+    signature.append(" matrix:" + par.scoringMatrixFile.values.nucleotide() + "," + par.scoringMatrixFile.values.aminoacid());
+    signature.append(" kmerperseq:" + SSTR(par.kmersPerSequence));
+    signature.append(" kmerperseqscale:" + SSTR(par.kmersPerSequenceScale.values.nucleotide()) + "," + SSTR(par.kmersPerSequenceScale.values.aminoacid()));
+    signature.append(" spaced:" + SSTR(par.spacedKmer) + "," + par.spacedKmerPattern);
+    signature.append(" adjust:" + SSTR(par.adjustKmerLength));
+    signature.append(" mask:" + SSTR(par.maskMode) + "," + SSTR(par.maskProb) + "," + SSTR(par.maskLowerCaseMode) + "," + SSTR(par.maskNrepeats));
+    signature.append(" hashshift:" + SSTR(par.hashShift));
+    signature.append(" ignoremulti:" + SSTR(par.ignoreMultiKmer));
+    signature.append(" picknbest:" + SSTR(par.pickNbest));
+    signature.append(" maxseqlen:" + SSTR(par.maxSeqLen));
+    signature.append(" range:" + SSTR(hashStartRange) + "-" + SSTR(hashEndRange));
+    return signature;
+}
+
+// file layout: signature length, signature, k-mer count, adjusted k-mer length, sorted k-mers
+template <typename T>
+bool readKmerTable(const std::string &tableFile, const std::string &signature, KmerPosition<T> *hashSeqPair,
+                   size_t kmerArraySize, size_t &elements, size_t &kmerSize) {
+    if (FileUtil::fileExists(tableFile.c_str()) == false) {
+        return false;
+    }
+    FILE *handle = FileUtil::openFileOrDie(tableFile.c_str(), "rb", true);
+    bool valid = false;
+    size_t signatureLength;
+    if (fread(&signatureLength, sizeof(size_t), 1, handle) == 1 && signatureLength == signature.size()) {
+        std::string fileSignature(signatureLength, '\0');
+        size_t header[2];
+        valid = fread(&fileSignature[0], sizeof(char), signatureLength, handle) == signatureLength
+                && fileSignature == signature
+                && fread(header, sizeof(size_t), 2, handle) == 2
+                && header[0] <= kmerArraySize
+                && fread(hashSeqPair, sizeof(KmerPosition<T>), header[0], handle) == header[0];
+        if (valid) {
+            elements = header[0];
+            kmerSize = header[1];
+        }
+    }
+    if (fclose(handle) != 0) {
+        Debug(Debug::ERROR) << "Cannot close file " << tableFile << "\n";
+        EXIT(EXIT_FAILURE);
+    }
+    if (valid == false) {
+        Debug(Debug::WARNING) << "k-mer table " << tableFile << " was created from a different database or with different parameters and will be recomputed\n";
+    }
+    return valid;
+}
+
+template <typename T>
+void writeKmerTable(const std::string &tableFile, const std::string &signature, KmerPosition<T> *hashSeqPair,
+                    size_t elements, size_t kmerSize) {
+    std::string tmpFile = tableFile + ".tmp";
+    FILE *handle = FileUtil::openAndDelete(tmpFile.c_str(), "wb");
+    size_t signatureLength = signature.size();
+    size_t header[2] = { elements, kmerSize };
+    if (fwrite(&signatureLength, sizeof(size_t), 1, handle) != 1
+        || fwrite(signature.c_str(), sizeof(char), signatureLength, handle) != signatureLength
+        || fwrite(header, sizeof(size_t), 2, handle) != 2
+        || fwrite(hashSeqPair, sizeof(KmerPosition<T>), elements, handle) != elements) {
+        Debug(Debug::ERROR) << "Cannot write k-mer table " << tableFile << "\n";
+        EXIT(EXIT_FAILURE);
+    }
+    if (fclose(handle) != 0) {
+        Debug(Debug::ERROR) << "Cannot close file " << tmpFile << "\n";
+        EXIT(EXIT_FAILURE);
+    }
+    // only a complete table replaces an old one
+    FileUtil::move(tmpFile.c_str(), tableFile.c_str());
+}
+
 template <typename T>
 KmerPosition<T> * doComputation(size_t totalKmers, size_t hashStartRange, size_t hashEndRange, std::string splitFile,
                                 DBReader<unsigned int> & seqDbr, Parameters & par, BaseMatrix  * subMat) {
 
     KmerPosition<T> * hashSeqPair = initKmerPositionMemory<T>(totalKmers);
-    size_t elementsToSort;
-    if(Parameters::isEqualDbtype(seqDbr.getDbtype(), Parameters::DBTYPE_NUCLEOTIDES)){
-        std::pair<size_t, size_t > ret = fillKmerPositionArray<Parameters::DBTYPE_NUCLEOTIDES, T>(hashSeqPair, totalKmers, seqDbr, par, subMat, true, hashStartRange, hashEndRange, NULL);
-        elementsToSort = ret.first;
-        par.kmerSize = ret.second;
-        Debug(Debug::INFO) << "\nAdjusted k-mer length " << par.kmerSize << "\n";
-    }else{
-        std::pair<size_t, size_t > ret = fillKmerPositionArray<Parameters::DBTYPE_AMINO_ACIDS, T>(hashSeqPair, totalKmers, seqDbr, par, subMat, true, hashStartRange, hashEndRange, NULL);
-        elementsToSort = ret.first;
-    }
-    if(hashEndRange == SIZE_T_MAX){
-        seqDbr.unmapData();
+    size_t elementsToSort = 0;
+    std::string tableFile;
+    std::string tableSignature;
+    if (par.kmerTableFile.empty() == false) {
+        tableFile = (hashEndRange == SIZE_T_MAX) ? par.kmerTableFile : par.kmerTableFile + "_" + SSTR(hashStartRange);
+        tableSignature = kmerTableSignature<T>(seqDbr, par, subMat, hashStartRange, hashEndRange);
     }
+    size_t tableKmerSize = 0;
+    if (tableFile.empty() == false && readKmerTable<T>(tableFile, tableSignature, hashSeqPair, totalKmers, elementsToSort, tableKmerSize)) {
+        Debug(Debug::INFO) << "Use k-mer table " << tableFile << "\n";
+        if(Parameters::isEqualDbtype(seqDbr.getDbtype(), Parameters::DBTYPE_NUCLEOTIDES)){
+            par.kmerSize = tableKmerSize;
+            Debug(Debug::INFO) << "Adjusted k-mer length " << par.kmerSize << "\n";
+        }
+        if(hashEndRange == SIZE_T_MAX){
+            seqDbr.unmapData();
+        }
+    } else {
+        if(Parameters::isEqualDbtype(seqDbr.getDbtype(), Parameters::DBTYPE_NUCLEOTIDES)){
+            std::pair<size_t, size_t > ret = fillKmerPositionArray<Parameters::DBTYPE_NUCLEOTIDES, T>(hashSeqPair, totalKmers, seqDbr, par, subMat, true, hashStartRange, hashEndRange, NULL);
+            elementsToSort = ret.first;
+            par.kmerSize = ret.second;
+            Debug(Debug::INFO) << "\nAdjusted k-mer length " << par.kmerSize << "\n";
+        }else{
+            std::pair<size_t, size_t > ret = fillKmerPositionArray<Parameters::DBTYPE_AMINO_ACIDS, T>(hashSeqPair, totalKmers, seqDbr, par, subMat, true, hashStartRange, hashEndRange, NULL);
+            elementsToSort = ret.first;
+        }
+        if(hashEndRange == SIZE_T_MAX){
+            seqDbr.unmapData();
+        }
 
-    Debug(Debug::INFO) << "Sort kmer ";
-    Timer timer;
-    if(Parameters::isEqualDbtype(seqDbr.getDbtype(), Parameters::DBTYPE_NUCLEOTIDES)) {
-        SORT_PARALLEL(hashSeqPair, hashSeqPair + elementsToSort, KmerPosition<T>::compareRepSequenceAndIdAndPosReverse);
-    }else{
-        SORT_PARALLEL(hashSeqPair, hashSeqPair + elementsToSort, KmerPosition<T>::compareRepSequenceAndIdAndPos);
+        Debug(Debug::INFO) << "Sort kmer ";
+        Timer timer;
+        if(Parameters::isEqualDbtype(seqDbr.getDbtype(), Parameters::DBTYPE_NUCLEOTIDES)) {
+            SORT_PARALLEL(hashSeqPair, hashSeqPair + elementsToSort, KmerPosition<T>::compareRepSequenceAndIdAndPosReverse);
+        }else{
+            SORT_PARALLEL(hashSeqPair, hashSeqPair + elementsToSort, KmerPosition<T>::compareRepSequenceAndIdAndPos);
+        }
+        Debug(Debug::INFO) << timer.lap() << "\n";
+
+        if (tableFile.empty() == false) {
+            writeKmerTable<T>(tableFile, tableSignature, hashSeqPair, elementsToSort, par.kmerSize);
+        }
     }
-    Debug(Debug::INFO) << timer.lap() << "\n";
 
     SequenceWeights *sequenceWeights = NULL;
     // use priority information to swap center sequences
@@ -477,7 +608,7 @@ KmerPosition<T> * doComputation(size_t totalKmers, size_t hashStartRange, size_t
 
     // sort by rep. sequence (stored in kmer) and sequence id
     Debug(Debug::INFO) << "Sort by rep. sequence ";
-    timer.reset();
+    Timer timer;
     if(Parameters::isEqualDbtype(seqDbr.getDbtype(), Parameters::DBTYPE_NUCLEOTIDES)){
         SORT_PARALLEL(hashSeqPair, hashSeqPair + writePos, KmerPosition<T>::compareRepSequenceAndIdAndDiagReverse);
     }else{
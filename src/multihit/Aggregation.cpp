@@ -1,6 +1,9 @@
 #include "Aggregation.h"
 #include "Util.h"
 #include "Debug.h"
+#include "FastSort.h"
+
+#include <fast_float/fast_float.h>
 
 #ifdef OPENMP
 #include <omp.h>
@@ -20,28 +23,60 @@ Aggregation::~Aggregation() {
     delete targetSetReader;
 }
 
-// build a map with the value in [target column] field as a key and the rest of the line, cut in fields, as values
-void Aggregation::buildMap(char *data, int thread_idx, std::map<unsigned int, std::vector<std::vector<std::string>>> &dataToAggregate) {
+void AggregationHits::sortBySet() {
+    bool isSorted = true;
+    for (size_t i = 1; i < setKey.size() && isSorted; i++) {
+        isSorted = setKey[i - 1] <= setKey[i];
+    }
+    if (isSorted) {
+        return;
+    }
+
+    order.resize(setKey.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        order[i] = i;
+    }
+    const std::vector<unsigned int> &keys = setKey;
+    SORT_SERIAL(order.begin(), order.end(), [&keys](size_t a, size_t b) {
+        return keys[a] < keys[b] || (keys[a] == keys[b] && a < b);
+    });
+    permute(setKey, tmpKeys);
+    permute(targetKey, tmpKeys);
+    permute(evalue, tmpValues);
+    permute(score, tmpValues);
+    permute(line, tmpLines);
+}
+
+// parse the target key, set key, e-value and score of each line into the columns of hits and group them by set
+void Aggregation::buildMap(char *data, int thread_idx, AggregationHits &hits) {
+    const char *fields[4];
     while (*data != '\0') {
         char *current = data;
         data = Util::skipLine(data);
-        size_t length = data - current;
-        std::string line(current, length - 1);
-        if (line.empty() == true) {
+        if (*current == '\n') {
             continue;
         }
 
-        std::vector<std::string> columns = Util::split(line, "\t");
-        unsigned int targetKey = Util::fast_atoi<unsigned int>(columns[0].c_str());
+        const size_t columns = Util::getFieldsOfLine(current, fields, 4);
+        unsigned int targetKey = Util::fast_atoi<unsigned int>(fields[0]);
         size_t setId = targetSetReader->getId(targetKey);
         if (setId == UINT_MAX) {
-            Debug(Debug::ERROR) << "Invalid target database key " << columns[0] << ".\n";
+            Debug(Debug::ERROR) << "Invalid target database key " << std::string(fields[0], Util::skipNonTab(fields[0])) << ".\n";
             EXIT(EXIT_FAILURE);
         }
-        char *data = targetSetReader->getData(setId, thread_idx);
-        unsigned int setKey = Util::fast_atoi<unsigned int>(data);
-        dataToAggregate[setKey].push_back(columns);
+        char *setData = targetSetReader->getData(setId, thread_idx);
+        unsigned int setKey = Util::fast_atoi<unsigned int>(setData);
+        double score = 0.0;
+        if (columns > 1) {
+            fast_float::from_chars(fields[1], fields[1] + Util::skipNonTab(fields[1]), score);
+        }
+        double evalue = 0.0;
+        if (columns > 3) {
+            fast_float::from_chars(fields[3], fields[3] + Util::skipNonTab(fields[3]), evalue);
+        }
+        hits.push_back(setKey, targetKey, evalue, score, current);
     }
+    hits.sortBySet();
 }
 
 int Aggregation::run() {
@@ -63,22 +98,26 @@ int Aggregation::run() {
         std::string buffer;
         buffer.reserve(10 * 1024);
 
-        std::map<unsigned int, std::vector<std::vector<std::string>>> dataToMerge;
+        AggregationHits hits;
 #pragma omp for
         for (size_t i = 0; i < reader.getSize(); i++) {
             progress.updateProgress();
-            dataToMerge.clear();
+            hits.clear();
 
             unsigned int key = reader.getDbKey(i);
-            buildMap(reader.getData(i, thread_idx), thread_idx, dataToMerge);
+            buildMap(reader.getData(i, thread_idx), thread_idx, hits);
             prepareInput(key, thread_idx);
-            
-            for (std::map<unsigned int, std::vector<std::vector<std::string>>>::const_iterator it = dataToMerge.begin();
-                 it != dataToMerge.end(); ++it) {
-                unsigned int targetKey = it->first;
-                std::vector<std::vector<std::string>> columns = it->second;
-                buffer.append(aggregateEntry(columns, key, targetKey, thread_idx));
+
+            size_t begin = 0;
+            while (begin < hits.size()) {
+                unsigned int targetSetKey = hits.setKey[begin];
+                size_t end = begin + 1;
+                while (end < hits.size() && hits.setKey[end] == targetSetKey) {
+                    end++;
+                }
+                buffer.append(aggregateEntry(hits, begin, end, key, targetSetKey, thread_idx));
                 buffer.append("\n");
+                begin = end;
             }
             writer.writeData(buffer.c_str(), buffer.length(), key, thread_idx);
             buffer.clear();
@@ -5,7 +5,57 @@
 #include "DBWriter.h"
 
 #include <vector>
-#include <map>
+
+// Hits of one result entry with one array per column, sorted by the set of their target.
+// The arrays are reused for all entries, only line points into the result data to read the remaining columns.
+class AggregationHits {
+public:
+    std::vector<unsigned int> setKey;
+    std::vector<unsigned int> targetKey;
+    // column 4 of the result line
+    std::vector<double> evalue;
+    // column 2 of the result line
+    std::vector<double> score;
+    std::vector<const char *> line;
+
+    size_t size() const {
+        return setKey.size();
+    }
+
+    void clear() {
+        setKey.clear();
+        targetKey.clear();
+        evalue.clear();
+        score.clear();
+        line.clear();
+    }
+
+    void push_back(unsigned int set, unsigned int target, double eval, double sc, const char *ln) {
+        setKey.push_back(set);
+        targetKey.push_back(target);
+        evalue.push_back(eval);
+        score.push_back(sc);
+        line.push_back(ln);
+    }
+
+    // hits of the same set keep their input order
+    void sortBySet();
+
+private:
+    std::vector<size_t> order;
+    std::vector<unsigned int> tmpKeys;
+    std::vector<double> tmpValues;
+    std::vector<const char *> tmpLines;
+
+    template <typename T>
+    void permute(std::vector<T> &column, std::vector<T> &tmp) {
+        tmp.resize(column.size());
+        for (size_t i = 0; i < order.size(); i++) {
+            tmp[i] = column[order[i]];
+        }
+        column.swap(tmp);
+    }
+};
 
 class Aggregation {
 public:
@@ -16,7 +66,8 @@ public:
 
     int run();
     virtual void prepareInput(unsigned int querySetKey, unsigned int thread_idx) = 0;
-    virtual std::string aggregateEntry(std::vector<std::vector<std::string>> &dataToAggregate, unsigned int querySetKey, unsigned int targetSetKey, unsigned int thread_idx) = 0;
+    // aggregate the hits [begin, end) that all belong to targetSetKey
+    virtual std::string aggregateEntry(const AggregationHits &hits, size_t begin, size_t end, unsigned int querySetKey, unsigned int targetSetKey, unsigned int thread_idx) = 0;
 
 protected:
     std::string resultDbName;
@@ -25,7 +76,7 @@ protected:
     unsigned int threads;
     unsigned int compressed;
 
-    void buildMap(char *data, int thread_idx, std::map<unsigned int, std::vector<std::vector<std::string>>> &dataToAggregate);
+    void buildMap(char *data, int thread_idx, AggregationHits &hits);
 };
 
 #endif
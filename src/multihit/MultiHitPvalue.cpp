@@ -0,0 +1,83 @@
+#include "MultiHitPvalue.h"
+#include "Util.h"
+
+#include <cmath>
+
+// terms smaller than exp(-SKIP_LOG_DIFF) times the largest term do not change the sum in double precision
+static const double SKIP_LOG_DIFF = 50.0;
+
+static double LBinCoeff(const double *lookup, int M, int k) {
+    return lookup[M + 1] - lookup[M - k + 1] - lookup[k + 1];
+}
+
+MultiHitPvalue::MultiHitPvalue(unsigned int maxOrfCount, const double *lGammaLookup)
+        : lGammaLookup(lGammaLookup), orfCount(0), pvalThreshold(0.0) {
+    coefficients = new(std::nothrow) double[maxOrfCount + 1];
+    Util::checkAllocation(coefficients, "Can not allocate coefficients memory in MultiHitPvalue");
+}
+
+MultiHitPvalue::~MultiHitPvalue() {
+    delete[] coefficients;
+}
+
+void MultiHitPvalue::precomputeLogB(const unsigned int orfCount, const double pvalThreshold, const double *lGammaLookup, double *logB) {
+    double logPvalThr = log(pvalThreshold);
+    double log1MinusPvalThr = log(1 - pvalThreshold);
+    logB[orfCount - 1] = orfCount * logPvalThr;
+    for (int i = (orfCount - 2); i >= 0; i--){
+        int k = i + 1;
+        double log_newTerm = LBinCoeff(lGammaLookup, orfCount, k) + k * logPvalThr + (orfCount - k) * log1MinusPvalThr;
+        logB[i] = logB[i + 1] + log(1 + exp(log_newTerm - logB[i+1]));
+    }
+}
+
+void MultiHitPvalue::prepare(unsigned int count, double threshold) {
+    if (count == orfCount && threshold == pvalThreshold) {
+        return;
+    }
+    orfCount = count;
+    pvalThreshold = threshold;
+    if (orfCount == 0) {
+        return;
+    }
+    precomputeLogB(orfCount, pvalThreshold, lGammaLookup, coefficients);
+    for (size_t i = 0; i < orfCount; ++i) {
+        coefficients[i] -= lGammaLookup[i + 1];
+    }
+}
+
+double MultiHitPvalue::evaluate(double r) const {
+    if (orfCount == 0) {
+        return 0.0;
+    }
+    const double logR = log(r);
+    // B[i] is the tail of a binomial distribution and r^i / i! a poisson term, both are log-concave in i.
+    // The terms rise to a single maximum and then fall, so only the terms around it have to be summed.
+    size_t lo = 0;
+    size_t hi = orfCount - 1;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (logR + coefficients[mid + 1] - coefficients[mid] > 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    const double maxTerm = lo * logR + coefficients[lo];
+    double sum = 1.0;
+    for (size_t i = lo + 1; i < orfCount; ++i) {
+        double diff = i * logR + coefficients[i] - maxTerm;
+        if (diff < -SKIP_LOG_DIFF) {
+            break;
+        }
+        sum += exp(diff);
+    }
+    for (size_t i = lo; i > 0; --i) {
+        double diff = (i - 1) * logR + coefficients[i - 1] - maxTerm;
+        if (diff < -SKIP_LOG_DIFF) {
+            break;
+        }
+        sum += exp(diff);
+    }
+    return exp(maxTerm - r) * sum;
+}
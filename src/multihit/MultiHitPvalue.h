@@ -0,0 +1,32 @@
+#ifndef MMSEQS_MULTIHITPVALUE_H
+#define MMSEQS_MULTIHITPVALUE_H
+
+#include <cstddef>
+
+// Multi-hit p-value of a query set with orfCount ORFs against one target set:
+//   P(r) = exp(-r) * sum_{i < orfCount} r^i / i! * B[i]
+// B[i] only depends on the ORF count, so the coefficients are shared by all target sets of a query set
+// and are only recomputed when the ORF count of the next query set differs.
+class MultiHitPvalue {
+public:
+    // lGammaLookup[i] = lgamma(i) for i < maxOrfCount + 2
+    MultiHitPvalue(unsigned int maxOrfCount, const double *lGammaLookup);
+    ~MultiHitPvalue();
+
+    // Precompute coefficients logB[i] = log(B[i])
+    static void precomputeLogB(unsigned int orfCount, double pvalThreshold, const double *lGammaLookup, double *logB);
+
+    void prepare(unsigned int orfCount, double pvalThreshold);
+
+    // expects a finite r > 0
+    double evaluate(double r) const;
+
+private:
+    const double *lGammaLookup;
+    // log(B[i]) - log(i!)
+    double *coefficients;
+    unsigned int orfCount;
+    double pvalThreshold;
+};
+
+#endif
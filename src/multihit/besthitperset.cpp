@@ -26,7 +26,7 @@ public :
 
     void prepareInput(unsigned int, unsigned int) {}
 
-    std::string aggregateEntry(std::vector<std::vector<std::string>> &dataToAggregate, unsigned int, unsigned int targetSetKey, unsigned int thread_idx)  {
+    std::string aggregateEntry(const AggregationHits &hits, size_t begin, size_t end, unsigned int, unsigned int targetSetKey, unsigned int thread_idx)  {
         double bestScore = -DBL_MAX;
         double secondBestScore = -DBL_MAX;
         double bestEval = DBL_MAX;
@@ -35,7 +35,6 @@ public :
         double logCorrectedPval = 0;
 
         // Look for the lowest p-value and retain only this line
-        // dataToAggregate = [nbrTargetGene][Field of result]
         size_t targetId = targetSizeReader->getId(targetSetKey);
         if (targetId == UINT_MAX) {
             Debug(Debug::ERROR) << "Invalid target size database key " << targetSetKey << ".\n";
@@ -44,9 +43,10 @@ public :
         char *data = targetSizeReader->getData(targetId, thread_idx);
         unsigned int nbrGenes = Util::fast_atoi<unsigned int>(data);
 
-        std::vector<std::string> *bestEntry = NULL;
-        for (size_t i = 0; i < dataToAggregate.size(); i++) {
-            double eval = strtod(dataToAggregate[i][3].c_str(), NULL);
+        const size_t hitCount = end - begin;
+        const char *bestEntry = NULL;
+        for (size_t i = begin; i < end; i++) {
+            double eval = hits.evalue[i];
             double pval = eval/nbrGenes;
             //prevent log(0)
             if (pval == 0) {
@@ -55,17 +55,17 @@ public :
             double score = -log(pval);
 
             //if only one hit use simple best hit
-            if(simpleBestHitMode ||dataToAggregate.size() < 2) {
+            if(simpleBestHitMode || hitCount < 2) {
                 if(bestEval > eval){
                     bestEval = eval;
-                    bestEntry = &dataToAggregate[i];
+                    bestEntry = hits.line[i];
                 }
             }
             else {
                 if (score >= bestScore) {
                     secondBestScore = bestScore;
                     bestScore = score;
-                    bestEntry = &dataToAggregate[i];
+                    bestEntry = hits.line[i];
                 } 
                 else if (score > secondBestScore) {
                     secondBestScore = score;
@@ -74,7 +74,7 @@ public :
         }
 
 
-        if (simpleBestHitMode ||dataToAggregate.size() < 2) {
+        if (simpleBestHitMode || hitCount < 2) {
             if(bestEval == 0) {
                 logCorrectedPval = log(DBL_MIN)-logBestHitCalibration;
             }
@@ -98,15 +98,17 @@ public :
         buffer.reserve(1024);
 
         // Aggregate the full line into string
-        for (size_t i = 0; i < bestEntry->size(); ++i) {
+        const char *fields[255];
+        const size_t columns = Util::getFieldsOfLine(bestEntry, fields, 255);
+        for (size_t i = 0; i < columns; ++i) {
             if (i == 1) {
                 char tmpBuf[15];
                 snprintf(tmpBuf, sizeof(tmpBuf), "%.3E", logCorrectedPval);
                 buffer.append(tmpBuf);
             } else {
-                buffer.append(bestEntry->at(i));
+                buffer.append(fields[i], Util::skipNonTab(fields[i]));
             }
-            if (i != (bestEntry->size() - 1)) {
+            if (i != (columns - 1)) {
                 buffer.append(1, '\t');
             }
         }
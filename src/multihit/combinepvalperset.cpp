@@ -1,6 +1,7 @@
 #include "Debug.h"
 #include "Parameters.h"
 #include "Aggregation.h"
+#include "MultiHitPvalue.h"
 #include "itoa.h"
 #include "Util.h"
 
@@ -9,23 +10,6 @@
 #endif
 
 
-double LBinCoeff(double* lookup, int M, int k) {
-    return lookup[M + 1] - lookup[M - k + 1] - lookup[k + 1];
-}
-
-// Precompute coefficients logB[i] = log(B[i])
-void precomputeLogB(const unsigned int orfCount, const double pvalThreshold, double* lGammaLookup, double *logB) { 
-    double logPvalThr = log(pvalThreshold);
-    double log1MinusPvalThr = log(1 - pvalThreshold);
-    logB[orfCount - 1] = orfCount * logPvalThr;
-    for (int i = (orfCount - 2); i >= 0; i--){
-        int k = i + 1;
-        double log_newTerm = LBinCoeff(lGammaLookup, orfCount, k) + k * logPvalThr + (orfCount - k) * log1MinusPvalThr;
-        logB[i] = logB[i + 1] + log(1 + exp(log_newTerm - logB[i+1]));
-    }
-}
-
-
 class PvalueAggregator : public Aggregation {
 public:
     PvalueAggregator(std::string queryDbName, std::string targetDbName, const std::string &resultDbName,
@@ -55,17 +39,17 @@ public:
             lGammaLookup[i] = lgamma(i);
         }
 
-        logBiLookup = new double*[threads];
+        multiHitPvalue = new MultiHitPvalue*[threads];
         for (size_t i = 0; i < threads; ++i) {
-            logBiLookup[i] = new double[maxOrfCount];
+            multiHitPvalue[i] = new MultiHitPvalue(maxOrfCount, lGammaLookup);
         }
     }
 
     ~PvalueAggregator() {
         for (size_t i = 0; i < threads; ++i) {
-            delete[] logBiLookup[i];
+            delete multiHitPvalue[i];
         }
-        delete[] logBiLookup;
+        delete[] multiHitPvalue;
 
         delete[] lGammaLookup;
 
@@ -78,11 +62,11 @@ public:
 
     void prepareInput(unsigned int querySetKey, unsigned int thread_idx) {
         unsigned int orfCount = Util::fast_atoi<unsigned int>(querySizeReader->getDataByDBKey(querySetKey, thread_idx));
-        precomputeLogB(orfCount, alpha/(orfCount + 1), lGammaLookup, logBiLookup[thread_idx]);
+        multiHitPvalue[thread_idx]->prepare(orfCount, alpha/(orfCount + 1));
     }
 
     //Get all result of a single Query Set VS a Single Target Set and return the multiple-match p-value for it
-    std::string aggregateEntry(std::vector<std::vector<std::string> > &dataToAggregate, unsigned int querySetKey,
+    std::string aggregateEntry(const AggregationHits &hits, size_t begin, size_t end, unsigned int querySetKey,
                                unsigned int targetSetKey, unsigned int thread_idx) {
         
         const size_t numTargetSets = targetSizeReader->getSize();  
@@ -108,8 +92,8 @@ public:
             // size_t k = 0;
             double r = 0;
             const double logPvalThr = log(pvalThreshold);
-            for (size_t i = 0; i < dataToAggregate.size(); ++i) {
-                double logPvalue = std::strtod(dataToAggregate[i][1].c_str(), NULL);
+            for (size_t i = begin; i < end; ++i) {
+                double logPvalue = hits.score[i];
                 if (logPvalue < logPvalThr) {
                     // k++;
                     r -= logPvalue - logPvalThr;
@@ -135,20 +119,15 @@ public:
             }
 
 
-            double truncatedFisherPval = 0;
-            const double logR = log(r);
-            for (size_t i = 0; i < orfCount; ++i) { 
-                truncatedFisherPval += exp(i*logR - lGammaLookup[i+1] + logBiLookup[thread_idx][i]);
-            }            
-            updatedPval = expMinusR * truncatedFisherPval;       
+            updatedPval = multiHitPvalue[thread_idx]->evaluate(r);
         } 
 
         //1) the minimum of all P-values(as a baseline)
         else if(aggregationMode == Parameters::AGGREGATION_MODE_MIN_PVAL){
             unsigned int orfCount = Util::fast_atoi<unsigned int>(querySizeReader->getDataByDBKey(querySetKey, thread_idx));
             double minLogPval = 0;
-            for (size_t i = 0; i < dataToAggregate.size(); ++i) { 
-                double currentLogPval = std::strtod(dataToAggregate[i][1].c_str(), NULL);
+            for (size_t i = begin; i < end; ++i) {
+                double currentLogPval = hits.score[i];
                 if (currentLogPval < minLogPval) {
                     minLogPval = currentLogPval;
                 };
@@ -159,8 +138,8 @@ public:
         //2) the P-value for the product-of-P-values
         else if (aggregationMode == Parameters::AGGREGATION_MODE_PRODUCT)    {
             double  sumLogPval= 0;
-            for (size_t i = 0; i < dataToAggregate.size(); ++i) {
-                double logPvalue = std::strtod(dataToAggregate[i][1].c_str(), NULL);
+            for (size_t i = begin; i < end; ++i) {
+                double logPvalue = hits.score[i];
                 sumLogPval += logPvalue;
             }
             updatedPval = exp(sumLogPval);   
@@ -174,8 +153,8 @@ public:
             double minLogPval = 0;
             double sumLogPval = 0; 
             size_t k = 0;
-            for (size_t i = 0; i < dataToAggregate.size(); ++i) {
-                double logPvalue = std::strtod(dataToAggregate[i][1].c_str(), NULL);
+            for (size_t i = begin; i < end; ++i) {
+                double logPvalue = hits.score[i];
                 if (logPvalue < minLogPval) {
                     if (logPvalue == 0) {
                         //to avoid -0.0
@@ -217,7 +196,7 @@ private:
     DBReader<unsigned int> *querySizeReader;
     DBReader<unsigned int> *targetSizeReader;
     double* lGammaLookup;
-    double** logBiLookup;
+    MultiHitPvalue** multiHitPvalue;
 };
 
 int combinepvalperset(int argc, const char **argv, const Command &command) {
@@ -88,7 +88,7 @@ public:
 
     void prepareInput(unsigned int, unsigned int) {}
 
-    std::string aggregateEntry(std::vector<std::vector<std::string> > &dataToAggregate, unsigned int querySetKey,
+    std::string aggregateEntry(const AggregationHits &hits, size_t begin, size_t end, unsigned int querySetKey,
                                unsigned int targetSetKey, unsigned int thread_idx) {
         double targetGeneCount = std::strtod(targetSizeReader->getDataByDBKey(targetSetKey, thread_idx), NULL);
         double pvalThreshold = this->alpha / targetGeneCount;
@@ -99,26 +99,29 @@ public:
         std::string genesID;
         std::string positionsStr;
         unsigned int nbrGoodEvals = 0;
-        for (std::vector<std::vector<std::string>>::const_iterator it = dataToAggregate.begin();
-             it != dataToAggregate.end(); ++it) {
-            double Pval = std::strtod((*it)[3].c_str(), NULL);
+        const char *fields[11];
+        for (size_t i = begin; i < end; ++i) {
+            double Pval = hits.evalue[i];
             if (Pval >= pvalThreshold) {
                 continue;
             }
 
-            unsigned long start = static_cast<unsigned long>(std::stol((*it)[8]));
-            unsigned long stop = static_cast<unsigned long>(std::stol((*it)[10]));
+            Util::getFieldsOfLine(hits.line[i], fields, 11);
+            unsigned long start = static_cast<unsigned long>(strtol(fields[8], NULL, 10));
+            unsigned long stop = static_cast<unsigned long>(strtol(fields[10], NULL, 10));
             genesPositions.emplace_back(std::make_pair(start, stop));
             hitsUnderThreshold++;
 
             if (shortOutput) {
                 continue;
             }
-            meanEval += log10(std::strtod((*it)[3].c_str(), NULL));
-            eVals += (*it)[3] + ",";
-            genesID += (*it)[0] + ",";
+            meanEval += log10(Pval);
+            eVals.append(fields[3], Util::skipNonTab(fields[3]));
+            eVals.append(",");
+            genesID.append(fields[0], Util::skipNonTab(fields[0]));
+            genesID.append(",");
             positionsStr += std::to_string(start) + "," + std::to_string(stop) + ",";
-            if (std::strtod((*it)[3].c_str(), NULL) < 1e-10) {
+            if (Pval < 1e-10) {
                 nbrGoodEvals++;
             }
         }
@@ -67,7 +67,8 @@ public:
     IndexTable(int alphabetSize, int kmerSize, bool externalData)
             : tableSize(MathUtil::ipow<size_t>(alphabetSize, kmerSize)), alphabetSize(alphabetSize),
               kmerSize(kmerSize), externalData(externalData), tableEntriesNum(0), size(0),
-              indexer(new Indexer(alphabetSize, kmerSize)), entries(NULL), offsets(NULL) {
+              indexer(new Indexer(alphabetSize, kmerSize)), entries(NULL), offsets(NULL),
+              sequenceClades(NULL), cladeCount(1) {
         if (externalData == false) {
             offsets = new(std::nothrow) size_t[tableSize + 1];
             Util::checkAllocation(offsets, "Can not allocate entries memory in IndexTable");
@@ -90,6 +91,10 @@ public:
                 delete[] offsets;
                 offsets = NULL;
             }
+            if (sequenceClades != NULL) {
+                delete[] sequenceClades;
+                sequenceClades = NULL;
+            }
         }
     }
 
@@ -179,13 +184,63 @@ public:
         return (entries + offsets[kmer]);
     }
 
+    // get the part of the list of DB sequences containing this k-mer that belongs to the clades [fromClade, toClade)
+    inline IndexEntryLocal *getDBSeqList(size_t kmer, unsigned int fromClade, unsigned int toClade, size_t *matchedListSize) {
+        IndexEntryLocal *first = entries + offsets[kmer];
+        IndexEntryLocal *last = entries + offsets[kmer + 1];
+        const unsigned char *clades = sequenceClades;
+        if (fromClade > 0) {
+            first = std::partition_point(first, last, [clades, fromClade](const IndexEntryLocal &entry) {
+                return clades[entry.seqId] < fromClade;
+            });
+        }
+        if (toClade < cladeCount) {
+            last = std::partition_point(first, last, [clades, toClade](const IndexEntryLocal &entry) {
+                return clades[entry.seqId] < toClade;
+            });
+        }
+        *matchedListSize = static_cast<size_t>(last - first);
+        return first;
+    }
+
+    // lists are sorted by clade first if the sequences were assigned to clades
     void sortDBSeqLists() {
+        const unsigned char *clades = sequenceClades;
         #pragma omp parallel for
         for (size_t i = 0; i < tableSize; i++) {
             size_t entrySize;
             IndexEntryLocal *entries = getDBSeqList(i, &entrySize);
-            SORT_SERIAL(entries, entries + entrySize, IndexEntryLocal::comapreByIdAndPos);
+            if (clades == NULL) {
+                SORT_SERIAL(entries, entries + entrySize, IndexEntryLocal::comapreByIdAndPos);
+            } else {
+                SORT_SERIAL(entries, entries + entrySize, [clades](const IndexEntryLocal &first, const IndexEntryLocal &second) {
+                    if (clades[first.seqId] != clades[second.seqId]) {
+                        return clades[first.seqId] < clades[second.seqId];
+                    }
+                    return IndexEntryLocal::comapreByIdAndPos(first, second);
+                });
+            }
+        }
+    }
+
+    // assign each sequence of the table to one of cladeCount clades, has to be set before the lists are sorted
+    void setSequenceClades(unsigned char *clades, size_t sequenceCount, unsigned int cladeCount) {
+        this->cladeCount = cladeCount;
+        if (externalData) {
+            sequenceClades = clades;
+            return;
         }
+        sequenceClades = new(std::nothrow) unsigned char[sequenceCount];
+        Util::checkAllocation(sequenceClades, "Can not allocate sequenceClades memory in IndexTable");
+        memcpy(sequenceClades, clades, sequenceCount * sizeof(unsigned char));
+    }
+
+    unsigned char *getSequenceClades() {
+        return sequenceClades;
+    }
+
+    unsigned int getCladeCount() {
+        return cladeCount;
     }
 
     // get pointer to entries array
@@ -485,6 +540,10 @@ protected:
     IndexEntryLocal *entries;
     size_t *offsets;
 
+    // clade of each sequence, NULL if the lists are not grouped by clade
+    unsigned char *sequenceClades;
+    unsigned int cladeCount;
+
     // sequence lookup
     SequenceLookup *sequenceLookup;
 };
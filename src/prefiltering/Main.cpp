@@ -1,4 +1,5 @@
 #include "Prefiltering.h"
+#include "Alignment.h"
 #include "Util.h"
 #include "Parameters.h"
 #include "MMseqsMPI.h"
@@ -10,15 +11,10 @@
 #include <omp.h>
 #endif
 
-int prefilter(int argc, const char **argv, const Command& command) {
-    MMseqsMPI::init(argc, argv);
-
-    Parameters& par = Parameters::getInstance();
-    par.parseParameters(argc, argv, command, true, 0, MMseqsParameter::COMMAND_PREFILTER);
-
-    Timer timer;
-    int queryDbType = FileUtil::parseDbType(par.db1.c_str());
-    int targetDbType = FileUtil::parseDbType(par.db2.c_str());
+// the target can be a precomputed index, the prefilter needs the type of the sequences it contains
+static int readDbTypes(const Parameters &par, int &queryDbType, int &targetDbType) {
+    queryDbType = FileUtil::parseDbType(par.db1.c_str());
+    targetDbType = FileUtil::parseDbType(par.db2.c_str());
     if(Parameters::isEqualDbtype(targetDbType, Parameters::DBTYPE_INDEX_DB) == true) {
         DBReader<unsigned int> dbr(par.db2.c_str(), par.db2Index.c_str(), par.threads, DBReader<unsigned int>::USE_INDEX | DBReader<unsigned int>::USE_DATA);
         dbr.open(DBReader<unsigned int>::NOSORT);
@@ -43,6 +39,21 @@ int prefilter(int argc, const char **argv, const Command& command) {
         Debug(Debug::ERROR) << "The prefilter can not search nucleotides against amino acids. Something might got wrong while createdb or createindex.\n";
         return EXIT_FAILURE;
     }
+    return EXIT_SUCCESS;
+}
+
+int prefilter(int argc, const char **argv, const Command& command) {
+    MMseqsMPI::init(argc, argv);
+
+    Parameters& par = Parameters::getInstance();
+    par.parseParameters(argc, argv, command, true, 0, MMseqsParameter::COMMAND_PREFILTER);
+
+    Timer timer;
+    int queryDbType;
+    int targetDbType;
+    if (readDbTypes(par, queryDbType, targetDbType) != EXIT_SUCCESS) {
+        return EXIT_FAILURE;
+    }
 
     Prefiltering pref(par.db1, par.db1Index, par.db2, par.db2Index, queryDbType, targetDbType, par);
 
@@ -60,3 +71,81 @@ int prefilter(int argc, const char **argv, const Command& command) {
 
     return EXIT_SUCCESS;
 }
+
+// aligns the hits of a query in the prefilter thread that found them, so no prefilter DB has to be written
+class AlignmentResultHook : public PrefilterResultHook {
+public:
+    AlignmentResultHook(Alignment &aln, unsigned int threads) : aln(aln), threads(threads) {
+        evaluer = aln.createEvalueComputation();
+        threadData = new Alignment::ThreadData*[threads];
+        alnResults = new std::string[threads];
+        queries = new size_t[threads];
+        for (unsigned int i = 0; i < threads; i++) {
+            threadData[i] = new Alignment::ThreadData(aln, evaluer);
+            queries[i] = 0;
+        }
+    }
+
+    ~AlignmentResultHook() {
+        for (unsigned int i = 0; i < threads; i++) {
+            delete threadData[i];
+        }
+        delete[] threadData;
+        delete[] alnResults;
+        delete[] queries;
+        delete evaluer;
+    }
+
+    void processQuery(unsigned int queryKey, std::string &result, unsigned int thread_idx) {
+        std::string &alnResult = alnResults[thread_idx];
+        aln.alignQuery(*threadData[thread_idx], queryKey, (char *) result.c_str(), alnResult, thread_idx);
+        result.swap(alnResult);
+        alnResult.clear();
+        queries[thread_idx]++;
+    }
+
+    int getDbType() {
+        return aln.getOutputDbType();
+    }
+
+    void printStatistics() {
+        size_t alignmentsNum = 0;
+        size_t passedNum = 0;
+        size_t queryCount = 0;
+        for (unsigned int i = 0; i < threads; i++) {
+            alignmentsNum += threadData[i]->alignmentsNum;
+            passedNum += threadData[i]->passedNum;
+            queryCount += queries[i];
+        }
+        aln.printStatistics(alignmentsNum, passedNum, queryCount);
+    }
+
+private:
+    Alignment &aln;
+    const unsigned int threads;
+    EvalueComputation *evaluer;
+    Alignment::ThreadData **threadData;
+    std::string *alnResults;
+    size_t *queries;
+};
+
+int prefilteralign(int argc, const char **argv, const Command& command) {
+    Parameters& par = Parameters::getInstance();
+    par.overrideParameterDescription(par.PARAM_ALIGNMENT_MODE, "How to compute the alignment:\n0: automatic\n1: only score and end_pos\n2: also start_pos and cov\n3: also seq.id", NULL, 0);
+    par.parseParameters(argc, argv, command, true, 0, MMseqsParameter::COMMAND_PREFILTER | MMseqsParameter::COMMAND_ALIGN);
+
+    int queryDbType;
+    int targetDbType;
+    if (readDbTypes(par, queryDbType, targetDbType) != EXIT_SUCCESS) {
+        return EXIT_FAILURE;
+    }
+
+    Prefiltering pref(par.db1, par.db1Index, par.db2, par.db2Index, queryDbType, targetDbType, par);
+    Alignment aln(par.db1, par.db2, "", "", par.db3, par.db3Index, par, false);
+    AlignmentResultHook hook(aln, par.threads);
+    pref.setResultHook(&hook);
+    pref.runAllSplits(par.db3, par.db3Index);
+    hook.printStatistics();
+
+    return EXIT_SUCCESS;
+}
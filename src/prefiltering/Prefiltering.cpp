@@ -242,6 +242,8 @@ Prefiltering::Prefiltering(const std::string &queryDB,
     } else {
         taxonomyHook = NULL;
     }
+    resultHook = NULL;
+    resultDbType = Parameters::DBTYPE_PREFILTER_RES;
 }
 
 Prefiltering::~Prefiltering() {
@@ -391,7 +393,7 @@ void Prefiltering::setupSplit(DBReader<unsigned int>& tdbr, const int alphabetSi
 }
 
 void Prefiltering::mergeTargetSplits(const std::string &outDB, const std::string &outDBIndex, const std::vector<std::pair<std::string, std::string>> &fileNames, unsigned int threads) {
-    // we assume that the hits are in the same order
+    // every split contains an entry for each query
     const size_t splits = fileNames.size();
 
     if (splits < 2) {
@@ -402,109 +404,92 @@ void Prefiltering::mergeTargetSplits(const std::string &outDB, const std::string
 
     Timer timer;
     Debug(Debug::INFO) << "Merging " << splits << " target splits to " << FileUtil::baseName(outDB) << "\n";
-    DBReader<unsigned int> reader1(fileNames[0].first.c_str(), fileNames[0].second.c_str(), 1, DBReader<unsigned int>::USE_INDEX);
-    reader1.open(DBReader<unsigned int>::NOSORT);
-    DBReader<unsigned int>::Index *index1 = reader1.getIndex();
-
-    size_t totalSize = 0;
-    for (size_t id = 0; id < reader1.getSize(); id++) {
-        totalSize += index1[id].length;
-    }
-    for (size_t i = 1; i < splits; ++i) {
-        DBReader<unsigned int> reader2(fileNames[i].first.c_str(), fileNames[i].second.c_str(), 1, DBReader<unsigned int>::USE_INDEX);
-        reader2.open(DBReader<unsigned int>::NOSORT);
-        DBReader<unsigned int>::Index *index2 = reader2.getIndex();
-        size_t currOffset = 0;
-        for (size_t id = 0; id < reader1.getSize(); id++) {
-            // add length for file1 and file2 and subtract -1 for one null byte
-            size_t seqLen = index1[id].length + index2[id].length - 1;
-            totalSize += index2[id].length - 1;
-            index1[id].length = seqLen;
-            index1[id].offset = currOffset;
-            currOffset += seqLen;
+    std::vector<DBReader<unsigned int>*> readers;
+    for (size_t i = 0; i < splits; ++i) {
+        DBReader<unsigned int> *reader = new DBReader<unsigned int>(fileNames[i].first.c_str(), fileNames[i].second.c_str(), 1, DBReader<unsigned int>::USE_INDEX|DBReader<unsigned int>::USE_DATA);
+        reader->open(DBReader<unsigned int>::NOSORT);
+        if (readers.empty() == false && reader->getSize() != readers[0]->getSize()) {
+            Debug(Debug::ERROR) << "Target split " << fileNames[i].first << " has " << reader->getSize()
+                                << " entries but " << readers[0]->getSize() << " are expected\n";
+            EXIT(EXIT_FAILURE);
         }
-        reader2.close();
+        readers.push_back(reader);
     }
-    reader1.setDataSize(totalSize);
+    const size_t dbSize = readers[0]->getSize();
 
-    FILE ** files = new FILE*[fileNames.size()];
-    char ** dataFile = new char*[fileNames.size()];
-    size_t * dataFileSize = new size_t[fileNames.size()];
-    size_t globalIdOffset = 0;
+    // each thread merges a contiguous range of queries with about the same amount of hits,
+    // so that the concatenated thread outputs are already sorted by id
+    std::vector<size_t> rangeStart(threads + 1, dbSize);
+    rangeStart[0] = 0;
+    size_t totalLength = 0;
     for (size_t i = 0; i < splits; ++i) {
-        files[i] = FileUtil::openFileOrDie(fileNames[i].first.c_str(), "r", true);
-        dataFile[i] = static_cast<char*>(FileUtil::mmapFile(files[i], &dataFileSize[i]));
-#ifdef HAVE_POSIX_MADVISE
-        if (dataFileSize[i] > 0 && posix_madvise (dataFile[i], dataFileSize[i], POSIX_MADV_SEQUENTIAL) != 0){
-            Debug(Debug::ERROR) << "posix_madvise returned an error " << fileNames[i].first << "\n";
+        totalLength += readers[i]->getDataSize();
+    }
+    size_t currLength = 0;
+    unsigned int nextRange = 1;
+    for (size_t id = 0; id < dbSize; id++) {
+        for (size_t i = 0; i < splits; ++i) {
+            if (readers[i]->getDbKey(id) != readers[0]->getDbKey(id)) {
+                Debug(Debug::ERROR) << "Target split " << fileNames[i].first << " contains key " << readers[i]->getDbKey(id)
+                                    << " instead of " << readers[0]->getDbKey(id) << "\n";
+                EXIT(EXIT_FAILURE);
+            }
+            currLength += readers[i]->getEntryLen(id);
+        }
+        while (nextRange < threads && currLength * threads >= totalLength * nextRange) {
+            rangeStart[nextRange] = id + 1;
+            nextRange++;
         }
-#endif
-
     }
     Debug(Debug::INFO) << "Preparing offsets for merging: " << timer.lap() << "\n";
-    // merge target splits data files and sort the hits at the same time
+
     // TODO: compressed?
     DBWriter writer(outDB.c_str(), outDBIndex.c_str(), threads, 0, Parameters::DBTYPE_PREFILTER_RES);
     writer.open();
 
-    Debug::Progress progress(reader1.getSize());
+    Debug::Progress progress(dbSize);
 #pragma omp parallel num_threads(threads)
     {
-        unsigned int thread_idx = 0;
-#ifdef OPENMP
-        thread_idx = static_cast<unsigned int>(omp_get_thread_num());
-#endif
-        std::string result;
-        result.reserve(1024);
         std::vector<hit_t> hits;
-        hits.reserve(300);
+        hits.reserve(300 * splits);
+        std::vector<hit_t> merged;
+        merged.reserve(300 * splits);
+        std::vector<size_t> listStarts(splits + 1);
         char buffer[1024];
-        size_t * currentDataFileOffset = new size_t[splits];
-        memset(currentDataFileOffset, 0, sizeof(size_t)*splits);
-        size_t currentId = __sync_fetch_and_add(&(globalIdOffset), 1);
-        size_t prevId = 0;
-        while(currentId < reader1.getSize()){
-            progress.updateProgress();
-            for(size_t file = 0; file < splits; file++){
-                size_t tmpId = prevId;
-                size_t pos;
-                for(pos = currentDataFileOffset[file]; pos < dataFileSize[file] && tmpId != currentId; pos++){
-                    tmpId += (dataFile[file][pos] == '\0');
-                    currentDataFileOffset[file] = pos;
+
+        // ranges are processed by whichever thread is available but always written to their own output file
+#pragma omp for schedule(dynamic, 1)
+        for (size_t range = 0; range < threads; range++) {
+            for (size_t id = rangeStart[range]; id < rangeStart[range + 1]; id++) {
+                progress.updateProgress();
+                for (size_t i = 0; i < splits; ++i) {
+                    listStarts[i] = hits.size();
+                    QueryMatcher::parsePrefilterHits(readers[i]->getDataUncompressed(id), hits);
+                    // the identity hit might have been moved to the front
+                    if (std::is_sorted(hits.begin() + listStarts[i], hits.end(), hit_t::compareHitsByScoreAndId) == false) {
+                        SORT_SERIAL(hits.begin() + listStarts[i], hits.end(), hit_t::compareHitsByScoreAndId);
+                    }
                 }
-                currentDataFileOffset[file] = pos;
-                QueryMatcher::parsePrefilterHits(&dataFile[file][pos], hits);
-            }
-            if (hits.size() > 1) {
-                SORT_SERIAL(hits.begin(), hits.end(), hit_t::compareHitsByScoreAndId);
-            }
-            for (size_t i = 0; i < hits.size(); ++i) {
-                int len = QueryMatcher::prefilterHitToBuffer(buffer, hits[i]);
-                result.append(buffer, len);
+                listStarts[splits] = hits.size();
+                QueryMatcher::mergeHitLists(hits, listStarts, merged);
+
+                writer.writeStart(range);
+                for (size_t i = 0; i < merged.size(); ++i) {
+                    size_t len = QueryMatcher::prefilterHitToBuffer(buffer, merged[i]);
+                    writer.writeAdd(buffer, len, range);
+                }
+                writer.writeEnd(readers[0]->getDbKey(id), range);
+                hits.clear();
             }
-            writer.writeData(result.c_str(), result.size(), reader1.getDbKey(currentId), thread_idx);
-            hits.clear();
-            result.clear();
-            prevId = currentId;
-            currentId = __sync_fetch_and_add(&(globalIdOffset), 1);
         }
-
-            delete[] currentDataFileOffset;
     }
-    writer.close();
-    reader1.close();
+    writer.close(true, false);
 
     for (size_t i = 0; i < splits; ++i) {
+        readers[i]->close();
+        delete readers[i];
         DBReader<unsigned int>::removeDb(fileNames[i].first);
-        FileUtil::munmapData(dataFile[i], dataFileSize[i]);
-        if (fclose(files[i]) != 0) {
-            Debug(Debug::ERROR) << "Cannot close file " << fileNames[i].first << "\n";
-            EXIT(EXIT_FAILURE);
-        }
     }
-    delete [] dataFile;
-    delete [] dataFileSize;
-    delete [] files;
 
     Debug(Debug::INFO) << "Time for merging target splits: " << timer.lap() << "\n";
 }
@@ -581,6 +566,17 @@ bool Prefiltering::isSameQTDB() {
     return (queryDB.compare(targetDB) == 0 || (match == true));
 }
 
+void Prefiltering::setResultHook(PrefilterResultHook *hook) {
+    // target splits have to be merged before the results of a query are complete
+    if (splitMode == Parameters::TARGET_DB_SPLIT && splits > 1) {
+        Debug(Debug::ERROR) << "The prefilter result cannot be passed on directly in target split mode. "
+                               "Please increase the memory limit or run prefilter and align separately.\n";
+        EXIT(EXIT_FAILURE);
+    }
+    resultHook = hook;
+    resultDbType = hook->getDbType();
+}
+
 void Prefiltering::runAllSplits(const std::string &resultDB, const std::string &resultDBIndex) {
     runSplits(resultDB, resultDBIndex, 0, splits, false);
 }
@@ -663,7 +659,7 @@ void Prefiltering::runMpiSplits(const std::string &resultDB, const std::string &
             // merge output databases
             mergePrefilterSplits(resultDB, resultDBIndex, splitFiles);
         } else {
-            DBWriter writer(resultDB.c_str(), resultDBIndex.c_str(), 1, compressed, Parameters::DBTYPE_PREFILTER_RES);
+            DBWriter writer(resultDB.c_str(), resultDBIndex.c_str(), 1, compressed, resultDbType);
             writer.open();
             writer.close();
         }
@@ -707,12 +703,13 @@ int Prefiltering::runSplits(const std::string &resultDB, const std::string &resu
         }
         if (splitFiles.size() > 0) {
             mergePrefilterSplits(resultDB, resultDBIndex, splitFiles);
-            if (splitFiles.size() > 1) {
+            // merged target splits are already written in id order
+            if (splitFiles.size() > 1 && splitMode != Parameters::TARGET_DB_SPLIT) {
                 DBReader<unsigned int> resultReader(resultDB.c_str(), resultDBIndex.c_str(), threads, DBReader<unsigned int>::USE_INDEX | DBReader<unsigned int>::USE_DATA);
                 resultReader.open(DBReader<unsigned int>::NOSORT);
                 resultReader.readMmapedDataInMemory();
                 const std::pair<std::string, std::string> tempDb = Util::databaseNames(resultDB + "_tmp");
-                DBWriter resultWriter(tempDb.first.c_str(), tempDb.second.c_str(), threads, compressed, Parameters::DBTYPE_PREFILTER_RES);
+                DBWriter resultWriter(tempDb.first.c_str(), tempDb.second.c_str(), threads, compressed, resultDbType);
                 resultWriter.open();
                 resultWriter.sortDatafileByIdOrder(resultReader);
                 resultWriter.close(true);
@@ -727,7 +724,7 @@ int Prefiltering::runSplits(const std::string &resultDB, const std::string &resu
             hasResult = true;
         }
     } else if (splitProcessCount == 0) {
-        DBWriter writer(resultDB.c_str(), resultDBIndex.c_str(), 1, compressed, Parameters::DBTYPE_PREFILTER_RES);
+        DBWriter writer(resultDB.c_str(), resultDBIndex.c_str(), 1, compressed, resultDbType);
         writer.open();
         writer.close();
         hasResult = false;
@@ -771,6 +768,12 @@ bool Prefiltering::runSplit(const std::string &resultDB, const std::string &resu
 
     Debug(Debug::INFO) << "k-mer similarity threshold: " << kmerThr << "\n";
 
+    // only read the clades of the index that can contain hits passing the taxonomy filter
+    std::vector<std::pair<unsigned int, unsigned int>> cladeRanges;
+    if (taxonomyHook != NULL && indexTable != NULL) {
+        cladeRanges = taxonomyHook->getCladeRanges(*indexTable, dbFrom);
+    }
+
     double kmersPerPos = 0;
     size_t dbMatches = 0;
     size_t doubleMatches = 0;
@@ -784,7 +787,7 @@ bool Prefiltering::runSplit(const std::string &resultDB, const std::string &resu
     localThreads = std::max(std::min((size_t)threads, querySize), (size_t)1);
 #endif
 
-    DBWriter tmpDbw(resultDB.c_str(), resultDBIndex.c_str(), localThreads, compressed, Parameters::DBTYPE_PREFILTER_RES);
+    DBWriter tmpDbw(resultDB.c_str(), resultDBIndex.c_str(), localThreads, compressed, resultDbType);
     tmpDbw.open();
 
     // init all thread-specific data structures
@@ -823,6 +826,7 @@ bool Prefiltering::runSplit(const std::string &resultDB, const std::string &resu
 
         if (taxonomyHook != NULL) {
             matcher.setQueryMatcherHook(taxonomyHook);
+            matcher.setCladeRanges(cladeRanges);
         }
 
         char buffer[128];
@@ -881,6 +885,9 @@ bool Prefiltering::runSplit(const std::string &resultDB, const std::string &resu
                 int len = QueryMatcher::prefilterHitToBuffer(buffer, *res);
                 result.append(buffer, len);
             }
+            if (resultHook != NULL) {
+                resultHook->processQuery(qKey, result, thread_idx);
+            }
             tmpDbw.writeData(result.c_str(), result.length(), qKey, thread_idx);
             result.clear();
 
@@ -929,9 +936,7 @@ bool Prefiltering::runSplit(const std::string &resultDB, const std::string &resu
         tmpDbw.close(merge);
     }
 
-    // sort by ids
-    // needed to speed up merge later on
-    // sorts this datafile according to the index file
+    // the merge of target splits reads the results through the index, the data does not need to be sorted by id
     if (splitMode == Parameters::TARGET_DB_SPLIT && splits > 1) {
         // free memory early since the merge might need quite a bit of memory
         if (indexTable != NULL) {
@@ -942,17 +947,6 @@ bool Prefiltering::runSplit(const std::string &resultDB, const std::string &resu
             delete sequenceLookup;
             sequenceLookup = NULL;
         }
-        DBReader<unsigned int> resultReader(tmpDbw.getDataFileName(), tmpDbw.getIndexFileName(), threads, DBReader<unsigned int>::USE_INDEX|DBReader<unsigned int>::USE_DATA);
-        resultReader.open(DBReader<unsigned int>::NOSORT);
-        resultReader.readMmapedDataInMemory();
-        const std::pair<std::string, std::string> tempDb = Util::databaseNames((resultDB + "_tmp"));
-        DBWriter resultWriter(tempDb.first.c_str(), tempDb.second.c_str(), localThreads, compressed, Parameters::DBTYPE_PREFILTER_RES);
-        resultWriter.open();
-        resultWriter.sortDatafileByIdOrder(resultReader);
-        resultWriter.close(true);
-        resultReader.close();
-        DBReader<unsigned int>::removeDb(resultDB);
-        DBReader<unsigned int>::moveDb(tempDb.first, resultDB);
     }
 
     for (size_t i = 0; i < localThreads; i++) {
@@ -24,6 +24,15 @@ struct KmerThreshold{
 
 extern std::vector<KmerThreshold> externalThreshold;
 
+// receives the result of each query before it is written, e.g. to align the hits right away
+class PrefilterResultHook {
+public:
+    virtual ~PrefilterResultHook() {};
+    // result holds the prefilter hits and is replaced with the entry that should be written instead
+    virtual void processQuery(unsigned int queryKey, std::string &result, unsigned int thread_idx) = 0;
+    virtual int getDbType() = 0;
+};
+
 
 class Prefiltering {
 public:
@@ -59,6 +68,8 @@ public:
     static int getKmerThreshold(const float sensitivity, const bool isProfile, const bool hasContextPseudoCnts,
                                 const SeqProf<int> kmerScore, const int kmerSize);
 
+    void setResultHook(PrefilterResultHook *hook);
+
     static void mergeTargetSplits(const std::string &outDB, const std::string &outDBIndex,
                                   const std::vector<std::pair<std::string, std::string>> &fileNames, unsigned int threads);
 
@@ -115,6 +126,8 @@ private:
     const unsigned int threads;
     int compressed;
     QueryMatcherTaxonomyHook* taxonomyHook;
+    PrefilterResultHook* resultHook;
+    int resultDbType;
 
     bool runSplit(const std::string &resultDB, const std::string &resultDBIndex, size_t split, bool merge);
 
@@ -32,6 +32,9 @@ unsigned int PrefilteringIndexReader::GENERATOR = 22;
 unsigned int PrefilteringIndexReader::SPACEDPATTERN = 23;
 unsigned int PrefilteringIndexReader::ALNINDEX = 24;
 unsigned int PrefilteringIndexReader::ALNDATA = 25;
+unsigned int PrefilteringIndexReader::TAXCLADERANK = 26;
+unsigned int PrefilteringIndexReader::TAXCLADES = 27;
+unsigned int PrefilteringIndexReader::SEQCLADES = 28;
 
 extern const char* version;
 
@@ -57,7 +60,8 @@ void PrefilteringIndexReader::createIndexFile(const std::string &outDB,
                                               bool hasSpacedKmer, const std::string &spacedKmerPattern,
                                               bool compBiasCorrection, int alphabetSize, int kmerSize, int maskMode,
                                               int maskLowerCase, float maskProb, int maskNrepeats, int kmerThr, int targetSearchMode, int splits,
-                                              int indexSubset) {
+                                              int indexSubset, const std::string &cladeRank, const std::vector<int> &cladeTaxa,
+                                              unsigned char *sequenceClades) {
     const bool needKmerIndex = (indexSubset & Parameters::INDEX_SUBSET_NO_PREFILTER) == 0;
     const bool needSequenceLookup = (indexSubset & Parameters::INDEX_SUBSET_NO_SEQUENCE_LOOKUP) == 0;
     if (needKmerIndex == false) {
@@ -101,6 +105,19 @@ void PrefilteringIndexReader::createIndexFile(const std::string &outDB,
         writer.alignToPageSize(SPLIT_META);
     }
 
+    // the rank is also kept if no clades could be assigned, so that the index is not considered incompatible later
+    if (cladeRank.empty() == false) {
+        Debug(Debug::INFO) << "Write TAXCLADERANK (" << TAXCLADERANK << ")\n";
+        writer.writeData(cladeRank.c_str(), cladeRank.length(), TAXCLADERANK, SPLIT_META);
+        writer.alignToPageSize(SPLIT_META);
+    }
+
+    if (needKmerIndex && sequenceClades != NULL) {
+        Debug(Debug::INFO) << "Write TAXCLADES (" << TAXCLADES << ")\n";
+        writer.writeData((const char *) cladeTaxa.data(), cladeTaxa.size() * sizeof(int), TAXCLADES, SPLIT_META);
+        writer.alignToPageSize(SPLIT_META);
+    }
+
     Debug(Debug::INFO) << "Write GENERATOR (" << GENERATOR << ")\n";
     writer.writeData(version, strlen(version), GENERATOR, SPLIT_META);
     writer.alignToPageSize(SPLIT_META);
@@ -228,6 +245,9 @@ void PrefilteringIndexReader::createIndexFile(const std::string &outDB,
         IndexTable * indexTable;
         if(needKmerIndex){
             indexTable = new IndexTable(adjustAlphabetSize, kmerSize, false);
+            if (sequenceClades != NULL) {
+                indexTable->setSequenceClades(sequenceClades + dbFrom, dbSize, cladeTaxa.size());
+            }
         } else {
             indexTable = NULL;
         }
@@ -266,6 +286,11 @@ void PrefilteringIndexReader::createIndexFile(const std::string &outDB,
             writer.writeData(entriesNumPtr, 1 * sizeof(uint64_t), (keyOffset + ENTRIESNUM), SPLIT_INDX + s);
             writer.alignToPageSize(SPLIT_INDX + s);
 
+            if (sequenceClades != NULL) {
+                Debug(Debug::INFO) << "Write SEQCLADES (" << (keyOffset + SEQCLADES) << ")\n";
+                writer.writeData((char *) (sequenceClades + dbFrom), dbSize * sizeof(unsigned char), (keyOffset + SEQCLADES), SPLIT_INDX + s);
+                writer.alignToPageSize(SPLIT_INDX + s);
+            }
         }
 
         if (needSequenceLookup) {
@@ -433,9 +458,22 @@ IndexTable *PrefilteringIndexReader::getIndexTable(unsigned int split, DBReader<
         adjustAlphabetSize = data.alphabetSize;
     }
 
+    // k-mer lists grouped by clade
+    size_t cladesId = dbr->getId(TAXCLADES);
+    size_t sequenceCladesId = dbr->getId(splitOffset + SEQCLADES);
+    unsigned int cladeCount = 0;
+    unsigned char *sequenceClades = NULL;
+    if (cladesId != UINT_MAX && sequenceCladesId != UINT_MAX) {
+        cladeCount = dbr->getEntryLen(cladesId) / sizeof(int);
+        sequenceClades = (unsigned char *) dbr->getDataUncompressed(sequenceCladesId);
+    }
+
     if (preloadMode == Parameters::PRELOAD_MODE_FREAD) {
         IndexTable* table = new IndexTable(adjustAlphabetSize, data.kmerSize, false);
         table->initTableByExternalDataCopy(sequenceCount, entriesNum, (IndexEntryLocal*) entriesData, (size_t *)entriesOffsetsData);
+        if (sequenceClades != NULL) {
+            table->setSequenceClades(sequenceClades, sequenceCount, cladeCount);
+        }
         return table;
     }
 
@@ -444,10 +482,16 @@ IndexTable *PrefilteringIndexReader::getIndexTable(unsigned int split, DBReader<
         dbr->touchData(sequenceCountId);
         dbr->touchData(entriesDataId);
         dbr->touchData(entriesOffsetsDataId);
+        if (sequenceClades != NULL) {
+            dbr->touchData(sequenceCladesId);
+        }
     }
 
     IndexTable* table = new IndexTable(adjustAlphabetSize, data.kmerSize, true);
     table->initTableByExternalData(sequenceCount, entriesNum, (IndexEntryLocal*) entriesData, (size_t *)entriesOffsetsData);
+    if (sequenceClades != NULL) {
+        table->setSequenceClades(sequenceClades, sequenceCount, cladeCount);
+    }
     return table;
 }
 
@@ -473,6 +517,13 @@ void PrefilteringIndexReader::printSummary(DBReader<unsigned int> *dbr) {
         pos++;
     }
     Debug(Debug::INFO) << "ScoreMatrix:  " << std::string(subMatData, pos+4) << "\n";
+
+    if ((id = dbr->getId(TAXCLADERANK)) != UINT_MAX) {
+        Debug(Debug::INFO) << "Clade rank:   " << dbr->getDataUncompressed(id) << "\n";
+    }
+    if ((id = dbr->getId(TAXCLADES)) != UINT_MAX) {
+        Debug(Debug::INFO) << "Clades:       " << dbr->getEntryLen(id) / sizeof(int) << "\n";
+    }
 }
 
 void PrefilteringIndexReader::printMeta(int *metadata_tmp) {
@@ -549,6 +600,14 @@ std::string PrefilteringIndexReader::getSpacedPattern(DBReader<unsigned int> *db
     return std::string(dbr->getDataUncompressed(id));
 }
 
+std::string PrefilteringIndexReader::getCladeRank(DBReader<unsigned int> *dbr) {
+    size_t id = dbr->getId(TAXCLADERANK);
+    if (id == UINT_MAX) {
+        return "";
+    }
+    return std::string(dbr->getDataUncompressed(id));
+}
+
 ScoreMatrix PrefilteringIndexReader::get2MerScoreMatrix(DBReader<unsigned int> *dbr, int preloadMode) {
     size_t id = dbr->getId(SCOREMATRIX2MER);
     if (id == UINT_MAX) {
@@ -5,6 +5,7 @@
 #include "IndexTable.h"
 #include "DBReader.h"
 #include <string>
+#include <vector>
 
 struct PrefilteringIndexData {
     int maxSeqLength;
@@ -50,6 +51,9 @@ public:
     static unsigned int SPACEDPATTERN;
     static unsigned int ALNINDEX;
     static unsigned int ALNDATA;
+    static unsigned int TAXCLADERANK;
+    static unsigned int TAXCLADES;
+    static unsigned int SEQCLADES;
 
     static bool checkIfIndexFile(DBReader<unsigned int> *reader);
     static std::string indexName(const std::string &outDB);
@@ -60,7 +64,9 @@ public:
                                 DBReader<unsigned int> *alndbr,
                                 BaseMatrix *seedSubMat, int maxSeqLen, bool spacedKmer, const std::string &spacedKmerPattern,
                                 bool compBiasCorrection, int alphabetSize, int kmerSize, int maskMode,
-                                int maskLowerCase, float maskProb, int maskNrepeats, int kmerThr, int targetSearchMode, int splits, int indexSubset = 0);
+                                int maskLowerCase, float maskProb, int maskNrepeats, int kmerThr, int targetSearchMode, int splits, int indexSubset = 0,
+                                const std::string &cladeRank = "", const std::vector<int> &cladeTaxa = std::vector<int>(),
+                                unsigned char *sequenceClades = NULL);
 
     static DBReader<unsigned int> *openNewHeaderReader(DBReader<unsigned int>*dbr, unsigned int dataIdx, unsigned int indexIdx, int threads, bool touchIndex, bool touchData);
 
@@ -80,6 +86,8 @@ public:
 
     static std::string getSpacedPattern(DBReader<unsigned int> *dbr);
 
+    static std::string getCladeRank(DBReader<unsigned int> *dbr);
+
     static ScoreMatrix get2MerScoreMatrix(DBReader<unsigned int> *dbr, int preloadMode);
 
     static ScoreMatrix get3MerScoreMatrix(DBReader<unsigned int> *dbr, int preloadMode);
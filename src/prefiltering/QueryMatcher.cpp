@@ -3,6 +3,8 @@
 #include "FastSort.h"
 #include "Util.h"
 
+#include <algorithm>
+
 #define FE_1(WHAT, X) WHAT(X)
 #define FE_2(WHAT, X, ...) WHAT(X)FE_1(WHAT, __VA_ARGS__)
 #define FE_3(WHAT, X, ...) WHAT(X)FE_2(WHAT, __VA_ARGS__)
@@ -294,59 +296,65 @@ size_t QueryMatcher::match(Sequence *seq, float *compositionBias) {
         kmerListLen += kmerElementSize;
 
         for (unsigned int kmerPos = 0; kmerPos < kmerElementSize; kmerPos++) {
-            const IndexEntryLocal *entries = indexTable->getDBSeqList(index[kmerPos], &seqListSize);
-            // DEBUG
-            //std::cout << seq->getDbKey() << std::endl;
-            //idx.printKmer(index[kmerPos], kmerSize, kmerSubMat->num2aa);
-            //std::cout << "\t" << current_i << "\t"<< index[kmerPos] << std::endl;
+            const size_t kmerIdx = index[kmerPos];
+            const size_t rangeCount = cladeRanges.empty() ? 1 : cladeRanges.size();
+            for (size_t range = 0; range < rangeCount; range++) {
+                const IndexEntryLocal *entries = cladeRanges.empty()
+                    ? indexTable->getDBSeqList(kmerIdx, &seqListSize)
+                    : indexTable->getDBSeqList(kmerIdx, cladeRanges[range].first, cladeRanges[range].second, &seqListSize);
+                // DEBUG
+                //std::cout << seq->getDbKey() << std::endl;
+                //idx.printKmer(index[kmerPos], kmerSize, kmerSubMat->num2aa);
+                //std::cout << "\t" << current_i << "\t"<< index[kmerPos] << std::endl;
 //            for (size_t i = 0; i < seqListSize; i++) {
 //                if(23865 == entries[i].seqId ){
 //                    char diag = entries[i].position_j - current_i;
 //                    std::cout << "(" << entries[i].seqId << " " << (int) diag << ")\t";
 //                }
 //            }
-            //std::cout << std::endl;
-
-            // detected overflow while matching
-            if ((sequenceHits + seqListSize) >= lastSequenceHit) {
-                stats->diagonalOverflow = true;
-                // last pointer
-                indexPointer[current_i + 1] = sequenceHits;
-                //std::cout << "Overflow in i=" << indexStart << std::endl;
-                const size_t hitCount = findDuplicates(indexPointer,
-                                                       foundDiagonals + overflowHitCount,
-                                                       foundDiagonalsSize - overflowHitCount,
-                                                       indexStart, current_i, (diagonalScoring == false));
-                // this happens only if we have two overflows in a row
-                if (overflowHitCount != 0) {
-                    if(diagonalScoring == true){
-                        overflowHitCount = mergeElements(foundDiagonals, hitCount + overflowHitCount, true);
-                        // align the new diaognals
-                        ungappedAlignment->align(foundDiagonals, overflowHitCount);
-                        // We keep only the maximal diagonal scoring hit, so the max number of hits is DBsize
-                        overflowHitCount = keepMaxScoreElementOnly(foundDiagonals, overflowHitCount);
+                //std::cout << std::endl;
+
+                // detected overflow while matching
+                if ((sequenceHits + seqListSize) >= lastSequenceHit) {
+                    stats->diagonalOverflow = true;
+                    // last pointer
+                    indexPointer[current_i + 1] = sequenceHits;
+                    //std::cout << "Overflow in i=" << indexStart << std::endl;
+                    const size_t hitCount = findDuplicates(indexPointer,
+                                                           foundDiagonals + overflowHitCount,
+                                                           foundDiagonalsSize - overflowHitCount,
+                                                           indexStart, current_i, (diagonalScoring == false));
+                    // this happens only if we have two overflows in a row
+                    if (overflowHitCount != 0) {
+                        if(diagonalScoring == true){
+                            overflowHitCount = mergeElements(foundDiagonals, hitCount + overflowHitCount, true);
+                            // align the new diaognals
+                            ungappedAlignment->align(foundDiagonals, overflowHitCount);
+                            // We keep only the maximal diagonal scoring hit, so the max number of hits is DBsize
+                            overflowHitCount = keepMaxScoreElementOnly(foundDiagonals, overflowHitCount);
+                        } else {
+                            // in case of scoring we just sum up in mergeElements, so the max number of hits is DBsize
+                            // merge lists, hitCount is max. dbSize so there can be no overflow in mergeElements
+                            overflowHitCount = mergeElements(foundDiagonals, hitCount + overflowHitCount);
+                        }
                     } else {
-                        // in case of scoring we just sum up in mergeElements, so the max number of hits is DBsize
-                        // merge lists, hitCount is max. dbSize so there can be no overflow in mergeElements
-                        overflowHitCount = mergeElements(foundDiagonals, hitCount + overflowHitCount);
+                        overflowHitCount = hitCount;
+                    }
+                    // reset pointer position
+                    sequenceHits = databaseHits;
+                    indexPointer[current_i] = sequenceHits;
+                    indexStart = current_i;
+                    overflowNumMatches += numMatches;
+                    numMatches = 0;
+                    // TODO might delete this?
+                    if ((sequenceHits + seqListSize) >= lastSequenceHit){
+                        goto outer;
                     }
-                } else {
-                    overflowHitCount = hitCount;
-                }
-                // reset pointer position
-                sequenceHits = databaseHits;
-                indexPointer[current_i] = sequenceHits;
-                indexStart = current_i;
-                overflowNumMatches += numMatches;
-                numMatches = 0;
-                // TODO might delete this?
-                if ((sequenceHits + seqListSize) >= lastSequenceHit){
-                    goto outer;
                 }
+                memcpy(sequenceHits, entries, sizeof(IndexEntryLocal) * seqListSize);
+                sequenceHits += seqListSize;
+                numMatches += seqListSize;
             }
-            memcpy(sequenceHits, entries, sizeof(IndexEntryLocal) * seqListSize);
-            sequenceHits += seqListSize;
-            numMatches += seqListSize;
         }
         indexTo = current_i;
     }
@@ -605,3 +613,37 @@ template std::pair<hit_t *, size_t>  QueryMatcher::getResult<1>(CounterResult *
 #undef FE_3
 #undef FE_2
 #undef FE_1
+
+void QueryMatcher::mergeHitLists(const std::vector<hit_t> &hits, const std::vector<size_t> &listStarts, std::vector<hit_t> &merged) {
+    merged.assign(hits.begin(), hits.end());
+    if (listStarts.size() <= 2) {
+        return;
+    }
+    // merge neighbouring lists pairwise until only one list is left,
+    // this only streams through memory, unlike a heap over all list heads
+    std::vector<hit_t> buffer(hits.size());
+    std::vector<size_t> starts(listStarts);
+    std::vector<size_t> nextStarts;
+    std::vector<hit_t> *src = &merged;
+    std::vector<hit_t> *dst = &buffer;
+    while (starts.size() > 2) {
+        nextStarts.clear();
+        size_t i = 0;
+        for (; i + 2 < starts.size(); i += 2) {
+            std::merge(src->begin() + starts[i], src->begin() + starts[i + 1],
+                       src->begin() + starts[i + 1], src->begin() + starts[i + 2],
+                       dst->begin() + starts[i], hit_t::compareHitsByScoreAndId);
+            nextStarts.push_back(starts[i]);
+        }
+        if (i + 1 < starts.size()) {
+            std::copy(src->begin() + starts[i], src->begin() + starts[i + 1], dst->begin() + starts[i]);
+            nextStarts.push_back(starts[i]);
+        }
+        nextStarts.push_back(starts.back());
+        starts.swap(nextStarts);
+        std::swap(src, dst);
+    }
+    if (src != &merged) {
+        merged.swap(buffer);
+    }
+}
@@ -69,6 +69,11 @@ public:
         this->hook = hook;
     }
 
+    // only match the parts of the k-mer lists that belong to the clade ranges [first, second)
+    void setCladeRanges(const std::vector<std::pair<unsigned int, unsigned int>> &ranges) {
+        cladeRanges = ranges;
+    }
+
     // set substituion matrix for KmerGenerator
     void setProfileMatrix(ScoreMatrix **matrix){
         kmerGenerator->setDivideStrategy(matrix);
@@ -117,6 +122,10 @@ public:
         }
     }
 
+    // merges the lists hits[listStarts[i], listStarts[i+1]) that are each sorted by hit_t::compareHitsByScoreAndId
+    // listStarts has to end with hits.size()
+    static void mergeHitLists(const std::vector<hit_t> &hits, const std::vector<size_t> &listStarts, std::vector<hit_t> &merged);
+
     static size_t prefilterHitToBuffer(char *buff1, hit_t &h) {
         char * basePos = buff1;
         char * tmpBuff = Itoa::u32toa_sse2((uint32_t) h.seqId, buff1);
@@ -205,6 +214,8 @@ protected:
 
     QueryMatcherHook* hook;
 
+    std::vector<std::pair<unsigned int, unsigned int>> cladeRanges;
+
     void updateScoreBins(CounterResult *result, size_t elementCount);
     unsigned int scoreSingleSequenceCombined(CounterResult &result);
 
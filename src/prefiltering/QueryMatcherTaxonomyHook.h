@@ -57,6 +57,52 @@ public:
         return writePos;
     }
 
+    // clades of an index grouped by clade that contain at least one sequence matching the expression
+    // consecutive clades are merged into ranges [first, second)
+    std::vector<std::pair<unsigned int, unsigned int>> getCladeRanges(IndexTable &indexTable, size_t dbFrom) {
+        std::vector<std::pair<unsigned int, unsigned int>> ranges;
+        const unsigned char *clades = indexTable.getSequenceClades();
+        const unsigned int cladeCount = indexTable.getCladeCount();
+        if (clades == NULL || cladeCount <= 1) {
+            return ranges;
+        }
+
+        // 0: not evaluated yet, 1: does not match, 2: matches
+        std::vector<char> taxonState(taxonomy->maxTaxID + 2, 0);
+        std::vector<bool> relevant(cladeCount, false);
+        for (size_t i = 0; i < indexTable.getSize(); i++) {
+            if (relevant[clades[i]]) {
+                continue;
+            }
+            TaxID taxon = taxonomyMapping->lookup(targetReader->getDbKey(dbFrom + i));
+            // TaxIDs outside of the taxonomy share the last slot
+            size_t slot = (taxon >= 0 && taxon <= taxonomy->maxTaxID) ? taxon : taxonomy->maxTaxID + 1;
+            if (taxonState[slot] == 0) {
+                taxonState[slot] = expression[0]->isAncestor(taxon) ? 2 : 1;
+            }
+            relevant[clades[i]] = (taxonState[slot] == 2);
+        }
+
+        for (unsigned int clade = 0; clade < cladeCount; clade++) {
+            if (relevant[clade] == false) {
+                continue;
+            }
+            if (ranges.empty() == false && ranges.back().second == clade) {
+                ranges.back().second = clade + 1;
+            } else {
+                ranges.emplace_back(clade, clade + 1);
+            }
+        }
+        if (ranges.size() == 1 && ranges[0].first == 0 && ranges[0].second == cladeCount) {
+            // all clades have to be matched
+            ranges.clear();
+        } else if (ranges.empty()) {
+            // an empty list of ranges would match everything
+            ranges.emplace_back(0, 0);
+        }
+        return ranges;
+    }
+
     static std::string dbPathWithoutIndex(const std::string& dbname) {
         static const std::vector<std::string> suffices = {
             "_ss.idx",
@@ -0,0 +1,255 @@
+// include xxhash early to avoid incompatibilites with SIMDe
+#define XXH_INLINE_ALL
+#include "xxhash.h"
+
+#include "AccessionTaxonMapping.h"
+#include "Debug.h"
+#include "Util.h"
+#include "GzReader.h"
+#include "Timer.h"
+
+#include <algorithm>
+#include <cstring>
+
+// mapping files are read in blocks of this size, a block is split in chunks that are parsed in parallel
+static const size_t BLOCK_SIZE = 64 * 1024 * 1024;
+static const size_t MIN_CHUNK_SIZE = 64 * 1024;
+
+static inline uint64_t hashAccession(const char *accession, size_t length) {
+    return XXH64(accession, length, 0);
+}
+
+static inline bool isBlank(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+AccessionTaxonMapping::AccessionTaxonMapping(size_t expectedAccessions) : table(NULL), capacity(16) {
+    // keep the load factor below 0.8
+    while (capacity * 4 < expectedAccessions * 5) {
+        capacity *= 2;
+    }
+    table = new(std::nothrow) Bucket[capacity];
+    Util::checkAllocation(table, "Can not allocate table memory in AccessionTaxonMapping");
+    for (size_t i = 0; i < capacity; ++i) {
+        table[i].id = NOT_FOUND;
+    }
+    offsets.reserve(expectedAccessions + 1);
+    offsets.push_back(0);
+}
+
+AccessionTaxonMapping::~AccessionTaxonMapping() {
+    delete[] table;
+}
+
+void AccessionTaxonMapping::insertBucket(Bucket bucket) {
+    const size_t mask = capacity - 1;
+    size_t pos = bucket.hash & mask;
+    size_t dist = 0;
+    while (true) {
+        Bucket &curr = table[pos];
+        if (curr.id == NOT_FOUND) {
+            curr = bucket;
+            return;
+        }
+        // take the slot from entries that are closer to their home slot
+        size_t currDist = (pos - (curr.hash & mask)) & mask;
+        if (currDist < dist) {
+            std::swap(curr, bucket);
+            dist = currDist;
+        }
+        pos = (pos + 1) & mask;
+        dist++;
+    }
+}
+
+void AccessionTaxonMapping::grow() {
+    Bucket *prevTable = table;
+    size_t prevCapacity = capacity;
+    capacity *= 2;
+    table = new(std::nothrow) Bucket[capacity];
+    Util::checkAllocation(table, "Can not allocate table memory in AccessionTaxonMapping");
+    for (size_t i = 0; i < capacity; ++i) {
+        table[i].id = NOT_FOUND;
+    }
+    for (size_t i = 0; i < prevCapacity; ++i) {
+        if (prevTable[i].id != NOT_FOUND) {
+            insertBucket(prevTable[i]);
+        }
+    }
+    delete[] prevTable;
+}
+
+unsigned int AccessionTaxonMapping::find(const char *accession, size_t length) const {
+    const uint64_t hash = hashAccession(accession, length);
+    const size_t mask = capacity - 1;
+    size_t pos = hash & mask;
+    size_t dist = 0;
+    while (true) {
+        const Bucket &curr = table[pos];
+        // the accession would have displaced any entry closer to its home slot
+        if (curr.id == NOT_FOUND || ((pos - (curr.hash & mask)) & mask) < dist) {
+            return NOT_FOUND;
+        }
+        if (curr.hash == hash
+            && offsets[curr.id + 1] - offsets[curr.id] == length
+            && memcmp(accessions.data() + offsets[curr.id], accession, length) == 0) {
+            return curr.id;
+        }
+        pos = (pos + 1) & mask;
+        dist++;
+    }
+}
+
+unsigned int AccessionTaxonMapping::insert(const char *accession, size_t length) {
+    unsigned int id = find(accession, length);
+    if (id != NOT_FOUND) {
+        return id;
+    }
+    if ((size() + 1) * 5 > capacity * 4) {
+        grow();
+    }
+    id = size();
+    accessions.insert(accessions.end(), accession, accession + length);
+    offsets.push_back(accessions.size());
+    Bucket bucket;
+    bucket.hash = hashAccession(accession, length);
+    bucket.id = id;
+    insertBucket(bucket);
+    return id;
+}
+
+size_t AccessionTaxonMapping::parseBlock(const char *data, size_t size, unsigned int threads, const std::string &file) {
+    size_t chunks = std::max(std::min((size_t)threads * 4, size / MIN_CHUNK_SIZE), (size_t)1);
+    std::vector<size_t> chunkStart(chunks + 1, size);
+    chunkStart[0] = 0;
+    for (size_t i = 1; i < chunks; ++i) {
+        const char *lineEnd = (const char *) memchr(data + (size / chunks) * i, '\n', size - (size / chunks) * i);
+        chunkStart[i] = (lineEnd == NULL) ? size : (lineEnd - data) + 1;
+    }
+    // the matches are applied in input order afterwards so that the last line of an accession wins
+    std::vector<std::vector<std::pair<unsigned int, TaxID>>> chunkMatches(chunks);
+
+    size_t lines = 0;
+#pragma omp parallel for schedule(dynamic, 1) reduction(+:lines)
+    for (size_t i = 0; i < chunks; ++i) {
+        const char *pos = data + chunkStart[i];
+        const char *end = data + chunkStart[i + 1];
+        std::vector<std::pair<unsigned int, TaxID>> &matches = chunkMatches[i];
+        const char *fields[4];
+        size_t fieldLength[4];
+        while (pos < end) {
+            const char *lineEnd = (const char *) memchr(pos, '\n', end - pos);
+            if (lineEnd == NULL) {
+                lineEnd = end;
+            }
+            size_t columns = 0;
+            while (pos < lineEnd && columns < 4) {
+                while (pos < lineEnd && isBlank(*pos)) {
+                    pos++;
+                }
+                if (pos == lineEnd) {
+                    break;
+                }
+                fields[columns] = pos;
+                while (pos < lineEnd && isBlank(*pos) == false) {
+                    pos++;
+                }
+                fieldLength[columns] = pos - fields[columns];
+                columns++;
+            }
+            pos = lineEnd + 1;
+            if (columns == 0) {
+                continue;
+            }
+            lines++;
+            if (columns < 2) {
+                Debug(Debug::ERROR) << "Invalid accession2taxid file " << file << "\n";
+                EXIT(EXIT_FAILURE);
+            }
+
+            const size_t taxonColumn = (columns == 4) ? 2 : 1;
+            TaxID taxon = 0;
+            bool isNumber = fieldLength[taxonColumn] > 0;
+            for (size_t j = 0; j < fieldLength[taxonColumn]; ++j) {
+                char c = fields[taxonColumn][j];
+                isNumber &= (c >= '0' && c <= '9');
+                taxon = taxon * 10 + (c - '0');
+            }
+            // skips the header line of NCBI files
+            if (isNumber == false) {
+                continue;
+            }
+
+            unsigned int id = find(fields[0], fieldLength[0]);
+            if (id != NOT_FOUND) {
+                matches.emplace_back(id, taxon);
+            }
+            if (columns == 4) {
+                id = find(fields[1], fieldLength[1]);
+                if (id != NOT_FOUND) {
+                    matches.emplace_back(id, taxon);
+                }
+            }
+        }
+    }
+
+    for (size_t i = 0; i < chunks; ++i) {
+        for (size_t j = 0; j < chunkMatches[i].size(); ++j) {
+            taxa[chunkMatches[i][j].first] = chunkMatches[i][j].second;
+        }
+    }
+    return lines;
+}
+
+void AccessionTaxonMapping::readMappingFiles(const std::vector<std::string> &files, unsigned int threads) {
+    taxa.assign(size(), 0);
+
+    Timer timer;
+    size_t totalBytes = 0;
+    size_t totalLines = 0;
+    std::vector<char> buffer(BLOCK_SIZE);
+    for (size_t i = 0; i < files.size(); ++i) {
+        GzReader reader(files[i]);
+        if (reader.fail()) {
+            Debug(Debug::ERROR) << "File " << files[i] << " not found\n";
+            EXIT(EXIT_FAILURE);
+        }
+
+        size_t filled = 0;
+        bool isEof = false;
+        while (isEof == false) {
+            size_t bytes = reader.read(buffer.data() + filled, buffer.size() - filled);
+            isEof = (bytes == 0);
+            filled += bytes;
+            totalBytes += bytes;
+
+            // only parse complete lines, the rest is moved to the start of the next block
+            size_t blockSize = filled;
+            if (isEof == false) {
+                while (blockSize > 0 && buffer[blockSize - 1] != '\n') {
+                    blockSize--;
+                }
+                if (blockSize == 0) {
+                    // a single line is longer than the block
+                    if (filled == buffer.size()) {
+                        buffer.resize(buffer.size() * 2);
+                    }
+                    continue;
+                }
+            }
+            totalLines += parseBlock(buffer.data(), blockSize, threads, files[i]);
+            memmove(buffer.data(), buffer.data() + blockSize, filled - blockSize);
+            filled -= blockSize;
+        }
+    }
+
+    size_t resolved = 0;
+    for (size_t i = 0; i < taxa.size(); ++i) {
+        resolved += (taxa[i] != 0);
+    }
+    double seconds = std::max(timer.getTimediff(), 1e-6);
+    Debug(Debug::INFO) << "Read " << totalLines << " lines (" << (totalBytes >> 20) << " MB) from " << files.size()
+                       << " mapping files in " << timer.lap() << " (" << (size_t)(totalLines / seconds) << " lines/s, "
+                       << (size_t)((totalBytes >> 20) / seconds) << " MB/s)\n";
+    Debug(Debug::INFO) << "Resolved " << resolved << " of " << size() << " accessions\n";
+}
@@ -0,0 +1,56 @@
+#ifndef ACCESSION_TAXON_MAPPING_H
+#define ACCESSION_TAXON_MAPPING_H
+
+#include "NcbiTaxonomy.h"
+
+#include <climits>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// Resolves a set of accessions to taxa by joining them against accession2taxid files.
+// The accessions are collected first in a Robin Hood hash table, the mapping files are then read in large blocks
+// that are split at line boundaries and parsed in parallel, only looking up the accessions of each line.
+// A mapping file either has two columns (accession, taxid) or the four NCBI accession2taxid columns
+// (accession, accession.version, taxid, gi), in which case both accession columns are matched.
+class AccessionTaxonMapping {
+public:
+    static const unsigned int NOT_FOUND = UINT_MAX;
+
+    AccessionTaxonMapping(size_t expectedAccessions);
+    ~AccessionTaxonMapping();
+
+    // returns the id of the accession and adds it if it does not exist yet, ids are assigned consecutively from 0
+    unsigned int insert(const char *accession, size_t length);
+    unsigned int find(const char *accession, size_t length) const;
+
+    size_t size() const {
+        return offsets.size() - 1;
+    }
+
+    // 0 if the accession was not found in any mapping file
+    TaxID getTaxon(unsigned int id) const {
+        return taxa[id];
+    }
+
+    // if an accession occurs multiple times the last line wins
+    void readMappingFiles(const std::vector<std::string> &files, unsigned int threads);
+
+private:
+    struct Bucket {
+        uint64_t hash;
+        unsigned int id;
+    };
+
+    Bucket *table;
+    size_t capacity;
+    std::vector<char> accessions;
+    std::vector<size_t> offsets;
+    std::vector<TaxID> taxa;
+
+    void grow();
+    void insertBucket(Bucket bucket);
+    size_t parseBlock(const char *data, size_t size, unsigned int threads, const std::string &file);
+};
+
+#endif
@@ -1,21 +1,44 @@
 #ifndef MAPPING_READER_H
 #define MAPPING_READER_H
 
+#include "Debug.h"
 #include "Util.h"
 #include "MemoryMapped.h"
 #include <algorithm>
 
+// Maps database keys to TaxIDs, keys that are not in the mapping are mapped to 0.
+// The binary format written by createbintaxmapping stores one of three layouts, chosen by the density of the keys:
+// DIRECT: one TaxID per key up to the largest key
+// PAGED: a page index for every 2^PAGE_BITS keys pointing to pages of TaxIDs, pages without keys point to the empty page 0
+// PAIRS: (dbkey, taxon) pairs sorted by dbkey for lookups with binary search
 class MappingReader {
 public:
+    static const unsigned int LAYOUT_PAIRS = 0;
+    static const unsigned int LAYOUT_DIRECT = 1;
+    static const unsigned int LAYOUT_PAGED = 2;
+
     static std::pair<char *, size_t> serialize(const MappingReader &reader) {
-        size_t serialized_size = reader.magicLen + reader.count * sizeof(Pair);
-        char* data = (char*)malloc(serialized_size);
-        memcpy(data, reader.magic, reader.magicLen);
-        memcpy(data + reader.magicLen, reader.entries, reader.count * sizeof(Pair));
-        return std::make_pair(data, serialized_size);
+        char* data = (char*)malloc(reader.dataSize);
+        Util::checkAllocation(data, "Can not allocate data memory in MappingReader::serialize");
+        memcpy(data, reader.data, reader.dataSize);
+        return std::make_pair(data, reader.dataSize);
+    }
+
+    // serializes (dbkey, taxon) pairs sorted by dbkey, the first pair of a key wins
+    static std::pair<char *, size_t> serialize(const std::vector<std::pair<unsigned int, unsigned int>> &mapping) {
+        std::vector<Pair> pairs(mapping.size());
+        for (size_t i = 0; i < mapping.size(); ++i) {
+            pairs[i].dbkey = mapping[i].first;
+            pairs[i].taxon = mapping[i].second;
+        }
+        return build(pairs);
+    }
+
+    static bool isBinary(const char *data, size_t size) {
+        return size >= magicLen && memcmp(data, magic(), magicLen - 1) == 0;
     }
 
-    MappingReader(const std::string &db, const bool dbInput = true) {
+    MappingReader(const std::string &db, const bool dbInput = true) : ownedData(NULL) {
         std::string input = dbInput ? db + "_mapping" : db;
         file = new MemoryMapped(input, MemoryMapped::WholeFile, MemoryMapped::SequentialScan);
         if (!file->isValid()) {
@@ -24,84 +47,237 @@ public:
             Debug(Debug::ERROR) << db << "_mapping does not exist. Please create the taxonomy mapping!\n";
             EXIT(EXIT_FAILURE);
         }
-        char *data = (char *) file->getData();
-        size_t dataSize = file->size();
-        if (file->size() > magicLen && memcmp(data, magic, magicLen) == 0) {
-            entries = reinterpret_cast<Pair*>(data + magicLen);
-            count = (dataSize - magicLen) / sizeof(Pair);
+        char *fileData = (char *) file->getData();
+        size_t fileSize = file->size();
+        if (fileSize >= magicLen + sizeof(Header) && memcmp(fileData, magic(), magicLen) == 0) {
+            data = fileData;
+            dataSize = fileSize;
+            setPointers();
             return;
         }
-        std::vector<std::pair<unsigned int, unsigned int>> mapping;
-        size_t currPos = 0;
-        const char *cols[3];
-        size_t isSorted = true;
-        unsigned int prevId = 0;
-        while (currPos < dataSize) {
-            Util::getWordsOfLine(data, cols, 2);
-            unsigned int id = Util::fast_atoi<size_t>(cols[0]);
-            isSorted *= (id >= prevId);
-            unsigned int taxid = Util::fast_atoi<size_t>(cols[1]);
-            data = Util::skipLine(data);
-            mapping.push_back(std::make_pair(id, taxid));
-            currPos = data - (char *) file->getData();
-            prevId = id;
+
+        std::vector<Pair> mapping;
+        if (fileSize > magicLen && memcmp(fileData, magic(), magicLen - 1) == 0 && fileData[magicLen - 1] == 0) {
+            // version 0 only stored the sorted pairs
+            const Pair *pairs = reinterpret_cast<const Pair*>(fileData + magicLen);
+            mapping.assign(pairs, pairs + (fileSize - magicLen) / sizeof(Pair));
+        } else {
+            char *line = fileData;
+            size_t currPos = 0;
+            const char *cols[3];
+            size_t isSorted = true;
+            unsigned int prevId = 0;
+            while (currPos < fileSize) {
+                Util::getWordsOfLine(line, cols, 2);
+                Pair pair;
+                pair.dbkey = Util::fast_atoi<size_t>(cols[0]);
+                isSorted *= (pair.dbkey >= prevId);
+                pair.taxon = Util::fast_atoi<size_t>(cols[1]);
+                line = Util::skipLine(line);
+                mapping.push_back(pair);
+                currPos = line - fileData;
+                prevId = pair.dbkey;
+            }
+            if (mapping.size() == 0) {
+                Debug(Debug::ERROR) << db << "_mapping is empty. Rerun createtaxdb to recreate taxonomy mapping.\n";
+                EXIT(EXIT_FAILURE);
+            }
+            if (isSorted == false) {
+                std::stable_sort(mapping.begin(), mapping.end(), compareTaxa);
+            }
         }
         file->close();
         delete file;
         file = NULL;
-        if (mapping.size() == 0) {
-            Debug(Debug::ERROR) << db << "_mapping is empty. Rerun createtaxdb to recreate taxonomy mapping.\n";
-            EXIT(EXIT_FAILURE);
-        }
 
-        count = mapping.size();
-        entries = new Pair[count];
-        for (size_t i = 0; i < count; ++i) {
-            entries[i].dbkey = mapping[i].first;
-            entries[i].taxon = mapping[i].second;
-        }
-        if (isSorted == false) {
-            std::stable_sort(entries, entries + count, compareTaxa);
-        }
+        std::pair<char*, size_t> built = build(mapping);
+        ownedData = built.first;
+        data = built.first;
+        dataSize = built.second;
+        setPointers();
     }
 
     ~MappingReader() {
         if (file != NULL) {
             file->close();
             delete file;
-        } else {
-            delete[] entries;
         }
+        free(ownedData);
     }
 
-    unsigned int lookup(unsigned int key) {
-        unsigned int taxon = 0;
+    unsigned int lookup(unsigned int key) const {
         // match dbKey to its taxon based on mapping
-        Pair val;
-        val.dbkey = key;
-        Pair* end = entries + count;
-        Pair* found = std::upper_bound(entries, end, val, compareTaxa);
-        if (found == end || found->dbkey != key) {
-            taxon = 0;
-        } else {
-            taxon = found->taxon;
+        if (key >= header->keyRange) {
+            return 0;
+        }
+        switch (header->layout) {
+            case LAYOUT_DIRECT:
+                return taxa[key];
+            case LAYOUT_PAGED:
+                return taxa[((size_t)pageIndex[key >> PAGE_BITS] << PAGE_BITS) + (key & PAGE_KEY_MASK)];
+            default: {
+                Pair val;
+                val.dbkey = key;
+                const Pair* end = entries + header->count;
+                const Pair* found = std::lower_bound(entries, end, val, compareTaxa);
+                if (found == end || found->dbkey != key) {
+                    return 0;
+                }
+                return found->taxon;
+            }
+        }
+    }
+
+    unsigned int getLayout() const {
+        return header->layout;
+    }
+
+    // (dbkey, taxon) pairs sorted by dbkey, table layouts do not keep keys mapped to taxon 0
+    void getMapping(std::vector<std::pair<unsigned int, unsigned int>> &mapping) const {
+        if (header->layout == LAYOUT_PAIRS) {
+            for (size_t i = 0; i < header->count; ++i) {
+                mapping.emplace_back(entries[i].dbkey, entries[i].taxon);
+            }
+            return;
+        }
+        for (size_t key = 0; key < header->keyRange; ++key) {
+            unsigned int taxon = lookup(key);
+            if (taxon != 0) {
+                mapping.emplace_back(key, taxon);
+            }
         }
-        return taxon;
     }
 
 private:
-    MemoryMapped* file;
     struct __attribute__((__packed__)) Pair{
         unsigned int dbkey;
         unsigned int taxon;
     };
-    Pair* entries;
-    size_t count;
-    //                    T  A   X   M  Version
-    const char magic[5] = {19, 0, 23, 12, 0};
-    const size_t magicLen = 5;
+    struct Header {
+        unsigned int layout;
+        unsigned int padding;
+        size_t keyRange; // largest key + 1
+        size_t count;    // number of keys
+        size_t pageCount;
+    };
+
+    MemoryMapped* file;
+    char* ownedData;
+    const char* data;
+    size_t dataSize;
+
+    const Header* header;
+    const Pair* entries;
+    const unsigned int* taxa;
+    const unsigned int* pageIndex;
+
+    static const unsigned int PAGE_BITS = 12;
+    static const unsigned int KEYS_PER_PAGE = 1u << PAGE_BITS;
+    static const unsigned int PAGE_KEY_MASK = KEYS_PER_PAGE - 1;
+
+    static const char* magic() {
+        //                              T  A   X   M  Version
+        static const char bytes[5] = {19, 0, 23, 12, 1};
+        return bytes;
+    }
+    // the header starts after the magic at an 8 byte boundary
+    static const size_t magicLen = 5;
+    static const size_t headerOffset = 8;
+
     static bool compareTaxa(const Pair &lhs, const Pair &rhs) {
-        return (lhs.dbkey <= rhs.dbkey);
+        return (lhs.dbkey < rhs.dbkey);
+    }
+
+    static size_t pageIndexSize(size_t keyRange) {
+        size_t pages = (keyRange + KEYS_PER_PAGE - 1) >> PAGE_BITS;
+        // keep the pages 8 byte aligned
+        return (pages + (pages & 1)) * sizeof(unsigned int);
+    }
+
+    void setPointers() {
+        header = reinterpret_cast<const Header*>(data + headerOffset);
+        const char* p = data + headerOffset + sizeof(Header);
+        entries = reinterpret_cast<const Pair*>(p);
+        taxa = reinterpret_cast<const unsigned int*>(p);
+        pageIndex = NULL;
+        if (header->layout == LAYOUT_PAGED) {
+            pageIndex = reinterpret_cast<const unsigned int*>(p);
+            taxa = reinterpret_cast<const unsigned int*>(p + pageIndexSize(header->keyRange));
+        }
+    }
+
+    // expects pairs sorted by dbkey, the first pair of a key wins
+    static std::pair<char*, size_t> build(const std::vector<Pair> &mapping) {
+        size_t count = 0;
+        size_t usedPages = 0;
+        for (size_t i = 0; i < mapping.size(); ++i) {
+            if (i > 0 && mapping[i].dbkey == mapping[i - 1].dbkey) {
+                continue;
+            }
+            count++;
+            if (count == 1 || (mapping[i].dbkey >> PAGE_BITS) != (mapping[i - 1].dbkey >> PAGE_BITS)) {
+                usedPages++;
+            }
+        }
+        Header h;
+        h.padding = 0;
+        h.count = count;
+        h.keyRange = (count == 0) ? 0 : (size_t)mapping.back().dbkey + 1;
+        h.pageCount = 0;
+
+        // use a direct or paged table as long as it is at most twice as large as the pairs
+        const size_t pairsSize = count * sizeof(Pair);
+        const size_t directSize = h.keyRange * sizeof(unsigned int);
+        const size_t pagedSize = pageIndexSize(h.keyRange) + (usedPages + 1) * KEYS_PER_PAGE * sizeof(unsigned int);
+        size_t bodySize;
+        if (directSize <= 2 * pairsSize) {
+            h.layout = LAYOUT_DIRECT;
+            bodySize = directSize;
+        } else if (pagedSize <= 2 * pairsSize) {
+            h.layout = LAYOUT_PAGED;
+            h.pageCount = usedPages + 1;
+            bodySize = pagedSize;
+        } else {
+            h.layout = LAYOUT_PAIRS;
+            bodySize = pairsSize;
+        }
+
+        size_t size = headerOffset + sizeof(Header) + bodySize;
+        char* mem = (char*)calloc(size, sizeof(char));
+        Util::checkAllocation(mem, "Can not allocate mem memory in MappingReader::build");
+        memcpy(mem, magic(), magicLen);
+        memcpy(mem + headerOffset, &h, sizeof(Header));
+        char* p = mem + headerOffset + sizeof(Header);
+        if (h.layout == LAYOUT_PAIRS) {
+            Pair* out = reinterpret_cast<Pair*>(p);
+            for (size_t i = 0; i < mapping.size(); ++i) {
+                if (i == 0 || mapping[i].dbkey != mapping[i - 1].dbkey) {
+                    *(out++) = mapping[i];
+                }
+            }
+        } else if (h.layout == LAYOUT_DIRECT) {
+            unsigned int* out = reinterpret_cast<unsigned int*>(p);
+            for (size_t i = 0; i < mapping.size(); ++i) {
+                if (i == 0 || mapping[i].dbkey != mapping[i - 1].dbkey) {
+                    out[mapping[i].dbkey] = mapping[i].taxon;
+                }
+            }
+        } else {
+            unsigned int* index = reinterpret_cast<unsigned int*>(p);
+            unsigned int* pages = reinterpret_cast<unsigned int*>(p + pageIndexSize(h.keyRange));
+            unsigned int page = 0;
+            for (size_t i = 0; i < mapping.size(); ++i) {
+                if (i > 0 && mapping[i].dbkey == mapping[i - 1].dbkey) {
+                    continue;
+                }
+                unsigned int indexPos = mapping[i].dbkey >> PAGE_BITS;
+                if (index[indexPos] == 0) {
+                    index[indexPos] = ++page;
+                }
+                pages[((size_t)index[indexPos] << PAGE_BITS) + (mapping[i].dbkey & PAGE_KEY_MASK)] = mapping[i].taxon;
+            }
+        }
+        return std::make_pair(mem, size);
     }
 };
 
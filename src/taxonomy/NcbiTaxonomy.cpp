@@ -3,32 +3,25 @@
 #include "MathUtil.h"
 #include "Debug.h"
 #include "Util.h"
+#include "itoa.h"
 #include "sys/mman.h"
 
 #include <fstream>
 #include <algorithm>
 #include <cassert>
 
-const int NcbiTaxonomy::SERIALIZATION_VERSION = 2;
+const int NcbiTaxonomy::SERIALIZATION_VERSION = 4;
 
-int **makeMatrix(size_t maxNodes) {
-    size_t dimension = maxNodes * 2;
-    int **M = new int*[dimension];
-    int k = (int)(MathUtil::flog2(dimension)) + 1;
-    M[0] = new int[dimension * k]();
-    for(size_t i = 1; i < dimension; i++) {
-        M[i] = M[i-1] + k;
-    }
-
-    return M;
+size_t NcbiTaxonomy::sparseTableColumns(size_t maxNodes) {
+    return (size_t)(MathUtil::flog2(maxNodes * 2)) + 1;
 }
 
-void deleteMatrix(int** M) {
-    delete[] M[0];
-    delete[] M;
+// sections of the binary taxonomy start at 8 byte boundaries, so all arrays can be used in place
+static size_t alignedSize(size_t size) {
+    return (size + 7) & ~((size_t)7);
 }
 
-NcbiTaxonomy::NcbiTaxonomy(const std::string &namesFile, const std::string &nodesFile, const std::string &mergedFile) : externalData(false) {
+NcbiTaxonomy::NcbiTaxonomy(const std::string &namesFile, const std::string &nodesFile, const std::string &mergedFile) : externalData(false), externalLineage(false) {
     block = new StringBlock<unsigned int>();
     std::vector<TaxonNode> tmpNodes;
     loadNodes(tmpNodes, nodesFile);
@@ -64,23 +57,28 @@ NcbiTaxonomy::NcbiTaxonomy(const std::string &namesFile, const std::string &node
     L = new int[maxNodes * 2];
     std::copy(tmpL.begin(), tmpL.end(), L);
 
-    M = makeMatrix(maxNodes);
+    matrixK = sparseTableColumns(maxNodes);
+    M = new int[maxNodes * 2 * matrixK]();
     computeSparseTable();
 
+    lineage = new TaxonLineage[maxNodes];
+    computeLineage();
+
     mmapData = NULL;
     mmapSize = 0;
 }
 
 NcbiTaxonomy::~NcbiTaxonomy() {
-    if (externalData) {
-        delete[] M;
-    } else {
+    if (externalData == false) {
         delete[] taxonNodes;
         delete[] H;
         delete[] D;
         delete[] E;
         delete[] L;
-        deleteMatrix(M);
+        delete[] M;
+    }
+    if (externalLineage == false) {
+        delete[] lineage;
     }
     delete block;
     if (mmapData != NULL) {
@@ -202,7 +200,7 @@ void NcbiTaxonomy::elh(std::vector<std::vector<TaxID>> const & children, TaxID t
 void NcbiTaxonomy::computeSparseTable() {
     Debug(Debug::INFO) << "Init computeSparseTable ...";
     // sparse table M has N rows and log(N) columns.
-    // M[i][j] refers to the subarray L[i..2^j]
+    // M[i][j] refers to the subarray L[i..2^j], stored at M[i * matrixK + j]
     // M[i][j] holds the index of the minimal value in the subarray
     size_t N = maxNodes * 2; // TO DO - I think this can actually be changed to maxNodes!!!
     // Debug(Debug::INFO) << "N: " << N << "\n";
@@ -211,7 +209,7 @@ void NcbiTaxonomy::computeSparseTable() {
 
     // initialize all rows for column 0
     for (size_t row_ind = 0; row_ind < N; row_ind++) {
-        M[row_ind][0] = row_ind;
+        M[row_ind * matrixK] = row_ind;
         // helperCount++;
     }
 
@@ -223,13 +221,13 @@ void NcbiTaxonomy::computeSparseTable() {
     while (exp_col_ind <= N) {   
         size_t row_ind = 0;
         while (row_ind + exp_col_ind - 1 < N) {
-            int min_ind_first_half = M[row_ind][col_ind - 1];
-            int min_ind_second_half = M[row_ind + exp_prev_col_ind][col_ind - 1];
+            int min_ind_first_half = M[row_ind * matrixK + col_ind - 1];
+            int min_ind_second_half = M[(row_ind + exp_prev_col_ind) * matrixK + col_ind - 1];
             if (L[min_ind_first_half] < L[min_ind_second_half]) {
-                M[row_ind][col_ind] = min_ind_first_half;
+                M[row_ind * matrixK + col_ind] = min_ind_first_half;
                 // helperCount++;
             } else {
-                M[row_ind][col_ind] = min_ind_second_half;
+                M[row_ind * matrixK + col_ind] = min_ind_second_half;
                 // helperCount++;
             }
             // increase row_ind
@@ -247,11 +245,39 @@ void NcbiTaxonomy::computeSparseTable() {
     Debug(Debug::INFO) << "Done\n";
 }
 
+void NcbiTaxonomy::computeLineage() {
+    for (size_t i = 0; i < maxNodes; ++i) {
+        const std::string rank = getString(taxonNodes[i].rankIdx);
+        lineage[i].parentId = nodeId(taxonNodes[i].parentTaxId);
+        lineage[i].rankedParentId = -2;
+        lineage[i].rankIndex = findRankIndex(rank);
+        lineage[i].shortRank = findShortRank(rank);
+    }
+
+    // resolve the closest ranked ancestor top-down along each path
+    std::vector<int> path;
+    for (size_t i = 0; i < maxNodes; ++i) {
+        int id = i;
+        while (lineage[id].rankedParentId == -2 && lineage[id].parentId != id) {
+            path.emplace_back(id);
+            id = lineage[id].parentId;
+        }
+        if (lineage[id].rankedParentId == -2) {
+            lineage[id].rankedParentId = -1;
+        }
+        for (std::vector<int>::reverse_iterator it = path.rbegin(); it != path.rend(); ++it) {
+            int parent = lineage[*it].parentId;
+            lineage[*it].rankedParentId = (lineage[parent].rankIndex > 0) ? parent : lineage[parent].rankedParentId;
+        }
+        path.clear();
+    }
+}
+
 int NcbiTaxonomy::RangeMinimumQuery(int i, int j) const {
     assert(j >= i);
     int k = (int)MathUtil::flog2(j - i + 1);
-    int A = M[i][k];
-    int B = M[j - MathUtil::ipow<int>(2, k) + 1][k];
+    int A = M[i * matrixK + k];
+    int B = M[(j - MathUtil::ipow<int>(2, k) + 1) * matrixK + k];
     if (L[A] <= L[B]) {
         return A;
     }
@@ -299,6 +325,50 @@ bool NcbiTaxonomy::IsAncestor(TaxID ancestor, TaxID child) {
     return lcaHelper(nodeId(child), nodeId(ancestor)) == nodeId(ancestor);
 }
 
+std::vector<TaxID> NcbiTaxonomy::parseBlacklist(const std::string &blacklistString) const {
+    std::vector<TaxID> blacklist;
+    std::vector<std::string> splits = Util::split(blacklistString, ",");
+    for (size_t i = 0; i < splits.size(); ++i) {
+        TaxID taxon = Util::fast_atoi<int>(splits[i].c_str());
+        if (taxon == 0) {
+            Debug(Debug::WARNING) << "Cannot block root taxon 0\n";
+            continue;
+        }
+        if (nodeExists(taxon) == false) {
+            Debug(Debug::WARNING) << "Ignoring missing blocked taxon " << taxon << "\n";
+            continue;
+        }
+
+        const char *split;
+        if ((split = strchr(splits[i].c_str(), ':')) != NULL) {
+            const char* name = split + 1;
+            const TaxonNode* node = taxonNode(taxon, false);
+            if (node == NULL) {
+                Debug(Debug::WARNING) << "Ignoring missing blocked taxon " << taxon << "\n";
+                continue;
+            }
+            const char* nodeName = getString(node->nameIdx);
+            if (strcmp(nodeName, name) != 0) {
+                Debug(Debug::WARNING) << "Node name '" << name << "' does not match to be blocked name '" << nodeName << "'\n";
+                continue;
+            }
+        }
+        blacklist.emplace_back(taxon);
+    }
+    return blacklist;
+}
+
+bool NcbiTaxonomy::isBlacklisted(const std::vector<TaxID> &blacklist, TaxID taxon) {
+    for (size_t j = 0; j < blacklist.size(); ++j) {
+        if (blacklist[j] == 0) {
+            continue;
+        }
+        if (IsAncestor(blacklist[j], taxon)) {
+            return true;
+        }
+    }
+    return false;
+}
 
 TaxID NcbiTaxonomy::LCA(TaxID taxonA, TaxID taxonB) const {
     if (!nodeExists(taxonA)) {
@@ -332,25 +402,37 @@ TaxonNode const * NcbiTaxonomy::LCA(const std::vector<TaxID>& taxa) const {
 }
 
 
+// fills atRank with the lowest node of each rank from NcbiRanks on the path to the root, -1 if there is none
+void NcbiTaxonomy::nodesAtRanks(int id, int *atRank) const {
+    std::fill(atRank, atRank + RANK_SLOTS, -1);
+    if (lineage[id].rankIndex <= 0) {
+        id = lineage[id].rankedParentId;
+    }
+    while (id != -1) {
+        int rankIndex = lineage[id].rankIndex;
+        if (atRank[rankIndex] == -1) {
+            atRank[rankIndex] = id;
+        }
+        id = lineage[id].rankedParentId;
+    }
+}
+
 // AtRanks returns a slice of slices having the taxons at the specified taxonomic levels
 std::vector<std::string> NcbiTaxonomy::AtRanks(TaxonNode const *node, const std::vector<std::string> &levels) const {
     std::vector<std::string> result;
-    std::map<std::string, std::string> allRanks = AllRanks(node);
-    // map does not include "no rank" nor "no_rank"
-    const char* rank = getString(node->rankIdx);
-    int baseRankIndex = findRankIndex(rank);
-    std::string baseRank = "uc_";
-    baseRank.append(getString(node->nameIdx));
+    int atRank[RANK_SLOTS];
+    nodesAtRanks(node->id, atRank);
+    const int baseRankIndex = lineage[node->id].rankIndex;
     for (std::vector<std::string>::const_iterator it = levels.begin(); it != levels.end(); ++it) {
-        std::map<std::string, std::string>::iterator jt = allRanks.find(*it);
-        if (jt != allRanks.end()) {
-            result.emplace_back(jt->second);
+        int rankIndex = NcbiRanks.at(*it);
+        if (atRank[rankIndex] != -1) {
+            result.emplace_back(getString(taxonNodes[atRank[rankIndex]].nameIdx));
             continue;
         }
 
         // If not ... 2 possible causes: i) too low level ("uc_")
-        if (NcbiRanks.at(*it) < baseRankIndex) {
-            result.emplace_back(baseRank);
+        if (rankIndex < baseRankIndex) {
+            result.emplace_back(std::string("uc_") + getString(node->nameIdx));
             continue;
         }
 
@@ -360,6 +442,28 @@ std::vector<std::string> NcbiTaxonomy::AtRanks(TaxonNode const *node, const std:
     return result;
 }
 
+void NcbiTaxonomy::appendAtRanks(std::string &out, TaxonNode const *node, const std::vector<int> &levelIndices) const {
+    int atRank[RANK_SLOTS];
+    nodesAtRanks(node->id, atRank);
+    const int baseRankIndex = lineage[node->id].rankIndex;
+    for (size_t i = 0; i < levelIndices.size(); ++i) {
+        if (i > 0) {
+            out.append(1, ';');
+        }
+        int rankIndex = levelIndices[i];
+        if (atRank[rankIndex] != -1) {
+            out.append(getString(taxonNodes[atRank[rankIndex]].nameIdx));
+        } else if (rankIndex < baseRankIndex) {
+            // the node is above the requested rank
+            out.append("uc_");
+            out.append(getString(node->nameIdx));
+        } else {
+            // no taxon for the node at the requested rank
+            out.append("unknown");
+        }
+    }
+}
+
 std::vector<std::string> NcbiTaxonomy::parseRanks(const std::string& ranks) {
     std::vector<std::string> temp = Util::split(ranks, ",");
     for (size_t i = 0; i < temp.size(); ++i) {
@@ -379,6 +483,15 @@ int NcbiTaxonomy::findRankIndex(const std::string& rank) {
     return -1;
 }
 
+std::vector<int> NcbiTaxonomy::findRankIndices(const std::vector<std::string>& ranks) {
+    std::vector<int> indices;
+    indices.reserve(ranks.size());
+    for (size_t i = 0; i < ranks.size(); ++i) {
+        indices.emplace_back(NcbiRanks.at(ranks[i]));
+    }
+    return indices;
+}
+
 char NcbiTaxonomy::findShortRank(const std::string& rank) {
     std::map<std::string, char>::const_iterator it;
     if ((it = NcbiShortRanks.find(rank)) != NcbiShortRanks.end()) {
@@ -388,28 +501,32 @@ char NcbiTaxonomy::findShortRank(const std::string& rank) {
 }
 
 std::string NcbiTaxonomy::taxLineage(TaxonNode const *node, bool infoAsName) {
-    std::vector<TaxonNode const *> taxLineageVec;
     std::string taxLineage;
     taxLineage.reserve(4096);
-    do {
-        taxLineageVec.push_back(node);
-        node = taxonNode(node->parentTaxId);
-    } while (node->parentTaxId != node->taxId);
+    appendTaxLineage(taxLineage, node, infoAsName);
+    return taxLineage;
+}
 
-    for (int i = taxLineageVec.size() - 1; i >= 0; --i) {
-        if (infoAsName) {
-            taxLineage += findShortRank(getString(taxLineageVec[i]->rankIdx));
-            taxLineage += '_';
-            taxLineage += getString(taxLineageVec[i]->nameIdx);
-        } else {
-            taxLineage += SSTR(taxLineageVec[i]->taxId);
-        }
+void NcbiTaxonomy::appendTaxLineage(std::string &out, TaxonNode const *node, bool infoAsName) const {
+    appendLineage(out, node->id, infoAsName);
+}
 
-        if (i > 0) {
-            taxLineage += ";";
-        }
+// the lineage starts below the root, except for the root itself
+void NcbiTaxonomy::appendLineage(std::string &out, int id, bool infoAsName) const {
+    int parent = lineage[id].parentId;
+    if (parent != id && lineage[parent].parentId != parent) {
+        appendLineage(out, parent, infoAsName);
+        out.append(1, ';');
+    }
+    if (infoAsName) {
+        out.append(1, lineage[id].shortRank);
+        out.append(1, '_');
+        out.append(getString(taxonNodes[id].nameIdx));
+    } else {
+        char buffer[32];
+        char *end = Itoa::i32toa_sse2(taxonNodes[id].taxId, buffer);
+        out.append(buffer, end - buffer - 1);
     }
-    return taxLineage;
 }
 
 int NcbiTaxonomy::nodeId(TaxID taxonId) const {
@@ -501,59 +618,56 @@ size_t NcbiTaxonomy::loadMerged(const std::string &mergedFile) {
     return count;
 }
 
-std::unordered_map<TaxID, std::vector<TaxID>> NcbiTaxonomy::getParentToChildren() const {
-    std::unordered_map<TaxID, std::vector<TaxID>> result;
-    result.reserve(maxNodes);
-    
-    // Build the adjacency (parent -> children)
+TaxonTree NcbiTaxonomy::getTaxonTree() const {
+    TaxonTree tree;
+    tree.parent.resize(maxNodes);
+    tree.offsets.assign(maxNodes + 1, 0);
     for (size_t i = 0; i < maxNodes; ++i) {
-        const TaxonNode& tn = taxonNodes[i];
-        if (tn.parentTaxId == tn.taxId) {
-            continue;
+        tree.parent[i] = nodeId(taxonNodes[i].parentTaxId);
+        if (tree.parent[i] != (int)i) {
+            tree.offsets[tree.parent[i] + 1]++;
         }
-        result[tn.parentTaxId].push_back(tn.taxId);
     }
-
-    return result;
-}
-
-std::unordered_map<TaxID, TaxonCounts> NcbiTaxonomy::getCladeCounts(const std::unordered_map<TaxID, unsigned int>& taxonCounts, const std::unordered_map<TaxID, std::vector<TaxID>>& parentToChildren) const {
-    std::unordered_map<TaxID, TaxonCounts> cladeCounts;
-
-    for (std::unordered_map<TaxID, unsigned int>::const_iterator it = taxonCounts.begin(); it != taxonCounts.end(); ++it) {
-        cladeCounts[it->first].taxCount = it->second;
-        cladeCounts[it->first].cladeCount += it->second;
-        if (nodeExists(it->first)) {
-            TaxonNode const* taxon = taxonNode(it->first);
-            while (taxon->parentTaxId != taxon->taxId && nodeExists(taxon->parentTaxId)) {
-                taxon = taxonNode(taxon->parentTaxId);
-                cladeCounts[taxon->taxId].cladeCount += it->second;
-            }
-        }
+    for (size_t i = 0; i < maxNodes; ++i) {
+        tree.offsets[i + 1] += tree.offsets[i];
     }
 
-   for (std::unordered_map<TaxID, TaxonCounts>::iterator it = cladeCounts.begin(); it != cladeCounts.end(); ++it) {
-        TaxID parentTaxId = it->first;
-        TaxonCounts& taxCounts = it->second;
-        std::unordered_map<TaxID, std::vector<TaxID>>::const_iterator ptcIt = parentToChildren.find(parentTaxId);
-        if (ptcIt != parentToChildren.end()) {
-            taxCounts.children = ptcIt->second;
+    tree.children.resize(tree.offsets[maxNodes]);
+    std::vector<size_t> next(tree.offsets.begin(), tree.offsets.end() - 1);
+    for (size_t i = 0; i < maxNodes; ++i) {
+        if (tree.parent[i] != (int)i) {
+            tree.children[next[tree.parent[i]]++] = i;
         }
     }
 
-    return cladeCounts;
+    tree.preorder.reserve(maxNodes);
+    std::vector<int> stack;
+    // root has TaxID 1
+    stack.emplace_back(nodeId(1));
+    while (stack.empty() == false) {
+        int id = stack.back();
+        stack.pop_back();
+        tree.preorder.emplace_back(id);
+        stack.insert(stack.end(), tree.children.begin() + tree.offsets[id], tree.children.begin() + tree.offsets[id + 1]);
+    }
+    return tree;
 }
 
 NcbiTaxonomy * NcbiTaxonomy::openTaxonomy(const std::string &database){
     std::string binFile = database + "_taxonomy";
     if (FileUtil::fileExists(binFile.c_str())) {
         FILE* handle = fopen(binFile.c_str(), "r");
+        if (handle == NULL) {
+            Debug(Debug::ERROR) << "Could not open " << binFile << " for reading\n";
+            EXIT(EXIT_FAILURE);
+        }
         struct stat sb;
         if (fstat(fileno(handle), &sb) < 0) {
             Debug(Debug::ERROR) << "Failed to fstat file " << binFile << "\n";
             EXIT(EXIT_FAILURE);
         }
-        char* data = (char*)mmap(NULL, sb.st_size, PROT_READ, MAP_PRIVATE, fileno(handle), 0);
+        // nothing is copied out of the mapping, concurrent processes share the pages from the page cache
+        char* data = (char*)mmap(NULL, sb.st_size, PROT_READ, MAP_SHARED, fileno(handle), 0);
         if (data == MAP_FAILED){
             Debug(Debug::ERROR) << "Failed to mmap file " << binFile << " with error " << errno << "\n";
             EXIT(EXIT_FAILURE);
@@ -565,6 +679,7 @@ NcbiTaxonomy * NcbiTaxonomy::openTaxonomy(const std::string &database){
             t->mmapSize = sb.st_size;
             return t;
         } else {
+            munmap(data, sb.st_size);
             Debug(Debug::WARNING) << "Outdated taxonomy information, please recreate with createtaxdb.\n";
         }
     }
@@ -591,23 +706,6 @@ NcbiTaxonomy * NcbiTaxonomy::openTaxonomy(const std::string &database){
 const TaxID ROOT_TAXID = 1;
 const int ROOT_RANK = INT_MAX;
 
-struct TaxNode {
-    TaxNode(const double weight, const bool isCandidate, const TaxID childTaxon)
-            : weight(weight), isCandidate(isCandidate), childTaxon(childTaxon) {}
-
-    void update(const double weightToAdd, const TaxID & childTaxonInput) {
-        if (childTaxon != childTaxonInput) {
-            isCandidate = true;
-            childTaxon = childTaxonInput;
-        }
-        weight += weightToAdd;
-    }
-
-    double weight;
-    bool isCandidate;
-    TaxID childTaxon;
-};
-
 const char* NcbiTaxonomy::getString(size_t blockIdx) const {
     return block->getString(blockIdx);
 }
@@ -636,9 +734,10 @@ WeightedTaxHit::WeightedTaxHit(const TaxID taxon, const float evalue, const int
     }
 }
 
-WeightedTaxResult NcbiTaxonomy::weightedMajorityLCA(const std::vector<WeightedTaxHit> &setTaxa, const float majorityCutoff) {
+WeightedTaxResult NcbiTaxonomy::weightedMajorityLCA(const std::vector<WeightedTaxHit> &setTaxa, const float majorityCutoff, WeightedLCABuffer &buffer) const {
     // count num occurences of each ancestor, possibly weighted
-    std::map<TaxID, TaxNode> ancTaxIdsCounts;
+    std::vector<int> &slots = buffer.slots;
+    std::vector<WeightedLCABuffer::Node> &nodes = buffer.nodes;
 
     // initialize counters and weights
     size_t assignedSeqs = 0;
@@ -661,73 +760,99 @@ WeightedTaxResult NcbiTaxonomy::weightedMajorityLCA(const std::vector<WeightedTa
         totalAssignedSeqsWeights += currWeight;
         assignedSeqs++;
 
-        // each start of a path due to an orf is a candidate
-        std::map<TaxID, TaxNode>::iterator it;
-        if ((it = ancTaxIdsCounts.find(currTaxId)) != ancTaxIdsCounts.end()) {
-            it->second.update(currWeight, 0);
-        } else {
-            TaxNode current(currWeight, true, 0);
-            ancTaxIdsCounts.emplace(currTaxId, current);
-        }
-
-        // iterate all ancestors up to root (including). add currWeight and candidate status to each
-        TaxID currParentTaxId = node->parentTaxId;
-        while (currParentTaxId != currTaxId) {
-            if ((it = ancTaxIdsCounts.find(currParentTaxId)) != ancTaxIdsCounts.end()) {
-                it->second.update(currWeight, currTaxId);
-            } else {
-                TaxNode parent(currWeight, false, currTaxId);
-                ancTaxIdsCounts.emplace(currParentTaxId, parent);
+        // each start of a path due to an orf is a candidate, its child is marked with -1
+        // a node reached from two different children is a candidate too
+        // the walk ends at the first node already on the path of a previous hit
+        int currId = node->id;
+        int childId = -1;
+        while (true) {
+            int slot = slots[currId];
+            if (slot != -1) {
+                WeightedLCABuffer::Node &current = nodes[slot];
+                if (current.childId != childId) {
+                    current.isCandidate = true;
+                    current.childId = childId;
+                }
+                if (childId == -1) {
+                    current.weight += currWeight;
+                }
+                break;
+            }
+            slots[currId] = nodes.size();
+            TaxID taxon = (childId == -1) ? currTaxId : taxonNodes[currId].taxId;
+            WeightedLCABuffer::Node current = { taxon, currId, childId, L[H[currId]], childId == -1, (childId == -1) ? currWeight : 0.0 };
+            nodes.emplace_back(current);
+            int parentId = lineage[currId].parentId;
+            if (parentId == currId) {
+                break;
             }
             // move up
-            currTaxId = currParentTaxId;
-            node = taxonNode(currParentTaxId, false);
-            currParentTaxId = node->parentTaxId;
+            childId = currId;
+            currId = parentId;
         }
     }
 
-    TaxID selctedTaxon = 0;
-    if (totalAssignedSeqsWeights == 0) {
-        return WeightedTaxResult(selctedTaxon, assignedSeqs, unassignedSeqs, 0, 0.0);
+    // sum up the clade weights bottom-up by the level of the nodes in the Euler tour
+    std::vector<int> &order = buffer.order;
+    order.resize(nodes.size());
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&nodes](int a, int b) { return nodes[a].level > nodes[b].level; });
+    for (size_t i = 0; i < order.size(); ++i) {
+        const WeightedLCABuffer::Node &current = nodes[order[i]];
+        int parentId = lineage[current.id].parentId;
+        if (parentId != current.id) {
+            nodes[slots[parentId]].weight += current.weight;
+        }
     }
 
-    // select the lowest ancestor that meets the cutoff
+    TaxID selctedTaxon = 0;
+    int selectedId = -1;
     int minRank = INT_MAX;
     double selectedPercent = 0;
-    for (std::map<TaxID, TaxNode>::iterator it = ancTaxIdsCounts.begin(); it != ancTaxIdsCounts.end(); it++) {
-        // consider only candidates
-        if (it->second.isCandidate == false) {
-            continue;
-        }
+    if (totalAssignedSeqsWeights != 0) {
+        // select the lowest ancestor that meets the cutoff
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            // consider only candidates
+            if (nodes[i].isCandidate == false) {
+                continue;
+            }
 
-        double currPercent = it->second.weight / totalAssignedSeqsWeights;
-        if (currPercent >= majorityCutoff) {
-            // iterate all ancestors to find lineage min rank (the candidate is a descendant of a node with this rank)
-            TaxID currTaxId = it->first;
-            TaxonNode const *node = taxonNode(currTaxId, false);
+            double currPercent = nodes[i].weight / totalAssignedSeqsWeights;
+            if (currPercent < majorityCutoff) {
+                continue;
+            }
+            // lineage min rank (the candidate is a descendant of a node with this rank), the root is not considered
+            int id = nodes[i].id;
+            int rankedId = (lineage[id].rankIndex > 0) ? id : lineage[id].rankedParentId;
             int currMinRank = ROOT_RANK;
-            TaxID currParentTaxId = node->parentTaxId;
-            while (currParentTaxId != currTaxId) {
-                int currRankInd = NcbiTaxonomy::findRankIndex(getString(node->rankIdx));
-                if ((currRankInd > 0) && (currRankInd < currMinRank)) {
-                    currMinRank = currRankInd;
-                    // the rank can only go up on the way to the root, so we can break
-                    break;
-                }
-                // move up:
-                currTaxId = currParentTaxId;
-                node = taxonNode(currParentTaxId, false);
-                currParentTaxId = node->parentTaxId;
+            if (rankedId != -1 && lineage[rankedId].parentId != rankedId) {
+                currMinRank = lineage[rankedId].rankIndex;
             }
 
-            if ((currMinRank < minRank) || ((currMinRank == minRank) && (currPercent > selectedPercent))) {
-                selctedTaxon = it->first;
+            // ties are resolved towards the lower TaxID
+            TaxID currTaxId = nodes[i].taxon;
+            if ((currMinRank < minRank)
+                || ((currMinRank == minRank) && (currPercent > selectedPercent))
+                || ((currMinRank == minRank) && (currPercent == selectedPercent) && selectedId != -1 && currTaxId < selctedTaxon)) {
+                selctedTaxon = currTaxId;
+                selectedId = id;
                 minRank = currMinRank;
                 selectedPercent = currPercent;
             }
         }
     }
 
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        slots[nodes[i].id] = -1;
+    }
+    nodes.clear();
+
+    if (totalAssignedSeqsWeights == 0) {
+        return WeightedTaxResult(selctedTaxon, assignedSeqs, unassignedSeqs, 0, 0.0);
+    }
+
     // count the number of seqs who have selectedTaxon in their ancestors (agree with selection):
     if (selctedTaxon == ROOT_TAXID) {
         // all agree with "root"
@@ -749,17 +874,13 @@ WeightedTaxResult NcbiTaxonomy::weightedMajorityLCA(const std::vector<WeightedTa
         if (node == NULL) {
             continue;
         }
-
-        // iterate all ancestors up to the root
-        TaxID currParentTaxId = node->parentTaxId;
-        while (currParentTaxId != currTaxId) {
-            if (currTaxId == selctedTaxon) {
-                seqsAgreeWithSelectedTaxon++;
-                break;
-            }
-            currTaxId = currParentTaxId;
-            node = taxonNode(currParentTaxId, false);
-            currParentTaxId = node->parentTaxId;
+        // the root itself never agrees
+        if (lineage[node->id].parentId == node->id) {
+            continue;
+        }
+        // selected taxon is an ancestor if it is the lowest common ancestor in the Euler tour
+        if (lcaHelper(node->id, selectedId) == selectedId) {
+            seqsAgreeWithSelectedTaxon++;
         }
     }
 
@@ -768,40 +889,41 @@ WeightedTaxResult NcbiTaxonomy::weightedMajorityLCA(const std::vector<WeightedTa
 
 std::pair<char*, size_t> NcbiTaxonomy::serialize(const NcbiTaxonomy& t) {
     t.block->compact();
-    size_t matrixDim = (t.maxNodes * 2);
-    size_t matrixK = (int)(MathUtil::flog2(matrixDim)) + 1;
-    size_t matrixSize = matrixDim * matrixK * sizeof(int);
+    size_t matrixSize = (t.maxNodes * 2) * t.matrixK * sizeof(int);
     size_t blockSize = StringBlock<unsigned int>::memorySize(*t.block);
     size_t memSize = sizeof(int) // SERIALIZATION_VERSION
-        + sizeof(size_t) // maxNodes
         + sizeof(int) // maxTaxID
-        + t.maxNodes * sizeof(TaxonNode) // taxonNodes
-        + (t.maxTaxID + 1) * sizeof(int) // D
-        + 2 * (t.maxNodes * 2) * sizeof(int) // E,L
-        + t.maxNodes * sizeof(int) // H
-        + matrixSize // M
+        + sizeof(size_t) // maxNodes
+        + alignedSize(t.maxNodes * sizeof(TaxonNode)) // taxonNodes
+        + alignedSize((t.maxTaxID + 1) * sizeof(int)) // D
+        + 2 * alignedSize((t.maxNodes * 2) * sizeof(int)) // E,L
+        + alignedSize(t.maxNodes * sizeof(int)) // H
+        + alignedSize(t.maxNodes * sizeof(TaxonLineage)) // lineage
+        + alignedSize(matrixSize) // M
         + blockSize; // block
 
-    char* mem = (char*) malloc(memSize);
+    char* mem = (char*) calloc(memSize, sizeof(char));
     char* p = mem;
     memcpy(p, &t.SERIALIZATION_VERSION, sizeof(int));
     p += sizeof(int);
-    memcpy(p, &t.maxNodes, sizeof(size_t));
-    p += sizeof(size_t);
     memcpy(p, &t.maxTaxID, sizeof(int));
     p += sizeof(int);
+    memcpy(p, &t.maxNodes, sizeof(size_t));
+    p += sizeof(size_t);
     memcpy(p, t.taxonNodes, t.maxNodes * sizeof(TaxonNode));
-    p += t.maxNodes * sizeof(TaxonNode);
+    p += alignedSize(t.maxNodes * sizeof(TaxonNode));
     memcpy(p, t.D, (t.maxTaxID + 1) * sizeof(int));
-    p += (t.maxTaxID + 1) * sizeof(int);
+    p += alignedSize((t.maxTaxID + 1) * sizeof(int));
     memcpy(p, t.E, (t.maxNodes * 2) * sizeof(int));
-    p += (t.maxNodes * 2) * sizeof(int);
+    p += alignedSize((t.maxNodes * 2) * sizeof(int));
     memcpy(p, t.L, (t.maxNodes * 2) * sizeof(int));
-    p += (t.maxNodes * 2) * sizeof(int);
+    p += alignedSize((t.maxNodes * 2) * sizeof(int));
     memcpy(p, t.H, t.maxNodes * sizeof(int));
-    p += t.maxNodes * sizeof(int);
-    memcpy(p, t.M[0], matrixSize);
-    p += matrixSize;
+    p += alignedSize(t.maxNodes * sizeof(int));
+    memcpy(p, t.lineage, t.maxNodes * sizeof(TaxonLineage));
+    p += alignedSize(t.maxNodes * sizeof(TaxonLineage));
+    memcpy(p, t.M, matrixSize);
+    p += alignedSize(matrixSize);
     char* blockData = StringBlock<unsigned int>::serialize(*t.block);
     memcpy(p, blockData, blockSize);
     p += blockSize;
@@ -813,9 +935,37 @@ NcbiTaxonomy* NcbiTaxonomy::unserialize(char* mem) {
     const char* p = mem;
     int version = *((int*)p);
     p += sizeof(int);
+    if (version == 2 || version == 3) {
+        return unserializePacked(p, version);
+    }
     if (version != NcbiTaxonomy::SERIALIZATION_VERSION) {
         return NULL;
     }
+    int maxTaxID = *((int*)p);
+    p += sizeof(int);
+    size_t maxNodes = *((size_t*)p);
+    p += sizeof(size_t);
+    TaxonNode* taxonNodes = (TaxonNode*)p;
+    p += alignedSize(maxNodes * sizeof(TaxonNode));
+    int* D = (int*)p;
+    p += alignedSize((maxTaxID + 1) * sizeof(int));
+    int* E = (int*)p;
+    p += alignedSize((maxNodes * 2) * sizeof(int));
+    int* L = (int*)p;
+    p += alignedSize((maxNodes * 2) * sizeof(int));
+    int* H = (int*)p;
+    p += alignedSize(maxNodes * sizeof(int));
+    TaxonLineage* lineage = (TaxonLineage*)p;
+    p += alignedSize(maxNodes * sizeof(TaxonLineage));
+    int* M = (int*)p;
+    p += alignedSize((maxNodes * 2) * sparseTableColumns(maxNodes) * sizeof(int));
+    StringBlock<unsigned int>* block = StringBlock<unsigned int>::unserialize(p);
+    return new NcbiTaxonomy(taxonNodes, maxNodes, maxTaxID, D, E, L, H, M, lineage, block);
+}
+
+// versions 2 and 3 store the sections without padding, version 2 has no lineage table
+// the sparse table was already stored row by row, so it is used in place as well
+NcbiTaxonomy* NcbiTaxonomy::unserializePacked(const char* p, int version) {
     size_t maxNodes = *((size_t*)p);
     p += sizeof(size_t);
     int maxTaxID = *((int*)p);
@@ -830,15 +980,13 @@ NcbiTaxonomy* NcbiTaxonomy::unserialize(char* mem) {
     p += (maxNodes * 2) * sizeof(int);
     int* H = (int*)p;
     p += maxNodes * sizeof(int);
-    size_t matrixDim = (maxNodes * 2);
-    size_t matrixK = (int)(MathUtil::flog2(matrixDim)) + 1;
-    size_t matrixSize = matrixDim * matrixK * sizeof(int);
-    int** M = new int*[matrixDim];
-    M[0] = (int*)p;
-    for(size_t i = 1; i < matrixDim; i++) {
-        M[i] = M[i-1] + matrixK;
-    }
-    p += matrixSize;
+    TaxonLineage* lineage = NULL;
+    if (version == 3) {
+        lineage = (TaxonLineage*)p;
+        p += maxNodes * sizeof(TaxonLineage);
+    }
+    int* M = (int*)p;
+    p += (maxNodes * 2) * sparseTableColumns(maxNodes) * sizeof(int);
     StringBlock<unsigned int>* block = StringBlock<unsigned int>::unserialize(p);
-    return new NcbiTaxonomy(taxonNodes, maxNodes, maxTaxID, D, E, L, H, M, block);
+    return new NcbiTaxonomy(taxonNodes, maxNodes, maxTaxID, D, E, L, H, M, lineage, block);
 }
@@ -24,6 +24,14 @@ public:
             : id(id), taxId(taxId), parentTaxId(parentTaxId), rankIdx(rankIdx), nameIdx(nameIdx) {};
 };
 
+// precomputed per node to render ranks and lineages without walking TaxIDs or looking up rank names
+struct TaxonLineage {
+    int parentId;       // node id of the parent
+    int rankedParentId; // node id of the closest ancestor with a rank from NcbiRanks, -1 if there is none
+    int rankIndex;      // index in NcbiRanks, -1 for other ranks
+    char shortRank;     // see NcbiShortRanks, '-' for other ranks
+};
+
 const double MAX_TAX_WEIGHT = 1000;
 struct WeightedTaxHit {
     WeightedTaxHit(const TaxID taxon, const float evalue, const int weightVoteMode);
@@ -43,10 +51,32 @@ struct WeightedTaxResult {
     double selectedPercent;
 };
 
-struct TaxonCounts {
-    unsigned int taxCount;       // number of reads/sequences matching to taxa
-    unsigned int cladeCount;     // number of reads/sequences matching to taxa or its children
-    std::vector<TaxID> children; // list of children
+// per thread scratch space of weightedMajorityLCA
+// slots is indexed by node id and points into nodes, only the touched slots are reset after each call
+struct WeightedLCABuffer {
+    struct Node {
+        TaxID taxon; // as given in the hits for the start of a path, might be a merged TaxID
+        int id;
+        int childId;
+        int level;
+        bool isCandidate;
+        double weight;
+    };
+
+    explicit WeightedLCABuffer(size_t maxNodes) : slots(maxNodes, -1) {};
+
+    std::vector<int> slots;
+    std::vector<Node> nodes;
+    std::vector<int> order;
+};
+
+// tree structure indexed by node id (TaxonNode::id), the children of node i are children[offsets[i]..offsets[i + 1]]
+// children are in the same order as in taxonNodes, preorder lists every parent before its children
+struct TaxonTree {
+    std::vector<int> parent;
+    std::vector<size_t> offsets;
+    std::vector<int> children;
+    std::vector<int> preorder;
 };
 
 static const std::map<std::string, int> NcbiRanks = {{ "forma", 1 },
@@ -99,18 +129,25 @@ public:
     std::map<std::string, std::string> AllRanks(TaxonNode const *node) const;
     std::string taxLineage(TaxonNode const *node, bool infoAsName = true);
 
+    // same output as Util::implode(AtRanks(node, levels), ';') and taxLineage, appended without temporary strings
+    void appendAtRanks(std::string &out, TaxonNode const *node, const std::vector<int> &levelIndices) const;
+    void appendTaxLineage(std::string &out, TaxonNode const *node, bool infoAsName = true) const;
+
     static std::vector<std::string> parseRanks(const std::string& ranks);
+    static std::vector<int> findRankIndices(const std::vector<std::string>& ranks);
     static int findRankIndex(const std::string& rank);
     static char findShortRank(const std::string& rank);
 
     bool IsAncestor(TaxID ancestor, TaxID child);
+    // comma separated TaxIDs, optionally followed by ':name' that has to match the name of the taxon
+    std::vector<TaxID> parseBlacklist(const std::string &blacklist) const;
+    bool isBlacklisted(const std::vector<TaxID> &blacklist, TaxID taxon);
     TaxonNode const* taxonNode(TaxID taxonId, bool fail = true) const;
     bool nodeExists(TaxID taxId) const;
 
-    std::unordered_map<TaxID, std::vector<TaxID>> getParentToChildren() const;
-    std::unordered_map<TaxID, TaxonCounts> getCladeCounts(const std::unordered_map<TaxID, unsigned int>& taxonCounts, const std::unordered_map<TaxID, std::vector<TaxID>>& parentToChildren) const;
+    TaxonTree getTaxonTree() const;
 
-    WeightedTaxResult weightedMajorityLCA(const std::vector<WeightedTaxHit> &setTaxa, const float majorityCutoff);
+    WeightedTaxResult weightedMajorityLCA(const std::vector<WeightedTaxHit> &setTaxa, const float majorityCutoff, WeightedLCABuffer &buffer) const;
 
     const char* getString(size_t blockIdx) const;
 
@@ -126,25 +163,41 @@ private:
     void loadNames(std::vector<TaxonNode> &tmpNodes, const std::string &namesFile);
     void elh(std::vector<std::vector<TaxID>> const & children, int node, int level, std::vector<int> &tmpE, std::vector<int> &tmpL);
     void computeSparseTable();
+    void computeLineage();
+    void nodesAtRanks(int id, int *atRank) const;
+    void appendLineage(std::string &out, int id, bool infoAsName) const;
     int nodeId(TaxID taxId) const;
 
     int RangeMinimumQuery(int i, int j) const;
     int lcaHelper(int i, int j) const;
 
-    NcbiTaxonomy(TaxonNode* taxonNodes, size_t maxNodes, int maxTaxID, int *D, int *E, int *L, int *H, int **M, StringBlock<unsigned int> *block)
-        : taxonNodes(taxonNodes), maxNodes(maxNodes), maxTaxID(maxTaxID), D(D), E(E), L(L), H(H), M(M), block(block), externalData(true), mmapData(NULL), mmapSize(0) {};
+    NcbiTaxonomy(TaxonNode* taxonNodes, size_t maxNodes, int maxTaxID, int *D, int *E, int *L, int *H, int *M, TaxonLineage *lineage, StringBlock<unsigned int> *block)
+        : taxonNodes(taxonNodes), maxNodes(maxNodes), maxTaxID(maxTaxID), D(D), E(E), L(L), H(H), M(M), matrixK(sparseTableColumns(maxNodes)), lineage(lineage), block(block), externalData(true), externalLineage(lineage != NULL), mmapData(NULL), mmapSize(0) {
+        // binary taxonomies before version 3 have no lineage table
+        if (lineage == NULL) {
+            this->lineage = new TaxonLineage[maxNodes];
+            computeLineage();
+        }
+    };
+    static NcbiTaxonomy* unserializePacked(const char* data, int version);
+    static size_t sparseTableColumns(size_t maxNodes);
     int *D; // maps from taxID to node ID in taxonNodes
     int *E; // for Euler tour sequence (size 2N-1)
     int *L; // Level of nodes in tour sequence (size 2N-1)
     int *H;
-    int **M;
+    int *M; // sparse table with 2N rows of matrixK columns, stored row by row so it can be used directly from the mmaped file
+    size_t matrixK;
+    TaxonLineage *lineage;
     StringBlock<unsigned int>* block;
 
     bool externalData;
+    bool externalLineage;
     char* mmapData;
     size_t mmapSize;
 
     static const int SERIALIZATION_VERSION;
+    // NcbiRanks indices are 1 to 28
+    static const int RANK_SLOTS = 29;
 };
 
 #endif
@@ -17,6 +17,7 @@ int addtaxonomy(int argc, const char **argv, const Command &command) {
     NcbiTaxonomy *t = NcbiTaxonomy::openTaxonomy(par.db1);
     MappingReader mapping(par.db1);
     std::vector<std::string> ranks = NcbiTaxonomy::parseRanks(par.lcaRanks);
+    std::vector<int> rankIndices = NcbiTaxonomy::findRankIndices(ranks);
 
     DBReader<unsigned int> reader(par.db2.c_str(), par.db2Index.c_str(), par.threads, DBReader<unsigned int>::USE_DATA | DBReader<unsigned int>::USE_INDEX);
     reader.open(DBReader<unsigned int>::LINEAR_ACCCESS);
@@ -94,15 +95,15 @@ int addtaxonomy(int argc, const char **argv, const Command &command) {
                 result.append(t->getString(node->nameIdx));
                 if (!ranks.empty()) {
                     result.append(1, '\t');
-                    result.append(Util::implode(t->AtRanks(node, ranks), ';'));
+                    t->appendAtRanks(result, node, rankIndices);
                 }
                 if (par.showTaxLineage == 1) {
                     result.append(1, '\t');
-                    result.append(t->taxLineage(node, true));
+                    t->appendTaxLineage(result, node, true);
                 }
                 if (par.showTaxLineage == 2) {
                     result.append(1, '\t');
-                    result.append(t->taxLineage(node, false));
+                    t->appendTaxLineage(result, node, false);
                 }
                 result.append(1, '\n');
                 data = Util::skipLine(data);
@@ -46,6 +46,7 @@ int aggregate(const bool useAln, int argc, const char **argv, const Command& com
     writer.open();
 
     std::vector<std::string> ranks = NcbiTaxonomy::parseRanks(par.lcaRanks);
+    std::vector<int> rankIndices = NcbiTaxonomy::findRankIndices(ranks);
 
     Debug::Progress progress(setToSeqReader.getSize());
 
@@ -58,6 +59,7 @@ int aggregate(const bool useAln, int argc, const char **argv, const Command& com
         // per thread variables
         const char *entry[255];
         std::vector<WeightedTaxHit> setTaxa;
+        WeightedLCABuffer lcaBuffer(t->maxNodes);
 
         std::string setTaxStr;
         setTaxStr.reserve(4096);
@@ -115,7 +117,7 @@ int aggregate(const bool useAln, int argc, const char **argv, const Command& com
             }
 
             // aggregate - the counters will be filled by the selection function:
-            WeightedTaxResult result = t->weightedMajorityLCA(setTaxa, par.majorityThr);
+            WeightedTaxResult result = t->weightedMajorityLCA(setTaxa, par.majorityThr, lcaBuffer);
             TaxonNode const * node = t->taxonNode(result.taxon, false);
 
             size_t totalNumSeqs = result.assignedSeqs + result.unassignedSeqs;
@@ -157,15 +159,15 @@ int aggregate(const bool useAln, int argc, const char **argv, const Command& com
                 setTaxStr.append(SSTR(roundf(result.selectedPercent * 100) / 100));
                 if (!ranks.empty()) {
                     setTaxStr.append(1, '\t');
-                    setTaxStr.append(Util::implode(t->AtRanks(node, ranks), ';'));
+                    t->appendAtRanks(setTaxStr, node, rankIndices);
                 }
                 if (par.showTaxLineage == 1) {
                     setTaxStr.append(1, '\t');
-                    setTaxStr.append(t->taxLineage(node, true));
+                    t->appendTaxLineage(setTaxStr, node, true);
                 }
                 if (par.showTaxLineage == 2) {
                     setTaxStr.append(1, '\t');
-                    setTaxStr.append(t->taxLineage(node, false));
+                    t->appendTaxLineage(setTaxStr, node, false);
                 }
             }
             setTaxStr.append(1, '\n');
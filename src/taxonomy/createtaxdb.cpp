@@ -40,6 +40,7 @@ int createtaxdb(int argc, const char **argv, const Command& command) {
     }
     cmd.addVariable("ARIA_NUM_CONN", SSTR(std::min(16, par.threads)).c_str());
     cmd.addVariable("VERBOSITY_PAR", par.createParameterString(par.onlyverbosity).c_str());
+    cmd.addVariable("THREADS_PAR", par.createParameterString(par.onlythreads).c_str());
     FileUtil::writeFile(tmp + "/createindex.sh", createtaxdb_sh, createtaxdb_sh_len);
     std::string program(tmp + "/createindex.sh");
     cmd.execProgram(program.c_str(), par.filenames);
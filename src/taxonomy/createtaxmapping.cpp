@@ -0,0 +1,76 @@
+#include "Debug.h"
+#include "Parameters.h"
+#include "DBReader.h"
+#include "FileUtil.h"
+#include "Util.h"
+#include "MappingReader.h"
+#include "AccessionTaxonMapping.h"
+
+int createtaxmapping(int argc, const char **argv, const Command &command) {
+    Parameters &par = Parameters::getInstance();
+    par.parseParameters(argc, argv, command, true, 0, 0);
+
+    std::string mappingFile = par.filenames.back();
+    par.filenames.pop_back();
+    std::string seqDb = par.filenames.back();
+    std::string seqDbIndex = seqDb + ".index";
+    par.filenames.pop_back();
+
+    DBReader<unsigned int> reader(seqDb.c_str(), seqDbIndex.c_str(), par.threads, DBReader<unsigned int>::USE_INDEX | DBReader<unsigned int>::USE_LOOKUP);
+    reader.open(DBReader<unsigned int>::NOSORT);
+    DBReader<unsigned int>::LookupEntry *lookup = reader.getLookup();
+    const size_t lookupSize = reader.getLookupSize();
+
+    // mode 0 resolves the accession of each entry, mode 1 the name of the file it came from
+    const bool useSource = par.taxMappingMode == 1;
+    std::map<unsigned int, std::string> source;
+    if (useSource) {
+        // read the .source file directly since the DBReader strips the extension of the file names
+        source = Util::readLookup(seqDb + ".source", false);
+    }
+    AccessionTaxonMapping accessions(useSource ? source.size() : lookupSize);
+    std::vector<unsigned int> entryIds(lookupSize);
+    for (size_t i = 0; i < lookupSize; ++i) {
+        if (useSource) {
+            std::map<unsigned int, std::string>::const_iterator it = source.find(lookup[i].fileNumber);
+            if (it == source.end()) {
+                Debug(Debug::ERROR) << "File number " << lookup[i].fileNumber << " of entry " << lookup[i].entryName << " is missing in " << seqDb << ".source\n";
+                EXIT(EXIT_FAILURE);
+            }
+            entryIds[i] = accessions.insert(it->second.c_str(), it->second.length());
+        } else {
+            entryIds[i] = accessions.insert(lookup[i].entryName.c_str(), lookup[i].entryName.length());
+        }
+    }
+    accessions.readMappingFiles(par.filenames, par.threads);
+
+    // the lookup is sorted by key
+    std::vector<std::pair<unsigned int, unsigned int>> mapping;
+    mapping.reserve(lookupSize);
+    for (size_t i = 0; i < lookupSize; ++i) {
+        TaxID taxon = accessions.getTaxon(entryIds[i]);
+        if (taxon != 0) {
+            mapping.emplace_back(lookup[i].id, taxon);
+        }
+    }
+    reader.close();
+    Debug(Debug::INFO) << "Mapped " << mapping.size() << " of " << lookupSize << " sequences\n";
+
+    std::pair<char*, size_t> serialized = MappingReader::serialize(mapping);
+    FILE* handle = fopen(mappingFile.c_str(), "w");
+    if (handle == NULL) {
+        Debug(Debug::ERROR) << "Could not open " << mappingFile << " for writing\n";
+        return EXIT_FAILURE;
+    }
+    size_t written = fwrite(serialized.first, serialized.second * sizeof(char), 1, handle);
+    free(serialized.first);
+    if (written != 1) {
+        Debug(Debug::ERROR) << "Could not write to " << mappingFile << "\n";
+        return EXIT_FAILURE;
+    }
+    if (fclose(handle) != 0) {
+        Debug(Debug::ERROR) << "Cannot close " << mappingFile << "\n";
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -34,38 +34,11 @@ int dolca(int argc, const char **argv, const Command& command, bool majority) {
     writer.open();
 
     std::vector<std::string> ranks = NcbiTaxonomy::parseRanks(par.lcaRanks);
+    std::vector<int> rankIndices = NcbiTaxonomy::findRankIndices(ranks);
 
     // a few NCBI taxa are blacklisted by default, they contain unclassified sequences (e.g. metagenomes) or other sequences (e.g. plasmids)
     // if we do not remove those, a lot of sequences would be classified as Root, even though they have a sensible LCA
-    std::vector<TaxID> blacklist;
-    std::vector<std::string> splits = Util::split(par.blacklist, ",");
-    for (size_t i = 0; i < splits.size(); ++i) {
-        TaxID taxon = Util::fast_atoi<int>(splits[i].c_str());
-        if (taxon == 0) {
-            Debug(Debug::WARNING) << "Cannot block root taxon 0\n";
-            continue;
-        }
-        if (t->nodeExists(taxon) == false) {
-            Debug(Debug::WARNING) << "Ignoring missing blocked taxon " << taxon << "\n";
-            continue;
-        }
-
-        const char *split;
-        if ((split = strchr(splits[i].c_str(), ':')) != NULL) {
-            const char* name = split + 1;
-            const TaxonNode* node = t->taxonNode(taxon, false);
-            if (node == NULL) {
-                Debug(Debug::WARNING) << "Ignoring missing blocked taxon " << taxon << "\n";
-                continue;
-            }
-            const char* nodeName = t->getString(node->nameIdx);
-            if (strcmp(nodeName, name) != 0) {
-                Debug(Debug::WARNING) << "Node name '" << name << "' does not match to be blocked name '" << nodeName << "'\n";
-                continue;
-            }
-        }
-        blacklist.emplace_back(taxon);
-    }
+    std::vector<TaxID> blacklist = t->parseBlacklist(par.blacklist);
 
     // will be used when no hits
     std::string noTaxResult = "0\tno rank\tunclassified";
@@ -86,6 +59,7 @@ int dolca(int argc, const char **argv, const Command& command, bool majority) {
         const char *entry[255];
         std::string result;
         result.reserve(4096);
+        WeightedLCABuffer lcaBuffer(majority ? t->maxNodes : 0);
         unsigned int thread_idx = 0;
 
 #ifdef OPENMP
@@ -120,18 +94,7 @@ int dolca(int argc, const char **argv, const Command& command, bool majority) {
                 found++;
 
                 // remove blacklisted taxa
-                bool isBlacklisted = false;
-                for (size_t j = 0; j < blacklist.size(); ++j) {
-                    if (blacklist[j] == 0) {
-                        continue;
-                    }
-                    if (t->IsAncestor(blacklist[j], taxon)) {
-                        isBlacklisted = true;
-                        break;
-                    }
-                }
-
-                if (isBlacklisted == false) {
+                if (t->isBlacklisted(blacklist, taxon) == false) {
                     if (majority) {
                         float weight = FLT_MAX;
                         if (par.voteMode == Parameters::AGG_TAX_MINUS_LOG_EVAL) {
@@ -161,7 +124,7 @@ int dolca(int argc, const char **argv, const Command& command, bool majority) {
 
             TaxonNode const * node = NULL;
             if (majority) {
-                WeightedTaxResult result = t->weightedMajorityLCA(weightedTaxa, par.majorityThr);
+                WeightedTaxResult result = t->weightedMajorityLCA(weightedTaxa, par.majorityThr, lcaBuffer);
                 node = t->taxonNode(result.taxon, false);
             } else {
                 node = t->LCA(taxa);
@@ -178,15 +141,15 @@ int dolca(int argc, const char **argv, const Command& command, bool majority) {
             result.append(t->getString(node->nameIdx));
             if (!ranks.empty()) {
                 result.append(1, '\t');
-                result.append(Util::implode(t->AtRanks(node, ranks), ';'));
+                t->appendAtRanks(result, node, rankIndices);
             }
             if (par.showTaxLineage == 1) {
                 result.append(1, '\t');
-                result.append(t->taxLineage(node, true));
+                t->appendTaxLineage(result, node, true);
             }
             if (par.showTaxLineage == 2) {
                 result.append(1, '\t');
-                result.append(t->taxLineage(node, false));
+                t->appendTaxLineage(result, node, false);
             }
             result.append(1, '\n');
             writer.writeData(result.c_str(), result.size(), key, thread_idx);
@@ -7,70 +7,73 @@
 #include "FastSort.h"
 #include "MappingReader.h"
 
-#include <unordered_map>
-
 #include "krona_prelude.html.h"
 
 #ifdef OPENMP
 #include <omp.h>
 #endif
 
-unsigned int cladeCountVal(const std::unordered_map<TaxID, TaxonCounts> &map, TaxID key) {
-    std::unordered_map<TaxID, TaxonCounts>::const_iterator it = map.find(key);
-    if (it == map.end()) {
-        return 0;
-    } else {
-        return it->second.cladeCount;
-    }
+// dense counters indexed by node id, reads without a taxon are counted separately
+struct CladeCounts {
+    const unsigned int *taxCounts;
+    const unsigned int *cladeCounts;
+    unsigned int unclassified;
+};
+
+// children with the largest clade first, children that were not seen are at the end
+std::vector<int> sortedChildren(const TaxonTree &tree, const CladeCounts &counts, int id) {
+    std::vector<int> children(tree.children.begin() + tree.offsets[id], tree.children.begin() + tree.offsets[id + 1]);
+    SORT_SERIAL(children.begin(), children.end(), [&](int a, int b) { return counts.cladeCounts[a] > counts.cladeCounts[b]; });
+    return children;
 }
 
 void taxReport(
     DBWriter& writer,
     unsigned int thread_idx,
     const NcbiTaxonomy &taxDB,
-    const std::unordered_map<TaxID, TaxonCounts> &cladeCounts,
+    const TaxonTree &tree,
+    const CladeCounts &counts,
     unsigned long totalReads,
-    TaxID taxID = 0,
+    int id,
     int depth = 0
 ) {
-    std::unordered_map<TaxID, TaxonCounts>::const_iterator it = cladeCounts.find(taxID);
-    unsigned int cladeCount = it == cladeCounts.end() ? 0 : it->second.cladeCount;
-    unsigned int taxCount = it == cladeCounts.end() ? 0 : it->second.taxCount;
+    unsigned int cladeCount = counts.cladeCounts[id];
+    if (cladeCount == 0) {
+        return;
+    }
+    const TaxonNode *taxon = &taxDB.taxonNodes[id];
     char buffer[4096];
-    int len = 0;
-    if (taxID == 0) {
-        if (cladeCount > 0) {
-            len = snprintf(buffer, sizeof(buffer), "%.4f\t%i\t%i\tno rank\t0\tunclassified\n",
-                           100 * cladeCount / double(totalReads),
-                           cladeCount, taxCount);
-            writer.writeAdd(buffer, static_cast<size_t>(len), thread_idx);
-        }
-        taxReport(writer, thread_idx, taxDB, cladeCounts, totalReads, 1);
-    } else {
-        if (cladeCount == 0) {
-            return;
-        }
-        const TaxonNode *taxon = taxDB.taxonNode(taxID);
-        std::string indent = std::string(2 * depth, ' ');
-        len = snprintf(buffer, sizeof(buffer), "%.4f\t%i\t%i\t%s\t%i\t%s%s\n",
+    std::string indent = std::string(2 * depth, ' ');
+    int len = snprintf(buffer, sizeof(buffer), "%.4f\t%i\t%i\t%s\t%i\t%s%s\n",
                        100 * cladeCount / double(totalReads),
-                       cladeCount, taxCount,
+                       cladeCount, counts.taxCounts[id],
                        taxDB.getString(taxon->rankIdx),
-                       taxID,
+                       taxon->taxId,
                        indent.c_str(),
                        taxDB.getString(taxon->nameIdx));
+    writer.writeAdd(buffer, static_cast<size_t>(len), thread_idx);
+    std::vector<int> children = sortedChildren(tree, counts, id);
+    for (size_t i = 0; i < children.size() && counts.cladeCounts[children[i]] > 0; ++i) {
+        taxReport(writer, thread_idx, taxDB, tree, counts, totalReads, children[i], depth + 1);
+    }
+}
+
+void taxReport(
+    DBWriter& writer,
+    unsigned int thread_idx,
+    const NcbiTaxonomy &taxDB,
+    const TaxonTree &tree,
+    const CladeCounts &counts,
+    unsigned long totalReads
+) {
+    if (counts.unclassified > 0) {
+        char buffer[1024];
+        int len = snprintf(buffer, sizeof(buffer), "%.4f\t%i\t%i\tno rank\t0\tunclassified\n",
+                           100 * counts.unclassified / double(totalReads),
+                           counts.unclassified, counts.unclassified);
         writer.writeAdd(buffer, static_cast<size_t>(len), thread_idx);
-        std::vector<TaxID> children = it->second.children;
-        SORT_SERIAL(children.begin(), children.end(), [&](int a, int b) { return cladeCountVal(cladeCounts, a) > cladeCountVal(cladeCounts, b); });
-        for (size_t i = 0; i < children.size(); ++i) {
-            TaxID childTaxId = children[i];
-            if (cladeCounts.count(childTaxId)) {
-                taxReport(writer, thread_idx, taxDB, cladeCounts, totalReads, childTaxId, depth + 1);
-            } else {
-                break;
-            }
-        }
     }
+    taxReport(writer, thread_idx, taxDB, tree, counts, totalReads, tree.preorder[0]);
 }
 
 std::string escapeAttribute(const std::string &data) {
@@ -105,53 +108,39 @@ void kronaReport(
     DBWriter& writer,
     unsigned int thread_idx,
     const NcbiTaxonomy &taxDB,
-    const std::unordered_map<TaxID, TaxonCounts> &cladeCounts,
-    unsigned long totalReads,
-    TaxID taxID = 0,
-    int depth = 0
+    const TaxonTree &tree,
+    const CladeCounts &counts,
+    int id
 ) {
-    std::unordered_map<TaxID, TaxonCounts>::const_iterator it = cladeCounts.find(taxID);
-    unsigned int cladeCount = it == cladeCounts.end() ? 0 : it->second.cladeCount;
+    unsigned int cladeCount = counts.cladeCounts[id];
+    if (cladeCount == 0) {
+        return;
+    }
     char buffer[1024];
-    int len = 0;
-    if (taxID == 0) {
-        if (cladeCount > 0) {
-            len = snprintf(buffer, sizeof(buffer), "<node name=\"unclassified\"><magnitude><val>%d</val></magnitude></node>", cladeCount);
-            writer.writeAdd(buffer, static_cast<size_t>(len), thread_idx);
-        }
-        kronaReport(writer, thread_idx, taxDB, cladeCounts, totalReads, 1);
-    } else {
-        if (cladeCount == 0) {
-            return;
-        }
-        const TaxonNode *taxon = taxDB.taxonNode(taxID);
-        std::string escapedName = escapeAttribute(taxDB.getString(taxon->nameIdx));
-        len = snprintf(buffer, sizeof(buffer), "<node name=\"%s\"><magnitude><val>%d</val></magnitude>", escapedName.c_str(), cladeCount);
-        writer.writeAdd(buffer, static_cast<size_t>(len), thread_idx);
-        std::vector<TaxID> children = it->second.children;
-        SORT_SERIAL(children.begin(), children.end(), [&](int a, int b) { return cladeCountVal(cladeCounts, a) > cladeCountVal(cladeCounts, b); });
-        for (size_t i = 0; i < children.size(); ++i) {
-            TaxID childTaxId = children[i];
-            if (cladeCounts.count(childTaxId)) {
-                kronaReport(writer, thread_idx, taxDB, cladeCounts, totalReads, childTaxId, depth + 1);
-            } else {
-                break;
-            }
-        }
-        len = snprintf(buffer, sizeof(buffer), "</node>");
-        writer.writeAdd(buffer, static_cast<size_t>(len), thread_idx);
+    std::string escapedName = escapeAttribute(taxDB.getString(taxDB.taxonNodes[id].nameIdx));
+    int len = snprintf(buffer, sizeof(buffer), "<node name=\"%s\"><magnitude><val>%d</val></magnitude>", escapedName.c_str(), cladeCount);
+    writer.writeAdd(buffer, static_cast<size_t>(len), thread_idx);
+    std::vector<int> children = sortedChildren(tree, counts, id);
+    for (size_t i = 0; i < children.size() && counts.cladeCounts[children[i]] > 0; ++i) {
+        kronaReport(writer, thread_idx, taxDB, tree, counts, children[i]);
     }
+    len = snprintf(buffer, sizeof(buffer), "</node>");
+    writer.writeAdd(buffer, static_cast<size_t>(len), thread_idx);
 }
 
-void mergeMaps(std::unordered_map<TaxID, unsigned int>& target, const std::unordered_map<TaxID, unsigned int>& source) {
-    for (std::unordered_map<TaxID, unsigned int>::const_iterator it = source.cbegin(); it != source.cend(); ++it) {
-        std::unordered_map<TaxID, unsigned int>::iterator found = target.find(it->first);
-        if (found != target.end()) {
-            found->second += it->second;
-        } else {
-            target.emplace(it->first, it->second);
-        }
+void kronaReport(
+    DBWriter& writer,
+    unsigned int thread_idx,
+    const NcbiTaxonomy &taxDB,
+    const TaxonTree &tree,
+    const CladeCounts &counts
+) {
+    if (counts.unclassified > 0) {
+        char buffer[1024];
+        int len = snprintf(buffer, sizeof(buffer), "<node name=\"unclassified\"><magnitude><val>%d</val></magnitude></node>", counts.unclassified);
+        writer.writeAdd(buffer, static_cast<size_t>(len), thread_idx);
     }
+    kronaReport(writer, thread_idx, taxDB, tree, counts, tree.preorder[0]);
 }
 
 int taxonomyreport(int argc, const char **argv, const Command &command) {
@@ -187,21 +176,26 @@ int taxonomyreport(int argc, const char **argv, const Command &command) {
         mapping = new MappingReader(par.db1);
     }
 
-    int mode = Parameters::DBTYPE_OMIT_FILE;
     unsigned int localThreads = 1;
-    if (par.reportMode == Parameters::REPORT_MODE_KRAKENDB) {
-        mode = Parameters::DBTYPE_GENERIC_DB;
-        localThreads = 1;
 #ifdef OPENMP
-        localThreads = std::max(std::min((size_t)par.threads, reader.getSize()), (size_t)1);
+    localThreads = std::max(std::min((size_t)par.threads, reader.getSize()), (size_t)1);
 #endif
+    int mode = Parameters::DBTYPE_OMIT_FILE;
+    unsigned int writerThreads = 1;
+    if (par.reportMode == Parameters::REPORT_MODE_KRAKENDB) {
+        mode = Parameters::DBTYPE_GENERIC_DB;
+        writerThreads = localThreads;
     }
-    DBWriter writer(par.db3.c_str(), par.db3Index.c_str(), localThreads, false, mode);
+    DBWriter writer(par.db3.c_str(), par.db3Index.c_str(), writerThreads, false, mode);
     writer.open();
 
-    std::unordered_map<TaxID, std::vector<TaxID>> parentToChildren = taxDB->getParentToChildren();
+    TaxonTree tree = taxDB->getTaxonTree();
+    const size_t maxNodes = taxDB->maxNodes;
 
-    std::unordered_map<TaxID, unsigned int> taxCounts;
+    // one dense counter array per thread indexed by node id, merged TaxIDs are counted at their current node
+    unsigned int *taxCounts = new(std::nothrow) unsigned int[maxNodes * localThreads]();
+    Util::checkAllocation(taxCounts, "Can not allocate taxCounts memory in taxonomyreport");
+    std::vector<unsigned int> unclassifiedCounts(localThreads, 0);
     Debug::Progress progress(reader.getSize());
 #pragma omp parallel num_threads(localThreads)
     {
@@ -210,7 +204,29 @@ int taxonomyreport(int argc, const char **argv, const Command &command) {
         thread_idx = (unsigned int) omp_get_thread_num();
 #endif
 
-        std::unordered_map<TaxID, unsigned int> localTaxCounts;
+        unsigned int *localTaxCounts = taxCounts + thread_idx * maxNodes;
+        unsigned int localUnclassified = 0;
+
+        // the per entry report only resets the counters it touched
+        const bool reportPerEntry = par.reportMode == Parameters::REPORT_MODE_KRAKENDB;
+        std::vector<unsigned int> localCladeCounts(reportPerEntry ? maxNodes : 0, 0);
+        std::vector<int> touched;
+        std::vector<int> touchedClades;
+
+        auto countTaxon = [&](TaxID taxon) {
+            if (taxon == 0) {
+                localUnclassified++;
+                return;
+            }
+            const TaxonNode *node = taxDB->taxonNode(taxon, false);
+            if (node == NULL) {
+                return;
+            }
+            if (localTaxCounts[node->id]++ == 0 && reportPerEntry) {
+                touched.emplace_back(node->id);
+            }
+        };
+
 #pragma omp for schedule(dynamic, 10)
         for (size_t i = 0; i < reader.getSize(); ++i) {
             progress.updateProgress();
@@ -218,7 +234,7 @@ int taxonomyreport(int argc, const char **argv, const Command &command) {
             if (isSequenceDB == true) {
                 unsigned int taxon = mapping->lookup(reader.getDbKey(i));
                 if (taxon != 0) {
-                    ++localTaxCounts[taxon];
+                    countTaxon(taxon);
                 }
                 continue;
             }
@@ -227,32 +243,48 @@ int taxonomyreport(int argc, const char **argv, const Command &command) {
             size_t entryCount = 0;
             while (*data != '\0') {
                 if (isTaxonomyInput) {
-                    TaxID taxon = Util::fast_atoi<int>(data);
-                    ++localTaxCounts[taxon];
+                    countTaxon(Util::fast_atoi<int>(data));
                 } else {
                     // match dbKey to its taxon based on mapping
                     unsigned int taxon = mapping->lookup(Util::fast_atoi<unsigned int>(data));
                     if (taxon != 0) {
-                        ++localTaxCounts[taxon];
+                        countTaxon(taxon);
                     }
                 }
                 entryCount++;
                 data = Util::skipLine(data);
             }
-            if (par.reportMode == Parameters::REPORT_MODE_KRAKENDB) {
-                std::unordered_map<TaxID, TaxonCounts> cladeCounts = taxDB->getCladeCounts(localTaxCounts, parentToChildren);
+            if (reportPerEntry) {
+                for (size_t j = 0; j < touched.size(); ++j) {
+                    unsigned int count = localTaxCounts[touched[j]];
+                    int id = touched[j];
+                    while (true) {
+                        if (localCladeCounts[id] == 0) {
+                            touchedClades.emplace_back(id);
+                        }
+                        localCladeCounts[id] += count;
+                        if (tree.parent[id] == id) {
+                            break;
+                        }
+                        id = tree.parent[id];
+                    }
+                }
+                CladeCounts counts = { localTaxCounts, localCladeCounts.data(), localUnclassified };
                 writer.writeStart(thread_idx);
-                taxReport(writer, thread_idx, *taxDB, cladeCounts, entryCount);
+                taxReport(writer, thread_idx, *taxDB, tree, counts, entryCount);
                 writer.writeEnd(reader.getDbKey(i), thread_idx);
-                localTaxCounts.clear();
+                for (size_t j = 0; j < touched.size(); ++j) {
+                    localTaxCounts[touched[j]] = 0;
+                }
+                for (size_t j = 0; j < touchedClades.size(); ++j) {
+                    localCladeCounts[touchedClades[j]] = 0;
+                }
+                touched.clear();
+                touchedClades.clear();
+                localUnclassified = 0;
             }
         }
-        if (par.reportMode != Parameters::REPORT_MODE_KRAKENDB) {
-#pragma omp critical
-{
-            mergeMaps(taxCounts, localTaxCounts);
-}
-        }
+        unclassifiedCounts[thread_idx] = localUnclassified;
     }
 
     int status = EXIT_SUCCESS;
@@ -260,18 +292,44 @@ int taxonomyreport(int argc, const char **argv, const Command &command) {
         reader.close();
         writer.close(true);
     } else {
-        Debug(Debug::INFO) << "Found " << taxCounts.size() << " different taxa for " << reader.getSize() << " different reads\n";
-        unsigned int unknownCnt = (taxCounts.find(0) != taxCounts.end()) ? taxCounts.at(0) : 0;
-        Debug(Debug::INFO) << unknownCnt << " reads are unclassified\n";
+        // sum up the thread counters in blocks, the inner loop runs over contiguous memory and is vectorized
+        const size_t blockSize = 4096;
+#pragma omp parallel for schedule(static) num_threads(localThreads)
+        for (size_t start = 0; start < maxNodes; start += blockSize) {
+            const size_t end = std::min(start + blockSize, maxNodes);
+            for (size_t t = 1; t < localThreads; ++t) {
+                const unsigned int *threadCounts = taxCounts + t * maxNodes;
+                for (size_t j = start; j < end; ++j) {
+                    taxCounts[j] += threadCounts[j];
+                }
+            }
+        }
+        unsigned int unclassified = 0;
+        for (size_t t = 0; t < localThreads; ++t) {
+            unclassified += unclassifiedCounts[t];
+        }
+
+        size_t taxaCount = (unclassified > 0) ? 1 : 0;
+        for (size_t i = 0; i < maxNodes; ++i) {
+            taxaCount += (taxCounts[i] > 0);
+        }
+        Debug(Debug::INFO) << "Found " << taxaCount << " different taxa for " << reader.getSize() << " different reads\n";
+        Debug(Debug::INFO) << unclassified << " reads are unclassified\n";
         const size_t entryCount = reader.getSize();
         reader.close();
 
         Debug(Debug::INFO) << "Calculating clade counts ... ";
-        std::unordered_map<TaxID, TaxonCounts> cladeCounts = taxDB->getCladeCounts(taxCounts, parentToChildren);
+        // children come after their parent in preorder, so going backwards every clade is complete before it is added to its parent
+        std::vector<unsigned int> cladeCounts(taxCounts, taxCounts + maxNodes);
+        for (size_t i = tree.preorder.size() - 1; i > 0; --i) {
+            int id = tree.preorder[i];
+            cladeCounts[tree.parent[id]] += cladeCounts[id];
+        }
         Debug(Debug::INFO) << " Done\n";
+        CladeCounts counts = { taxCounts, cladeCounts.data(), unclassified };
         if (par.reportMode == Parameters::REPORT_MODE_KRAKEN) {
             writer.writeStart(0);
-            taxReport(writer, 0, *taxDB, cladeCounts, entryCount);
+            taxReport(writer, 0, *taxDB, tree, counts, entryCount);
             writer.writeEnd(0, 0, false, false);
         } else if (par.reportMode == Parameters::REPORT_MODE_KRONA) {
             writer.writeStart(0);
@@ -279,7 +337,7 @@ int taxonomyreport(int argc, const char **argv, const Command &command) {
             char buffer[1024];
             int len = snprintf(buffer, sizeof(buffer), "<node name=\"all\"><magnitude><val>%zu</val></magnitude>", entryCount);
             writer.writeAdd(buffer, static_cast<size_t>(len), 0);
-            kronaReport(writer, 0, *taxDB, cladeCounts, entryCount);
+            kronaReport(writer, 0, *taxDB, tree, counts);
             len = snprintf(buffer, sizeof(buffer), "</node></krona></div></body></html>");
             writer.writeAdd(buffer, static_cast<size_t>(len), 0);
             writer.writeEnd(0, 0, false, false);
@@ -290,6 +348,7 @@ int taxonomyreport(int argc, const char **argv, const Command &command) {
         writer.close(true);
         FileUtil::remove(writer.getIndexFileName());
     }
+    delete[] taxCounts;
     delete taxDB;
     return status;
 }
@@ -0,0 +1,75 @@
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "AccessionTaxonMapping.h"
+#include "Parameters.h"
+#include "Timer.h"
+
+const char* binary_name = "test_accessiontaxonmapping";
+DEFAULT_PARAMETER_SINGLETON_INIT
+
+int main (int, const char**) {
+    const size_t accessionCount = 100000;
+    const size_t lineCount = 2000000;
+
+    std::mt19937 rnd(42);
+    std::vector<std::string> accessions;
+    for (size_t i = 0; i < accessionCount; i++) {
+        accessions.emplace_back("WP_" + SSTR(rnd() % (accessionCount * 10)));
+    }
+
+    // start small to exercise growing the table
+    AccessionTaxonMapping mapping(16);
+    std::unordered_map<std::string, unsigned int> ids;
+    for (size_t i = 0; i < accessions.size(); i++) {
+        unsigned int id = mapping.insert(accessions[i].c_str(), accessions[i].length());
+        std::unordered_map<std::string, unsigned int>::iterator it = ids.find(accessions[i]);
+        if (it == ids.end()) {
+            if (id != ids.size()) {
+                std::cout << "Accession " << accessions[i] << " got id " << id << " instead of " << ids.size() << "\n";
+                return EXIT_FAILURE;
+            }
+            ids.emplace(accessions[i], id);
+        } else if (it->second != id) {
+            std::cout << "Accession " << accessions[i] << " got a new id\n";
+            return EXIT_FAILURE;
+        }
+    }
+    if (mapping.size() != ids.size() || mapping.find("WP_", 3) != AccessionTaxonMapping::NOT_FOUND) {
+        std::cout << "Invalid accession count or lookup\n";
+        return EXIT_FAILURE;
+    }
+
+    // NCBI columns with a header line, repeated accessions and accessions that are not in the mapping
+    std::string file = "test_accessiontaxonmapping.accession2taxid";
+    FILE *handle = fopen(file.c_str(), "w");
+    fprintf(handle, "accession\taccession.version\ttaxid\tgi\n");
+    std::unordered_map<std::string, TaxID> expected;
+    for (size_t i = 0; i < lineCount; i++) {
+        std::string accession = "WP_" + SSTR(rnd() % (accessionCount * 20));
+        TaxID taxon = 1 + rnd() % 100000;
+        fprintf(handle, "%s\t%s.1\t%d\t%zu\n", accession.c_str(), accession.c_str(), taxon, i);
+        expected[accession] = taxon;
+    }
+    fclose(handle);
+
+    Timer timer;
+    std::vector<std::string> files(1, file);
+    mapping.readMappingFiles(files, 4);
+    std::cout << "read mapping: " << timer.lap() << "\n";
+    remove(file.c_str());
+
+    for (std::unordered_map<std::string, unsigned int>::const_iterator it = ids.begin(); it != ids.end(); ++it) {
+        std::unordered_map<std::string, TaxID>::const_iterator found = expected.find(it->first);
+        TaxID taxon = (found == expected.end()) ? 0 : found->second;
+        if (mapping.getTaxon(it->second) != taxon) {
+            std::cout << "Accession " << it->first << " has taxon " << mapping.getTaxon(it->second) << " instead of " << taxon << "\n";
+            return EXIT_FAILURE;
+        }
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,92 @@
+#include <climits>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Command.h"
+#include "CommandDeclarations.h"
+#include "DBReader.h"
+#include "DBWriter.h"
+#include "FileUtil.h"
+#include "Parameters.h"
+
+const char* binary_name = "test_appenddb";
+DEFAULT_PARAMETER_SINGLETON_INIT
+
+static void runCommand(const char *name, int (*commandFunction)(int, const char **, const Command&),
+                       std::vector<const char *> args) {
+    Parameters &par = Parameters::getInstance();
+    std::vector<DbType> databases;
+    for (size_t i = 0; i < args.size(); i++) {
+        databases.push_back({"DB", DbType::ACCESS_MODE_INPUT, DbType::NEED_DATA, NULL});
+    }
+    Command command = {name, commandFunction, &par.onlyverbosity, COMMAND_STORAGE, NULL, NULL, NULL, NULL, CITATION_MMSEQS2, databases};
+    par.setDefaults();
+    if (commandFunction(args.size(), args.data(), command) != EXIT_SUCCESS) {
+        std::cout << name << " failed\n";
+        EXIT(EXIT_FAILURE);
+    }
+}
+
+static void writeDb(const std::string &db, unsigned int from, unsigned int to, const std::string &prefix, int dbtype) {
+    DBWriter writer(db.c_str(), (db + ".index").c_str(), 1, false, dbtype);
+    writer.open();
+    for (unsigned int key = from; key < to; key++) {
+        std::string data = prefix + SSTR(key) + "\n";
+        writer.writeData(data.c_str(), data.size(), key, 0);
+    }
+    writer.close(true);
+}
+
+static bool checkDb(const std::string &db, unsigned int size, const char *const *prefixes) {
+    DBReader<unsigned int> reader(db.c_str(), (db + ".index").c_str(), 1, DBReader<unsigned int>::USE_INDEX|DBReader<unsigned int>::USE_DATA);
+    reader.open(DBReader<unsigned int>::NOSORT);
+    bool correct = reader.getSize() == size;
+    for (unsigned int key = 0; correct && key < size; key++) {
+        const size_t id = reader.getId(key);
+        correct = id != UINT_MAX && std::string(reader.getData(id, 0)) == prefixes[key] + SSTR(key) + "\n";
+    }
+    reader.close();
+    if (correct == false) {
+        std::cout << db << " has wrong entries\n";
+    }
+    return correct;
+}
+
+int main (int, const char**) {
+    const std::string db = "test_appenddb";
+    const std::string appendDb = "test_appenddb_new";
+    writeDb(db, 0, 3, "SEQ", Parameters::DBTYPE_AMINO_ACIDS);
+    writeDb(db + "_h", 0, 3, "HDR", Parameters::DBTYPE_GENERIC_DB);
+    writeDb(appendDb, 3, 5, "NEWSEQ", Parameters::DBTYPE_AMINO_ACIDS);
+    // like a result2repseq DB, the header DB also contains the keys of the existing entries
+    writeDb(appendDb + "_h", 0, 8, "NEWHDR", Parameters::DBTYPE_GENERIC_DB);
+
+    const char *seqs[] = { "SEQ", "SEQ", "SEQ", "NEWSEQ", "NEWSEQ" };
+    const char *hdrs[] = { "HDR", "HDR", "HDR", "NEWHDR", "NEWHDR" };
+    int status = EXIT_SUCCESS;
+
+    runCommand("appenddb", appenddb, { db.c_str(), appendDb.c_str() });
+    if (FileUtil::fileExists((db + ".1").c_str()) == false || FileUtil::fileExists(db.c_str())) {
+        std::cout << "appenddb did not add a data segment\n";
+        status = EXIT_FAILURE;
+    }
+    if (checkDb(db, 5, seqs) == false || checkDb(db + "_h", 5, hdrs) == false) {
+        status = EXIT_FAILURE;
+    }
+
+    runCommand("compactdb", compactdb, { db.c_str() });
+    if (FileUtil::fileExists((db + ".0").c_str()) || FileUtil::fileExists(db.c_str()) == false) {
+        std::cout << "compactdb did not merge the data segments\n";
+        status = EXIT_FAILURE;
+    }
+    if (checkDb(db, 5, seqs) == false) {
+        status = EXIT_FAILURE;
+    }
+
+    DBReader<unsigned int>::removeDb(db);
+    DBReader<unsigned int>::removeDb(db + "_h");
+    DBReader<unsigned int>::removeDb(appendDb);
+    DBReader<unsigned int>::removeDb(appendDb + "_h");
+    return status;
+}
@@ -0,0 +1,151 @@
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "DBReader.h"
+#include "DBWriter.h"
+#include "FileUtil.h"
+#include "IndexTable.h"
+#include "Parameters.h"
+#include "QueryMatcherTaxonomyHook.h"
+
+const char* binary_name = "test_claderanges";
+DEFAULT_PARAMETER_SINGLETON_INIT
+
+typedef std::vector<std::pair<unsigned int, unsigned int>> Ranges;
+
+static void writeFile(const std::string &file, const std::string &data) {
+    FILE *handle = FileUtil::openFileOrDie(file.c_str(), "w", false);
+    fwrite(data.c_str(), sizeof(char), data.size(), handle);
+    fclose(handle);
+}
+
+static bool checkRanges(QueryMatcherTaxonomyHook &hook, IndexTable &table, const Ranges &expected, const char *expression) {
+    Ranges ranges = hook.getCladeRanges(table, 0);
+    if (ranges != expected) {
+        std::cout << "Wrong clade ranges for " << expression << ":";
+        for (size_t i = 0; i < ranges.size(); i++) {
+            std::cout << " [" << ranges[i].first << ", " << ranges[i].second << ")";
+        }
+        std::cout << "\n";
+        return false;
+    }
+    return true;
+}
+
+int main (int, const char**) {
+    const std::string db = "test_claderanges";
+    // root with the genera 2 to 5 and a species below each of the first three genera
+    writeFile(db + "_nodes.dmp",
+              "1\t|\t1\t|\tno rank\t|\t\t|\n"
+              "2\t|\t1\t|\tgenus\t|\t\t|\n"
+              "3\t|\t1\t|\tgenus\t|\t\t|\n"
+              "4\t|\t1\t|\tgenus\t|\t\t|\n"
+              "5\t|\t1\t|\tgenus\t|\t\t|\n"
+              "10\t|\t2\t|\tspecies\t|\t\t|\n"
+              "11\t|\t3\t|\tspecies\t|\t\t|\n"
+              "12\t|\t4\t|\tspecies\t|\t\t|\n");
+    writeFile(db + "_names.dmp",
+              "1\t|\troot\t|\t\t|\tscientific name\t|\n"
+              "2\t|\tGenus A\t|\t\t|\tscientific name\t|\n"
+              "3\t|\tGenus B\t|\t\t|\tscientific name\t|\n"
+              "4\t|\tGenus C\t|\t\t|\tscientific name\t|\n"
+              "5\t|\tGenus D\t|\t\t|\tscientific name\t|\n"
+              "10\t|\tSpecies A\t|\t\t|\tscientific name\t|\n"
+              "11\t|\tSpecies B\t|\t\t|\tscientific name\t|\n"
+              "12\t|\tSpecies C\t|\t\t|\tscientific name\t|\n");
+    writeFile(db + "_merged.dmp", "13\t|\t12\t|\n");
+
+    // clades as assigned by createindex --index-tax-rank genus: 0 for the sequence without genus,
+    // then the genera ordered by the number of sequences
+    const unsigned int sequenceCount = 8;
+    const unsigned int taxa[sequenceCount] = { 10, 11, 12, 10, 1, 11, 12, 10 };
+    unsigned char clades[sequenceCount] = { 1, 2, 3, 1, 0, 2, 3, 1 };
+    const unsigned int cladeCount = 4;
+
+    std::string mapping;
+    DBWriter writer(db.c_str(), (db + ".index").c_str(), 1, false, Parameters::DBTYPE_AMINO_ACIDS);
+    writer.open();
+    for (unsigned int key = 0; key < sequenceCount; key++) {
+        writer.writeData("ACGT\n", 5, key, 0);
+        mapping.append(SSTR(key) + "\t" + SSTR(taxa[key]) + "\n");
+    }
+    writer.close(true);
+    writeFile(db + "_mapping", mapping);
+
+    // k-mer k occurs twice in every sequence i with (i + k) % 3 != 0
+    const size_t alphabetSize = 4;
+    std::vector<IndexEntryLocal> entries;
+    std::vector<size_t> offsets(1, 0);
+    for (size_t kmer = 0; kmer < alphabetSize; kmer++) {
+        for (unsigned int seqId = 0; seqId < sequenceCount; seqId++) {
+            if ((seqId + kmer) % 3 == 0) {
+                continue;
+            }
+            for (unsigned short pos = 0; pos < 2; pos++) {
+                IndexEntryLocal entry;
+                entry.seqId = seqId;
+                entry.position_j = pos;
+                entries.push_back(entry);
+            }
+        }
+        offsets.push_back(entries.size());
+    }
+
+    IndexTable table(alphabetSize, 1, false);
+    table.initTableByExternalDataCopy(sequenceCount, entries.size(), entries.data(), offsets.data());
+    table.setSequenceClades(clades, sequenceCount, cladeCount);
+    table.sortDBSeqLists();
+
+    int status = EXIT_SUCCESS;
+    for (size_t kmer = 0; kmer < alphabetSize; kmer++) {
+        for (unsigned int from = 0; from <= cladeCount; from++) {
+            for (unsigned int to = from; to <= cladeCount; to++) {
+                size_t expected = 0;
+                for (size_t i = offsets[kmer]; i < offsets[kmer + 1]; i++) {
+                    expected += (clades[entries[i].seqId] >= from && clades[entries[i].seqId] < to);
+                }
+                size_t size;
+                IndexEntryLocal *list = table.getDBSeqList(kmer, from, to, &size);
+                bool correct = (size == expected);
+                for (size_t i = 0; correct && i < size; i++) {
+                    correct = clades[list[i].seqId] >= from && clades[list[i].seqId] < to;
+                }
+                if (correct == false) {
+                    std::cout << "Wrong list for k-mer " << kmer << " and clades [" << from << ", " << to << ")\n";
+                    status = EXIT_FAILURE;
+                }
+            }
+        }
+    }
+
+    DBReader<unsigned int> reader(db.c_str(), (db + ".index").c_str(), 1, DBReader<unsigned int>::USE_INDEX);
+    reader.open(DBReader<unsigned int>::NOSORT);
+    const char *expressions[] = { "2", "3,4", "2,4", "!2", "1", "5" };
+    const Ranges expected[] = {
+        { {1, 2} },
+        { {2, 4} },
+        { {1, 2}, {3, 4} },
+        { {0, 1}, {2, 4} },
+        // all clades match, so the lists do not have to be split
+        {},
+        // no clade matches
+        { {0, 0} }
+    };
+    for (size_t i = 0; i < sizeof(expressions) / sizeof(expressions[0]); i++) {
+        QueryMatcherTaxonomyHook hook(db, &reader, expressions[i], 1);
+        if (checkRanges(hook, table, expected[i], expressions[i]) == false) {
+            status = EXIT_FAILURE;
+        }
+    }
+    reader.close();
+
+    DBReader<unsigned int>::removeDb(db);
+    FileUtil::remove((db + "_mapping").c_str());
+    FileUtil::remove((db + "_nodes.dmp").c_str());
+    FileUtil::remove((db + "_names.dmp").c_str());
+    FileUtil::remove((db + "_merged.dmp").c_str());
+    return status;
+}
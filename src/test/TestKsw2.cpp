@@ -19,10 +19,14 @@
 #include <NucleotideMatrix.h>
 #include <Sequence.h>
 #include <BandedNucleotideAligner.h>
+#include <Parameters.h>
+#include <Timer.h>
 
 #include <algorithm>
+#include <vector>
 
 const char* binary_name = "test_ksw2";
+DEFAULT_PARAMETER_SINGLETON_INIT
 
 
 /**
@@ -333,7 +337,9 @@ int main (int, const char**) {
 //    std::string target =     "AAAAATCCGGAACAGTTTCAATCCCACTGATCGATGCTCTCTACACCATGCAAAAAA";
 //    short diagonal = 15-14;
 
-    NucleotideMatrix subMat("blosum62.out", 2.0, -0.0f);
+    Parameters& par = Parameters::getInstance();
+    par.initMatrices();
+    NucleotideMatrix subMat(par.scoringMatrixFile.values.nucleotide().c_str(), 2.0, -0.0f);
     BandedNucleotideAligner aligner((BaseMatrix*)&subMat, 10000,  5, 1, 40);
     EvalueComputation evalueComputation(100000, &subMat, 7, 1);
     
@@ -393,7 +399,29 @@ int main (int, const char**) {
 //        std::cout << targetAln << std::endl;
         std::cout <<  alignment.score1 << " " << alignment.qStartPos1  << "-"<< alignment.qEndPos1 << " "
         << alignment.dbStartPos1 << "-"<< alignment.dbEndPos1 << std::endl;
+        delete [] alignment.cigar;
     }
+
+    // throughput for many near-identical pairs sharing one query, as in nucleotide clustering
+    const int64_t benchCnt = 20000;
+    std::vector<std::string> benchTargets;
+    for(i = 0; i < benchCnt; i++) {
+        char * target = generate_mutated_sequence((char*)query.c_str(), (int) query.size(), 0.01, 0.01, 8);
+        benchTargets.emplace_back(target);
+        free(target);
+    }
+    Timer timer;
+    size_t benchCells = 0;
+    for(i = 0; i < benchCnt; i++) {
+        targetObj->mapSequence(1, 1, benchTargets[i].c_str(), benchTargets[i].size());
+        std::string backtrace;
+        s_align alignment = aligner.align(targetObj, diagonal, false, backtrace, &evalueComputation);
+        benchCells += backtrace.size();
+        delete [] alignment.cigar;
+    }
+    double seconds = timer.getTimediff();
+    std::cout << benchCnt << " pairs of length " << p.len << " aligned in " << seconds << "s ("
+              << (benchCnt / seconds) << " pairs/s, " << benchCells << " alignment columns)" << std::endl;
     
 
 //    std::string query  =    "CCGCTCCGGAAGTCACAGTTTCAATCCCAAAACTGATCGATGCTCTCTCCATGC";
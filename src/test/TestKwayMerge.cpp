@@ -4,10 +4,14 @@
 
 #include <iostream>
 #include <queue>
+#include <random>
 
 
 #include "SubstitutionMatrix.h"
 #include "Sequence.h"
+#include "QueryMatcher.h"
+#include "FastSort.h"
+#include "Timer.h"
 
 const char* binary_name = "test_kwaymerge";
 struct KmerEntry{
@@ -18,6 +22,7 @@ struct KmerEntry{
 };
 
 void mergeKmerEntryLists(KmerEntry **entries, size_t * entrySizes, const int fileCnt);
+int benchmarkHitListMerge(size_t queries, size_t splits, size_t hitsPerSplit);
 
 int main (int, const char**) {
     const int fileCnt = 3;
@@ -61,7 +66,76 @@ int main (int, const char**) {
     mergeKmerEntryLists(entries, entryCnts, fileCnt);
     delete [] entries;
     delete [] entryCnts;
-    return 0;
+
+    // merge of prefilter target splits
+    int status = EXIT_SUCCESS;
+    const size_t splits[] = { 2, 4, 16 };
+    for (size_t i = 0; i < 3; i++) {
+        if (benchmarkHitListMerge(10000, splits[i], 300) != EXIT_SUCCESS) {
+            status = EXIT_FAILURE;
+        }
+    }
+    return status;
+}
+
+int benchmarkHitListMerge(size_t queries, size_t splits, size_t hitsPerSplit) {
+    std::mt19937 rnd(42);
+    std::vector<std::vector<hit_t>> hits(queries);
+    std::vector<std::vector<size_t>> listStarts(queries);
+    for (size_t q = 0; q < queries; q++) {
+        for (size_t split = 0; split < splits; split++) {
+            listStarts[q].push_back(hits[q].size());
+            size_t start = hits[q].size();
+            size_t cnt = rnd() % (hitsPerSplit + 1);
+            for (size_t i = 0; i < cnt; i++) {
+                hit_t hit;
+                // target splits contain disjoint target ids
+                hit.seqId = static_cast<unsigned int>(i * splits + split);
+                hit.prefScore = static_cast<int>(rnd() % 256);
+                hit.diagonal = static_cast<unsigned short>(rnd() % 1000);
+                hits[q].push_back(hit);
+            }
+            SORT_SERIAL(hits[q].begin() + start, hits[q].end(), hit_t::compareHitsByScoreAndId);
+        }
+        listStarts[q].push_back(hits[q].size());
+    }
+
+    std::vector<hit_t> sorted;
+    Timer timer;
+    size_t checksum = 0;
+    for (size_t q = 0; q < queries; q++) {
+        sorted = hits[q];
+        SORT_SERIAL(sorted.begin(), sorted.end(), hit_t::compareHitsByScoreAndId);
+        checksum += sorted.size();
+    }
+    std::string sortTime = timer.lap();
+    timer.reset();
+
+    std::vector<hit_t> merged;
+    for (size_t q = 0; q < queries; q++) {
+        QueryMatcher::mergeHitLists(hits[q], listStarts[q], merged);
+        checksum += merged.size();
+    }
+    std::string mergeTime = timer.lap();
+
+    for (size_t q = 0; q < queries; q++) {
+        sorted = hits[q];
+        SORT_SERIAL(sorted.begin(), sorted.end(), hit_t::compareHitsByScoreAndId);
+        QueryMatcher::mergeHitLists(hits[q], listStarts[q], merged);
+        if (merged.size() != sorted.size()) {
+            std::cout << "Merged hit list of query " << q << " has " << merged.size() << " instead of " << sorted.size() << " hits" << std::endl;
+            return EXIT_FAILURE;
+        }
+        for (size_t i = 0; i < sorted.size(); i++) {
+            if (sorted[i].seqId != merged[i].seqId || sorted[i].prefScore != merged[i].prefScore
+                || sorted[i].diagonal != merged[i].diagonal) {
+                std::cout << "Merged hit list of query " << q << " differs from sorted list at position " << i << std::endl;
+                return EXIT_FAILURE;
+            }
+        }
+    }
+    std::cout << splits << " splits: sort " << sortTime << " k-way merge " << mergeTime << " (" << checksum << " hits)" << std::endl;
+    return EXIT_SUCCESS;
 }
 
 struct KmerPosition {
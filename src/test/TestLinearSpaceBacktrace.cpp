@@ -0,0 +1,161 @@
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <string>
+
+#include "StripedSmithWaterman.h"
+#include "SubstitutionMatrix.h"
+#include "EvalueComputation.h"
+#include "Sequence.h"
+#include "Parameters.h"
+#include "Matcher.h"
+#include "Timer.h"
+
+const char* binary_name = "test_linearspacebacktrace";
+DEFAULT_PARAMETER_SINGLETON_INIT
+
+int rescoreBacktrace(const std::string &backtrace, const Sequence &query, const Sequence &target,
+                     int qStart, int dbStart, SubstitutionMatrix &subMat, int gapOpen, int gapExtend) {
+    int score = 0;
+    int qPos = qStart;
+    int dbPos = dbStart;
+    char prev = 'M';
+    for (size_t i = 0; i < backtrace.size(); i++) {
+        char op = backtrace[i];
+        if (op == 'M') {
+            score += subMat.subMatrix[query.numSequence[qPos]][target.numSequence[dbPos]];
+            qPos++;
+            dbPos++;
+        } else {
+            score -= (op == prev) ? gapExtend : gapOpen;
+            if (op == 'I') {
+                qPos++;
+            } else {
+                dbPos++;
+            }
+        }
+        prev = op;
+    }
+    return score;
+}
+
+// mutated copy of a random query including indels, flanked by random residues
+// with unique set, indels are spaced out and never next to a substitution or an equal residue,
+// so that the optimal alignment is unique and every traceback has to find the same one
+void mutatedPair(std::mt19937 &rnd, size_t length, bool unique, std::string &query, std::string &target) {
+    const char *aa = "ACDEFGHIKLMNPQRSTVWY";
+    for (size_t i = 0; i < length; i++) {
+        query.push_back(aa[rnd() % 20]);
+    }
+    const size_t flank = length / 16;
+    for (size_t i = 0; i < flank; i++) {
+        target.push_back(aa[rnd() % 20]);
+    }
+    for (size_t i = 0; i < query.size(); i++) {
+        if (unique) {
+            const bool inner = i > 0 && i + 1 < query.size();
+            if (inner && i % 100 == 50 && query[i - 1] != query[i] && query[i] != query[i + 1]) {
+                // deletion
+                continue;
+            }
+            if (inner && i % 100 == 0) {
+                char inserted = aa[rnd() % 20];
+                while (inserted == query[i] || inserted == query[i + 1]) {
+                    inserted = aa[rnd() % 20];
+                }
+                target.push_back(query[i]);
+                target.push_back(inserted);
+                continue;
+            }
+            const size_t indelDist = std::min(i % 50, 50 - i % 50);
+            if (indelDist > 5 && rnd() % 100 < 10) {
+                target.push_back(aa[rnd() % 20]);
+            } else {
+                target.push_back(query[i]);
+            }
+            continue;
+        }
+        unsigned int r = rnd() % 100;
+        if (r < 20) {
+            target.push_back(aa[rnd() % 20]);
+        } else if (r < 22) {
+            // deletion
+        } else if (r < 24) {
+            target.push_back(query[i]);
+            target.push_back(aa[rnd() % 20]);
+        } else {
+            target.push_back(query[i]);
+        }
+    }
+    for (size_t i = 0; i < flank; i++) {
+        target.push_back(aa[rnd() % 20]);
+    }
+}
+
+int main (int, const char**) {
+    Parameters& par = Parameters::getInstance();
+    par.initMatrices();
+    SubstitutionMatrix subMat(par.scoringMatrixFile.values.aminoacid().c_str(), 2.0, 0.0f);
+    int8_t *tinySubMat = new int8_t[subMat.alphabetSize * subMat.alphabetSize];
+    for (int i = 0; i < subMat.alphabetSize; i++) {
+        for (int j = 0; j < subMat.alphabetSize; j++) {
+            tinySubMat[i * subMat.alphabetSize + j] = (int8_t) subMat.subMatrix[i][j];
+        }
+    }
+    const int gapOpen = 11;
+    const int gapExtend = 1;
+    EvalueComputation evaluer(100000, &subMat, gapOpen, gapExtend);
+
+    std::mt19937 rnd(42);
+    // the titin-sized pair is above the default threshold, the short pair is below it
+    const size_t lengths[] = { 8000, 1500 };
+    const char *cases[] = { "titin-sized", "short" };
+    int status = EXIT_SUCCESS;
+    for (size_t c = 0; c < 2; c++) {
+        std::string query;
+        std::string target;
+        mutatedPair(rnd, lengths[c], c == 1, query, target);
+
+        Sequence qSeq(query.size(), Parameters::DBTYPE_AMINO_ACIDS, &subMat, 0, false, false);
+        qSeq.mapSequence(0, 0, query.c_str(), query.size());
+        Sequence tSeq(target.size(), Parameters::DBTYPE_AMINO_ACIDS, &subMat, 0, false, false);
+        tSeq.mapSequence(1, 1, target.c_str(), target.size());
+
+        SmithWaterman aligner(std::max(query.size(), target.size()), subMat.alphabetSize, false, 1.0, &subMat);
+        aligner.ssw_init(&qSeq, tinySubMat, &subMat);
+
+        const size_t thresholds[] = { SmithWaterman::LINEAR_SPACE_BACKTRACE_CELLS, 0 };
+        const char *names[] = { "default", "linear space" };
+        s_align alignments[2];
+        std::string backtraces[2];
+        for (size_t t = 0; t < 2; t++) {
+            aligner.setLinearSpaceBacktraceCells(thresholds[t]);
+            Timer timer;
+            alignments[t] = aligner.ssw_align(tSeq.numSequence, tSeq.L, backtraces[t], gapOpen, gapExtend,
+                                              Matcher::SCORE_COV_SEQID, 10000, &evaluer, 0, 0.0, 0.0, qSeq.L / 2);
+            int rescored = rescoreBacktrace(backtraces[t], qSeq, tSeq, alignments[t].qStartPos1, alignments[t].dbStartPos1,
+                                            subMat, gapOpen, gapExtend);
+            std::cout << cases[c] << " " << names[t] << ": score " << alignments[t].score1 << " rescored " << rescored
+                      << " q " << alignments[t].qStartPos1 << "-" << alignments[t].qEndPos1
+                      << " t " << alignments[t].dbStartPos1 << "-" << alignments[t].dbEndPos1
+                      << " ids " << alignments[t].identicalAACnt << " len " << backtraces[t].size()
+                      << " time " << timer.lap() << "\n";
+            if (t == 1 && static_cast<uint32_t>(rescored) != alignments[t].score1) {
+                std::cout << "Linear space backtrace does not reproduce the alignment score\n";
+                status = EXIT_FAILURE;
+            }
+            delete [] alignments[t].cigar;
+        }
+
+        const size_t cells = static_cast<size_t>(alignments[0].qEndPos1 + 1) * static_cast<size_t>(alignments[0].dbEndPos1 + 1);
+        if (cells <= SmithWaterman::LINEAR_SPACE_BACKTRACE_CELLS
+            && (alignments[0].score1 != alignments[1].score1 || backtraces[0] != backtraces[1]
+                || alignments[0].qStartPos1 != alignments[1].qStartPos1 || alignments[0].dbStartPos1 != alignments[1].dbStartPos1)) {
+            std::cout << "Linear space backtrace differs from the default backtrace\n";
+            status = EXIT_FAILURE;
+        }
+    }
+
+    delete [] tinySubMat;
+    return status;
+}
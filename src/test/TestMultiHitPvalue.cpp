@@ -0,0 +1,94 @@
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "MultiHitPvalue.h"
+#include "Parameters.h"
+#include "Timer.h"
+
+const char* binary_name = "test_multihitpvalue";
+DEFAULT_PARAMETER_SINGLETON_INIT
+
+// previous implementation summing all orfCount terms
+double referencePvalue(unsigned int orfCount, double r, const double *lGammaLookup, const double *logB) {
+    double truncatedFisherPval = 0;
+    const double logR = log(r);
+    for (size_t i = 0; i < orfCount; ++i) {
+        truncatedFisherPval += exp(i*logR - lGammaLookup[i+1] + logB[i]);
+    }
+    return exp(-r) * truncatedFisherPval;
+}
+
+int main (int, const char**) {
+    const unsigned int maxOrfCount = 8000;
+    const size_t querySets = 200;
+    const size_t targetSetsPerQuery = 1000;
+    const double alpha = 1.0;
+
+    std::vector<double> lGammaLookup(maxOrfCount + 2);
+    for (size_t i = 0; i < maxOrfCount + 2; ++i) {
+        lGammaLookup[i] = lgamma(i);
+    }
+
+    std::mt19937 rnd(42);
+    std::vector<unsigned int> orfCounts(querySets);
+    std::vector<std::vector<double>> rs(querySets);
+    for (size_t i = 0; i < querySets; i++) {
+        orfCounts[i] = 1 + rnd() % maxOrfCount;
+        for (size_t j = 0; j < targetSetsPerQuery; j++) {
+            // mostly weak set matches, some with many strong hits
+            double r = (rnd() % 10 == 0) ? (rnd() % 200000) / 100.0 : (rnd() % 2000) / 100.0;
+            rs[i].push_back(r + 1e-3);
+        }
+    }
+
+    Timer timer;
+    std::vector<double> logB(maxOrfCount);
+    std::vector<double> reference;
+    reference.reserve(querySets * targetSetsPerQuery);
+    for (size_t i = 0; i < querySets; i++) {
+        MultiHitPvalue::precomputeLogB(orfCounts[i], alpha / (orfCounts[i] + 1), lGammaLookup.data(), logB.data());
+        for (size_t j = 0; j < targetSetsPerQuery; j++) {
+            reference.emplace_back(referencePvalue(orfCounts[i], rs[i][j], lGammaLookup.data(), logB.data()));
+        }
+    }
+    std::cout << "all terms: " << timer.lap() << "\n";
+
+    timer.reset();
+    MultiHitPvalue pvalue(maxOrfCount, lGammaLookup.data());
+    std::vector<double> results;
+    results.reserve(querySets * targetSetsPerQuery);
+    for (size_t i = 0; i < querySets; i++) {
+        pvalue.prepare(orfCounts[i], alpha / (orfCounts[i] + 1));
+        for (size_t j = 0; j < targetSetsPerQuery; j++) {
+            results.emplace_back(pvalue.evaluate(rs[i][j]));
+        }
+    }
+    std::cout << "largest terms: " << timer.lap() << "\n";
+
+    int status = EXIT_SUCCESS;
+    double maxError = 0;
+    for (size_t i = 0; i < results.size(); i++) {
+        const double r = rs[i / targetSetsPerQuery][i % targetSetsPerQuery];
+        const double a = reference[i];
+        const double b = results[i];
+        if (std::isfinite(b) == false || b < 0 || b > 1 + 1e-12) {
+            std::cout << "Set " << i << " is invalid: " << b << "\n";
+            status = EXIT_FAILURE;
+            continue;
+        }
+        // the reference loses precision once exp(-r) is subnormal and overflows for even larger r
+        if (r > 700) {
+            continue;
+        }
+        double error = std::fabs(a - b) / a;
+        maxError = std::max(maxError, error);
+        if (error > 1e-12) {
+            std::cout << "Set " << i << " differs: " << a << " vs. " << b << "\n";
+            status = EXIT_FAILURE;
+        }
+    }
+    std::cout << "max relative error: " << maxError << "\n";
+    return status;
+}
@@ -0,0 +1,136 @@
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "ClusteringAlgorithms.h"
+#include "DBReader.h"
+#include "DBWriter.h"
+#include "FileUtil.h"
+#include "Parameters.h"
+#include "Timer.h"
+
+const char* binary_name = "test_parallelsetcover";
+DEFAULT_PARAMETER_SINGLETON_INIT
+
+static std::vector<std::pair<unsigned int, unsigned int>> cluster(const std::string &seqDb, const std::string &alnDb, int threads, int mode) {
+    DBReader<unsigned int> seqDbr(seqDb.c_str(), (seqDb + ".index").c_str(), threads, DBReader<unsigned int>::USE_INDEX);
+    seqDbr.open(DBReader<unsigned int>::SORT_BY_LENGTH);
+    DBReader<unsigned int> alnDbr(alnDb.c_str(), (alnDb + ".index").c_str(), threads, DBReader<unsigned int>::USE_DATA|DBReader<unsigned int>::USE_INDEX);
+    alnDbr.open(DBReader<unsigned int>::NOSORT);
+
+    ClusteringAlgorithms algorithm(&seqDbr, &alnDbr, threads, Parameters::APC_SEQID, 0, NULL, NULL, NULL, NULL, 0, false, false, "test_parallelsetcover_tmp");
+    std::pair<unsigned int, unsigned int> *ret = algorithm.execute(mode);
+    std::vector<std::pair<unsigned int, unsigned int>> assignment(ret, ret + seqDbr.getSize());
+    delete[] ret;
+    alnDbr.close();
+    seqDbr.close();
+    return assignment;
+}
+
+static size_t checkAssignment(const std::vector<std::pair<unsigned int, unsigned int>> &assignment,
+                              const std::vector<std::set<unsigned int>> &edges, const char *name) {
+    std::vector<unsigned int> repOf(edges.size(), UINT_MAX);
+    for (size_t i = 0; i < assignment.size(); i++) {
+        if (repOf[assignment[i].second] != UINT_MAX) {
+            std::cout << name << ": element " << assignment[i].second << " is assigned twice\n";
+            EXIT(EXIT_FAILURE);
+        }
+        repOf[assignment[i].second] = assignment[i].first;
+    }
+    size_t reps = 0;
+    for (size_t i = 0; i < repOf.size(); i++) {
+        const unsigned int rep = repOf[i];
+        if (rep == UINT_MAX) {
+            std::cout << name << ": element " << i << " is not assigned\n";
+            EXIT(EXIT_FAILURE);
+        }
+        if (repOf[rep] != rep) {
+            std::cout << name << ": representative " << rep << " of " << i << " is not its own representative\n";
+            EXIT(EXIT_FAILURE);
+        }
+        // the clustering adds the missing reverse links, so the member can be listed by either side
+        if (rep != i && edges[rep].count(i) == 0 && edges[i].count(rep) == 0) {
+            std::cout << name << ": element " << i << " is not connected to its representative " << rep << "\n";
+            EXIT(EXIT_FAILURE);
+        }
+        reps += (rep == i);
+    }
+    return reps;
+}
+
+int main (int, const char**) {
+    const size_t nodes = 20000;
+    const size_t groupSize = 12;
+    const size_t crossEdges = 4;
+
+    // planted groups with dense edges inside a group and a few random edges between groups
+    std::mt19937 rnd(42);
+    std::vector<std::set<unsigned int>> edges(nodes);
+    for (size_t i = 0; i < nodes; i++) {
+        const size_t groupStart = (i / groupSize) * groupSize;
+        const size_t groupEnd = std::min(groupStart + groupSize, nodes);
+        for (size_t j = groupStart; j < groupEnd; j++) {
+            if (j != i && rnd() % 4 != 0) {
+                edges[i].insert(j);
+            }
+        }
+        for (size_t j = 0; j < crossEdges; j++) {
+            edges[i].insert(rnd() % nodes);
+        }
+        edges[i].erase(i);
+    }
+
+    std::string seqDb = "test_parallelsetcover_seq";
+    std::string alnDb = "test_parallelsetcover_aln";
+    DBWriter seqWriter(seqDb.c_str(), (seqDb + ".index").c_str(), 1, false, Parameters::DBTYPE_AMINO_ACIDS);
+    seqWriter.open();
+    DBWriter alnWriter(alnDb.c_str(), (alnDb + ".index").c_str(), 1, false, Parameters::DBTYPE_ALIGNMENT_RES);
+    alnWriter.open();
+    std::string data;
+    for (size_t i = 0; i < nodes; i++) {
+        data.assign(50 + rnd() % 500, 'A');
+        data.push_back('\n');
+        seqWriter.writeData(data.c_str(), data.size(), i, 0);
+        // the self hit comes first, as in a search result
+        data = SSTR(i) + "\t0\t1.000\n";
+        for (std::set<unsigned int>::const_iterator it = edges[i].begin(); it != edges[i].end(); ++it) {
+            data.append(SSTR(*it) + "\t0\t0." + SSTR(500 + rnd() % 500) + "\n");
+        }
+        alnWriter.writeData(data.c_str(), data.size(), i, 0);
+    }
+    alnWriter.close(true);
+    seqWriter.close(true);
+
+    Timer timer;
+    std::vector<std::pair<unsigned int, unsigned int>> serial = cluster(seqDb, alnDb, 1, 1);
+    std::cout << "serial set cover: " << timer.lap() << "\n";
+    std::vector<std::pair<unsigned int, unsigned int>> parallel = cluster(seqDb, alnDb, 4, 5);
+    std::cout << "parallel set cover: " << timer.lap() << "\n";
+    std::vector<std::pair<unsigned int, unsigned int>> parallelSingle = cluster(seqDb, alnDb, 1, 5);
+
+    FileUtil::remove(seqDb.c_str());
+    FileUtil::remove((seqDb + ".index").c_str());
+    FileUtil::remove((seqDb + ".dbtype").c_str());
+    FileUtil::remove(alnDb.c_str());
+    FileUtil::remove((alnDb + ".index").c_str());
+    FileUtil::remove((alnDb + ".dbtype").c_str());
+
+    const size_t serialReps = checkAssignment(serial, edges, "serial");
+    const size_t parallelReps = checkAssignment(parallel, edges, "parallel");
+    std::cout << "representatives serial: " << serialReps << " parallel: " << parallelReps << "\n";
+    if (parallel != parallelSingle) {
+        std::cout << "parallel set cover depends on the number of threads\n";
+        return EXIT_FAILURE;
+    }
+    // the parallel set cover is approximate, it may select a few more representatives
+    if (parallelReps > serialReps + serialReps / 20) {
+        std::cout << "parallel set cover selected too many representatives\n";
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,211 @@
+#include <cstdio>
+#include <climits>
+#include <cmath>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "NcbiTaxonomy.h"
+#include "Parameters.h"
+#include "FileUtil.h"
+#include "Timer.h"
+
+const char* binary_name = "test_weightedmajoritylca";
+DEFAULT_PARAMETER_SINGLETON_INIT
+
+static const char *ranks[] = { "forma", "varietas", "subspecies", "species", "species subgroup", "species group",
+                               "subgenus", "genus", "subtribe", "tribe", "subfamily", "family", "superfamily",
+                               "parvorder", "infraorder", "suborder", "order", "superorder", "infraclass", "subclass",
+                               "class", "superclass", "subphylum", "phylum", "superphylum", "subkingdom", "kingdom",
+                               "superkingdom" };
+
+// random tree with ranks decreasing towards the leaves and unranked nodes in between
+void writeTaxonomy(const std::string &prefix, size_t nodeCount, std::mt19937 &rnd) {
+    FILE *nodes = FileUtil::openAndDelete((prefix + "_nodes.dmp").c_str(), "w");
+    FILE *names = FileUtil::openAndDelete((prefix + "_names.dmp").c_str(), "w");
+    FILE *merged = FileUtil::openAndDelete((prefix + "_merged.dmp").c_str(), "w");
+    std::vector<int> level(nodeCount + 1, 29);
+    fprintf(nodes, "1\t|\t1\t|\tno rank\t|\t\t|\n");
+    fprintf(names, "1\t|\troot\t|\t\t|\tscientific name\t|\n");
+    for (size_t taxon = 2; taxon <= nodeCount; taxon++) {
+        size_t window = std::min(taxon - 1, (size_t) 5000);
+        size_t parent = (rnd() % 10 < 7) ? (taxon - 1 - rnd() % window) : (1 + rnd() % (taxon - 1));
+        int parentLevel = level[parent];
+        const char *rank;
+        if (parentLevel <= 1 || rnd() % 4 == 0) {
+            rank = (rnd() % 2 == 0) ? "no rank" : "clade";
+            level[taxon] = parentLevel;
+        } else {
+            int minLevel = std::max(1, parentLevel - 4);
+            level[taxon] = minLevel + rnd() % (parentLevel - minLevel);
+            rank = ranks[level[taxon] - 1];
+        }
+        fprintf(nodes, "%zu\t|\t%zu\t|\t%s\t|\t\t|\n", taxon, parent, rank);
+        fprintf(names, "%zu\t|\ttaxon %zu\t|\t\t|\tscientific name\t|\n", taxon, taxon);
+    }
+    fclose(nodes);
+    fclose(names);
+    fclose(merged);
+}
+
+// previous implementation based on a std::map of TaxIDs
+// it sums the clade weights in a different order, so the percentages can differ in the last digits
+WeightedTaxResult referenceMajorityLCA(NcbiTaxonomy &t, const std::vector<WeightedTaxHit> &setTaxa, float majorityCutoff) {
+    struct Node {
+        double weight;
+        bool isCandidate;
+        TaxID childTaxon;
+    };
+    std::map<TaxID, Node> counts;
+    size_t assignedSeqs = 0;
+    size_t unassignedSeqs = 0;
+    double totalWeight = 0.0;
+    for (size_t i = 0; i < setTaxa.size(); ++i) {
+        TaxID currTaxId = setTaxa[i].taxon;
+        double currWeight = setTaxa[i].weight;
+        TaxonNode const *node = (currTaxId == 0) ? NULL : t.taxonNode(currTaxId, false);
+        if (node == NULL) {
+            unassignedSeqs++;
+            continue;
+        }
+        totalWeight += currWeight;
+        assignedSeqs++;
+        TaxID child = 0;
+        while (true) {
+            std::map<TaxID, Node>::iterator it = counts.find(currTaxId);
+            if (it == counts.end()) {
+                Node current = { currWeight, child == 0, child };
+                counts.emplace(currTaxId, current);
+            } else {
+                if (it->second.childTaxon != child) {
+                    it->second.isCandidate = true;
+                    it->second.childTaxon = child;
+                }
+                it->second.weight += currWeight;
+            }
+            if (node->parentTaxId == currTaxId) {
+                break;
+            }
+            child = currTaxId;
+            currTaxId = node->parentTaxId;
+            node = t.taxonNode(currTaxId, false);
+        }
+    }
+    if (totalWeight == 0) {
+        return WeightedTaxResult(0, assignedSeqs, unassignedSeqs, 0, 0.0);
+    }
+
+    TaxID selected = 0;
+    int minRank = INT_MAX;
+    double selectedPercent = 0;
+    for (std::map<TaxID, Node>::iterator it = counts.begin(); it != counts.end(); it++) {
+        double currPercent = it->second.weight / totalWeight;
+        if (it->second.isCandidate == false || currPercent < majorityCutoff) {
+            continue;
+        }
+        TaxonNode const *node = t.taxonNode(it->first, false);
+        int currMinRank = INT_MAX;
+        while (node->parentTaxId != node->taxId) {
+            int rankIndex = NcbiTaxonomy::findRankIndex(t.getString(node->rankIdx));
+            if (rankIndex > 0) {
+                currMinRank = rankIndex;
+                break;
+            }
+            node = t.taxonNode(node->parentTaxId, false);
+        }
+        if ((currMinRank < minRank) || ((currMinRank == minRank) && (currPercent > selectedPercent))) {
+            selected = it->first;
+            minRank = currMinRank;
+            selectedPercent = currPercent;
+        }
+    }
+    if (selected == 1) {
+        return WeightedTaxResult(selected, assignedSeqs, unassignedSeqs, assignedSeqs, selectedPercent);
+    }
+    if (selected == 0) {
+        return WeightedTaxResult(selected, assignedSeqs, unassignedSeqs, 0, selectedPercent);
+    }
+    size_t agree = 0;
+    for (size_t i = 0; i < setTaxa.size(); ++i) {
+        TaxonNode const *node = (setTaxa[i].taxon == 0) ? NULL : t.taxonNode(setTaxa[i].taxon, false);
+        if (node == NULL) {
+            continue;
+        }
+        while (node->parentTaxId != node->taxId) {
+            if (node->taxId == selected) {
+                agree++;
+                break;
+            }
+            node = t.taxonNode(node->parentTaxId, false);
+        }
+    }
+    return WeightedTaxResult(selected, assignedSeqs, unassignedSeqs, agree, selectedPercent);
+}
+
+int main (int, const char**) {
+    const size_t nodeCount = 500000;
+    const size_t queries = 2000;
+    const size_t hitsPerQuery = 1000;
+    const float majorityCutoff = 0.5;
+
+    std::mt19937 rnd(42);
+    std::string prefix = "test_weightedmajoritylca";
+    writeTaxonomy(prefix, nodeCount, rnd);
+    NcbiTaxonomy t(prefix + "_names.dmp", prefix + "_nodes.dmp", prefix + "_merged.dmp");
+
+    // hits of a query are concentrated in a few subtrees
+    std::vector<std::vector<WeightedTaxHit>> sets(queries);
+    for (size_t i = 0; i < queries; i++) {
+        TaxID centers[3] = { (TaxID) (1 + rnd() % nodeCount), (TaxID) (1 + rnd() % nodeCount), (TaxID) (1 + rnd() % nodeCount) };
+        for (size_t j = 0; j < hitsPerQuery; j++) {
+            unsigned int r = rnd() % 100;
+            TaxID taxon;
+            if (r < 2) {
+                taxon = 0;
+            } else if (r < 60) {
+                taxon = std::min((TaxID) nodeCount, centers[0] + (TaxID) (rnd() % 50));
+            } else if (r < 85) {
+                taxon = std::min((TaxID) nodeCount, centers[1] + (TaxID) (rnd() % 50));
+            } else {
+                taxon = (r < 90) ? centers[2] : (TaxID) (1 + rnd() % nodeCount);
+            }
+            sets[i].emplace_back(taxon, (float) (rnd() % 1000) / 10.0f, Parameters::AGG_TAX_SCORE);
+        }
+    }
+
+    Timer timer;
+    std::vector<WeightedTaxResult> reference;
+    reference.reserve(queries);
+    for (size_t i = 0; i < queries; i++) {
+        reference.emplace_back(referenceMajorityLCA(t, sets[i], majorityCutoff));
+    }
+    std::cout << "map based: " << timer.lap() << "\n";
+
+    timer.reset();
+    WeightedLCABuffer buffer(t.maxNodes);
+    std::vector<WeightedTaxResult> results;
+    results.reserve(queries);
+    for (size_t i = 0; i < queries; i++) {
+        results.emplace_back(t.weightedMajorityLCA(sets[i], majorityCutoff, buffer));
+    }
+    std::cout << "node array: " << timer.lap() << "\n";
+
+    int status = EXIT_SUCCESS;
+    for (size_t i = 0; i < queries; i++) {
+        const WeightedTaxResult &a = reference[i];
+        const WeightedTaxResult &b = results[i];
+        if (a.taxon != b.taxon || a.assignedSeqs != b.assignedSeqs || a.unassignedSeqs != b.unassignedSeqs
+            || a.seqsAgreeWithSelectedTaxon != b.seqsAgreeWithSelectedTaxon || std::fabs(a.selectedPercent - b.selectedPercent) > 1e-9) {
+            std::cout << "Query " << i << " differs: " << a.taxon << " " << a.seqsAgreeWithSelectedTaxon << " " << a.selectedPercent
+                      << " vs. " << b.taxon << " " << b.seqsAgreeWithSelectedTaxon << " " << b.selectedPercent << "\n";
+            status = EXIT_FAILURE;
+        }
+    }
+
+    FileUtil::remove((prefix + "_nodes.dmp").c_str());
+    FileUtil::remove((prefix + "_names.dmp").c_str());
+    FileUtil::remove((prefix + "_merged.dmp").c_str());
+    return status;
+}
@@ -0,0 +1,169 @@
+#include "FileUtil.h"
+#include "Parameters.h"
+#include "DBReader.h"
+#include "DBWriter.h"
+#include "Debug.h"
+#include "Util.h"
+
+#include <climits>
+#include <sys/stat.h>
+
+static void checkDisjointKeys(const std::string &db, const std::string &appendDb) {
+    DBReader<unsigned int> reader(db.c_str(), (db + ".index").c_str(), 1, DBReader<unsigned int>::USE_INDEX);
+    reader.open(DBReader<unsigned int>::NOSORT);
+    DBReader<unsigned int> appendReader(appendDb.c_str(), (appendDb + ".index").c_str(), 1, DBReader<unsigned int>::USE_INDEX);
+    appendReader.open(DBReader<unsigned int>::HARDNOSORT);
+    for (size_t i = 0; i < appendReader.getSize(); i++) {
+        const unsigned int key = appendReader.getDbKey(i);
+        if (reader.getId(key) != UINT_MAX) {
+            Debug(Debug::ERROR) << "Key " << key << " of " << appendDb << " already exists in " << db << "\n";
+            EXIT(EXIT_FAILURE);
+        }
+    }
+    appendReader.close();
+    reader.close();
+}
+
+// A DB with several data files (DB.0, DB.1, ...) is read by DBReader as one concatenated data file.
+// Each data file is an immutable segment, the index refers to the global offsets of all segments
+// and is sorted by DBReader when the DB is opened.
+static void appendSegments(const std::string &db, const std::string &appendDb) {
+    std::vector<std::string> segments = FileUtil::findDatafiles(db.c_str());
+    if (segments.size() == 1 && segments[0] == db) {
+        std::string first = db + ".0";
+        FileUtil::move(db.c_str(), first.c_str());
+        segments[0] = first;
+    }
+    size_t dataSize = 0;
+    for (size_t i = 0; i < segments.size(); i++) {
+        dataSize += FileUtil::getFileSize(segments[i]);
+    }
+
+    // a linked index belongs to another DB and must not be modified
+    std::string indexFile = db + ".index";
+    struct stat st;
+    if (lstat(indexFile.c_str(), &st) == 0 && S_ISLNK(st.st_mode)) {
+        std::string indexTmp = indexFile + "_tmp";
+        FileUtil::copyFile(indexFile, indexTmp);
+        FileUtil::remove(indexFile.c_str());
+        FileUtil::move(indexTmp.c_str(), indexFile.c_str());
+    }
+
+    std::vector<std::string> appendSegments = FileUtil::findDatafiles(appendDb.c_str());
+    size_t nextSegment = segments.size();
+    for (size_t i = 0; i < appendSegments.size(); i++) {
+        if (FileUtil::getFileSize(appendSegments[i]) == 0) {
+            continue;
+        }
+        FileUtil::copyFile(appendSegments[i], db + "." + SSTR(nextSegment));
+        nextSegment++;
+    }
+
+    std::string appendIndexFile = appendDb + ".index";
+    DBReader<unsigned int> reader(appendDb.c_str(), appendIndexFile.c_str(), 1, DBReader<unsigned int>::USE_INDEX);
+    reader.open(DBReader<unsigned int>::HARDNOSORT);
+    FILE *index = FileUtil::openFileOrDie(indexFile.c_str(), "a", true);
+    char buffer[1024];
+    for (size_t i = 0; i < reader.getSize(); i++) {
+        DBReader<unsigned int>::Index *idx = reader.getIndex(i);
+        size_t len = DBWriter::indexToBuffer(buffer, idx->id, dataSize + idx->offset, idx->length);
+        size_t written = fwrite(buffer, sizeof(char), len, index);
+        if (written != len) {
+            Debug(Debug::ERROR) << "Cannot write to index file " << indexFile << "\n";
+            EXIT(EXIT_FAILURE);
+        }
+    }
+    if (fclose(index) != 0) {
+        Debug(Debug::ERROR) << "Cannot close index file " << indexFile << "\n";
+        EXIT(EXIT_FAILURE);
+    }
+    reader.close();
+}
+
+// Only the headers of the appended entries are appended, the header DB of appendDB is often a link
+// to the header DB of a larger DB (e.g. written by result2repseq). The subset is written to a temporary DB.
+static std::string extractHeaders(const std::string &hdr, const std::string &appendDb, const std::string &appendHdr) {
+    DBReader<unsigned int> reader(appendDb.c_str(), (appendDb + ".index").c_str(), 1, DBReader<unsigned int>::USE_INDEX);
+    reader.open(DBReader<unsigned int>::HARDNOSORT);
+    DBReader<unsigned int> headers(appendHdr.c_str(), (appendHdr + ".index").c_str(), 1, DBReader<unsigned int>::USE_INDEX|DBReader<unsigned int>::USE_DATA);
+    headers.open(DBReader<unsigned int>::NOSORT);
+
+    std::string outDb = hdr + "_append";
+    std::string outIndex = outDb + ".index";
+    DBWriter writer(outDb.c_str(), outIndex.c_str(), 1, false, Parameters::DBTYPE_OMIT_FILE);
+    writer.open();
+    for (size_t i = 0; i < reader.getSize(); i++) {
+        const unsigned int key = reader.getDbKey(i);
+        const size_t id = headers.getId(key);
+        if (id == UINT_MAX) {
+            Debug(Debug::ERROR) << "Key " << key << " of " << appendDb << " has no header in " << appendHdr << "\n";
+            EXIT(EXIT_FAILURE);
+        }
+        writer.writeData(headers.getDataUncompressed(id), headers.getEntryLen(id), key, 0, false);
+    }
+    writer.close(true);
+    headers.close();
+    reader.close();
+    return outDb;
+}
+
+int appenddb(int argc, const char **argv, const Command &command) {
+    Parameters &par = Parameters::getInstance();
+    par.parseParameters(argc, argv, command, true, 0, 0);
+
+    const int dbtype = FileUtil::parseDbType(par.db1.c_str());
+    const int appendDbtype = FileUtil::parseDbType(par.db2.c_str());
+    if (dbtype != appendDbtype) {
+        Debug(Debug::ERROR) << "Database " << par.db2 << " has type " << Parameters::getDbTypeName(appendDbtype)
+                            << " but " << par.db1 << " has type " << Parameters::getDbTypeName(dbtype) << "\n";
+        EXIT(EXIT_FAILURE);
+    }
+
+    // the header DB is appended together with the DB if both have one, otherwise the caller has to update it
+    const bool appendHeader = FileUtil::fileExists(par.hdr1dbtype.c_str()) && FileUtil::fileExists(par.hdr2dbtype.c_str());
+    if (appendHeader == false) {
+        Debug(Debug::INFO) << "Header DB of " << par.db1 << " or " << par.db2 << " is missing, headers are not appended\n";
+    }
+
+    // keys are checked before anything is modified, DBReader could not resolve a key that exists twice
+    checkDisjointKeys(par.db1, par.db2);
+    std::string appendHdr;
+    if (appendHeader) {
+        appendHdr = extractHeaders(par.hdr1, par.db2, par.hdr2);
+        checkDisjointKeys(par.hdr1, appendHdr);
+    }
+    appendSegments(par.db1, par.db2);
+    if (appendHeader) {
+        appendSegments(par.hdr1, appendHdr);
+        DBReader<unsigned int>::removeDb(appendHdr);
+    }
+    return EXIT_SUCCESS;
+}
+
+int compactdb(int argc, const char **argv, const Command &command) {
+    Parameters &par = Parameters::getInstance();
+    par.parseParameters(argc, argv, command, true, 0, 0);
+
+    DBReader<unsigned int> reader(par.db1.c_str(), par.db1Index.c_str(), 1, DBReader<unsigned int>::USE_INDEX|DBReader<unsigned int>::USE_DATA);
+    reader.open(DBReader<unsigned int>::NOSORT);
+
+    // entries are copied as they are, compressed entries stay compressed
+    std::string outDb = par.db1 + "_compact";
+    std::string outIndex = outDb + ".index";
+    DBWriter writer(outDb.c_str(), outIndex.c_str(), 1, false, Parameters::DBTYPE_OMIT_FILE);
+    writer.open();
+    for (size_t id = 0; id < reader.getSize(); id++) {
+        writer.writeData(reader.getDataUncompressed(id), reader.getEntryLen(id), reader.getDbKey(id), 0, false);
+    }
+    writer.close(true);
+    reader.close();
+
+    std::vector<std::string> segments = FileUtil::findDatafiles(par.db1.c_str());
+    for (size_t i = 0; i < segments.size(); i++) {
+        FileUtil::remove(segments[i].c_str());
+    }
+    FileUtil::remove(par.db1Index.c_str());
+    FileUtil::move(outDb.c_str(), par.db1.c_str());
+    FileUtil::move(outIndex.c_str(), par.db1Index.c_str());
+    return EXIT_SUCCESS;
+}
@@ -4,6 +4,12 @@
 #include "PrefilteringIndexReader.h"
 #include "Prefiltering.h"
 #include "Parameters.h"
+#include "NcbiTaxonomy.h"
+#include "MappingReader.h"
+
+#include <climits>
+#include <functional>
+#include <map>
 
 #ifdef OPENMP
 #include <omp.h>
@@ -36,9 +42,69 @@ std::string findIncompatibleParameter(DBReader<unsigned int>& index, const Param
         return "seedScoringMatrixFile";
     if (par.spacedKmerPattern != PrefilteringIndexReader::getSpacedPattern(&index))
         return "spacedKmerPattern";
+    if (par.indexTaxRank != PrefilteringIndexReader::getCladeRank(&index))
+        return "indexTaxRank";
     return "";
 }
 
+// Assign each sequence to the clade of its taxon at the given rank. The most frequent clades get their own
+// clade id, sequences of the remaining clades and sequences without a taxon at this rank share clade 0.
+// Returns the TaxIDs of the clades.
+std::vector<int> assignClades(DBReader<unsigned int> &dbr, const std::string &db, const std::string &rank, std::vector<unsigned char> &clades) {
+    NcbiTaxonomy *taxonomy = NcbiTaxonomy::openTaxonomy(db);
+    MappingReader mapping(db);
+
+    // memorize the clade of every visited taxon, -1 if it was not visited yet
+    std::vector<TaxID> cladeOfTaxon(taxonomy->maxTaxID + 1, -1);
+    std::vector<TaxID> seqTaxa(dbr.getSize());
+    std::map<TaxID, size_t> counts;
+    for (size_t i = 0; i < dbr.getSize(); i++) {
+        TaxID taxon = mapping.lookup(dbr.getDbKey(i));
+        TaxID clade = 0;
+        if (taxon > 0 && taxon <= taxonomy->maxTaxID && cladeOfTaxon[taxon] != -1) {
+            clade = cladeOfTaxon[taxon];
+        } else if (taxon > 0 && taxon <= taxonomy->maxTaxID) {
+            const TaxonNode *node = taxonomy->taxonNode(taxon, false);
+            while (node != NULL) {
+                if (rank == taxonomy->getString(node->rankIdx)) {
+                    clade = node->taxId;
+                    break;
+                }
+                if (node->parentTaxId == node->taxId) {
+                    break;
+                }
+                node = taxonomy->taxonNode(node->parentTaxId, false);
+            }
+            cladeOfTaxon[taxon] = clade;
+        }
+        seqTaxa[i] = clade;
+        if (clade != 0) {
+            counts[clade]++;
+        }
+    }
+    delete taxonomy;
+
+    std::vector<std::pair<size_t, TaxID>> bySize;
+    for (std::map<TaxID, size_t>::const_iterator it = counts.begin(); it != counts.end(); ++it) {
+        bySize.emplace_back(it->second, it->first);
+    }
+    std::sort(bySize.begin(), bySize.end(), std::greater<std::pair<size_t, TaxID>>());
+    std::vector<int> cladeTaxa(1, 0);
+    std::map<TaxID, unsigned char> cladeIds;
+    for (size_t i = 0; i < bySize.size() && cladeTaxa.size() < UCHAR_MAX + 1; i++) {
+        cladeIds[bySize[i].second] = cladeTaxa.size();
+        cladeTaxa.push_back(bySize[i].second);
+    }
+
+    clades.resize(dbr.getSize());
+    for (size_t i = 0; i < dbr.getSize(); i++) {
+        std::map<TaxID, unsigned char>::const_iterator it = cladeIds.find(seqTaxa[i]);
+        clades[i] = (it == cladeIds.end()) ? 0 : it->second;
+    }
+    Debug(Debug::INFO) << "Grouped k-mer lists into " << cladeTaxa.size() << " clades at rank " << rank << "\n";
+    return cladeTaxa;
+}
+
 int indexdb(int argc, const char **argv, const Command &command) {
     Parameters &par = Parameters::getInstance();
     setIndexDbDefaults(&par);
@@ -57,6 +123,7 @@ int indexdb(int argc, const char **argv, const Command &command) {
 
     DBReader<unsigned int> dbr(par.db1.c_str(), par.db1Index.c_str(), par.threads, DBReader<unsigned int>::USE_INDEX|DBReader<unsigned int>::USE_DATA);
     dbr.open(DBReader<unsigned int>::NOSORT);
+    const std::string taxDB = par.db1;
 
     // remove par.indexDbsuffix from db1
     std::string seqDb = par.db1 + "_seq";
@@ -179,11 +246,27 @@ int indexdb(int argc, const char **argv, const Command &command) {
             alndbr->open(DBReader<unsigned int>::NOSORT);
         }
 
+        std::vector<int> cladeTaxa;
+        std::vector<unsigned char> clades;
+        if (par.indexTaxRank != "" && noKmerIndex == false) {
+            if (NcbiTaxonomy::findRankIndex(par.indexTaxRank) == -1) {
+                Debug(Debug::ERROR) << "Invalid taxonomic rank " << par.indexTaxRank << " given for --index-tax-rank\n";
+                EXIT(EXIT_FAILURE);
+            }
+            if (FileUtil::fileExists((taxDB + "_mapping").c_str())) {
+                cladeTaxa = assignClades(dbr, taxDB, par.indexTaxRank, clades);
+            } else {
+                // e.g. the translated ORFs of a nucleotide database have no taxonomy mapping
+                Debug(Debug::WARNING) << taxDB << " has no taxonomy mapping. The k-mer lists will not be grouped by clade.\n";
+            }
+        }
+
         DBReader<unsigned int>::removeDb(indexDB);
         PrefilteringIndexReader::createIndexFile(indexDB, &dbr, dbr2, hdbr1, hdbr2, alndbr, seedSubMat, par.maxSeqLen,
                                                  par.spacedKmer, par.spacedKmerPattern, par.compBiasCorrection,
                                                  seedSubMat->alphabetSize, par.kmerSize, par.maskMode, par.maskLowerCaseMode,
-                                                 par.maskProb, par.maskNrepeats,kmerScore, par.targetSearchMode, par.split, par.indexSubset);
+                                                 par.maskProb, par.maskNrepeats,kmerScore, par.targetSearchMode, par.split, par.indexSubset,
+                                                 par.indexTaxRank, cladeTaxa, clades.empty() ? NULL : clades.data());
 
         if (alndbr != NULL) {
             alndbr->close();
@@ -6,24 +6,18 @@
 #include "NcbiTaxonomy.h"
 #include "FastSort.h"
 #include "MemoryMapped.h"
-#include "GzReader.h"
+#include "AccessionTaxonMapping.h"
+
+#include <unordered_map>
 
 #ifdef OPENMP
 #include <omp.h>
 #endif
 
-static bool compareToFirstString(const std::pair<std::string, TaxID>& lhs, const std::pair<std::string, TaxID>& rhs){
-    return (lhs.first <= rhs.first);
-}
-
 static bool sortMappingByDbKey(const std::pair<unsigned int, TaxID>& lhs, const std::pair<unsigned int, TaxID>& rhs){
     return (lhs.first <= rhs.first);
 }
 
-static bool sortByFirstString(const std::pair<std::string, TaxID>& lhs, const std::pair<std::string, TaxID>& rhs){
-    return (lhs.first < rhs.first);
-}
-
 struct SortByName {
     SortByName(NcbiTaxonomy* taxonomy) : taxonomy(taxonomy) {}
     bool operator() (const TaxonNode& lhs, const TaxonNode& rhs) const {
@@ -32,18 +26,94 @@ struct SortByName {
     const NcbiTaxonomy* taxonomy;
 };
 
-TaxID lookupTaxID(const std::vector<std::pair<std::string, TaxID>>& mapping, const std::string& value) {
-    std::pair<std::string, TaxID> val;
-    val.first = value;
-    std::vector<std::pair<std::string, TaxID>>::const_iterator mappingIt
-        = std::upper_bound(mapping.begin(), mapping.end(), val, compareToFirstString);
-    if (mappingIt == mapping.end() || mappingIt->first != val.first) {
-        return 0;
-    } else {
-        return mappingIt->second;
+// Parses the entries of an NR header, which are separated by \1.
+// visitor.accession gets the accession of each entry without its version and returns if it could be resolved.
+// Otherwise visitor.species gets the species name of the entry, if there is one.
+template <typename Visitor>
+static void parseHeader(const char *data, Visitor &visitor) {
+    const char *start = data;
+    bool isInAccession = true;
+    const char *startName = NULL;
+    const char *endName = NULL;
+    bool isInSpeciesName = false;
+    bool needSpeciesName = false;
+    bool done = false;
+    while (done == false) {
+        switch (*data) {
+            case '\n':
+                // FALLTHROUGH
+            case '\0':
+                done = true;
+                // FALLTHROUGH
+            case '\1':
+                if (needSpeciesName == true && isInSpeciesName == true) {
+                    visitor.species(startName, endName - startName);
+                }
+                start = ++data;
+                isInAccession = true;
+                needSpeciesName = false;
+                isInSpeciesName = false;
+                break;
+            case '[':
+                // take last bracket with space before instead of first
+                // takes care of protein names with brackets
+                if (*(data - 1) == ' ') {
+                    startName = ++data;
+                    endName = data;
+                    isInSpeciesName = true;
+                }
+                break;
+            case ']':
+                endName = data;
+                break;
+            // strip NR accession version
+            case '.':
+                // FALLTHROUGH
+            case ' ':
+                if (isInAccession) {
+                    needSpeciesName = (visitor.accession(start, data - start) == false);
+                    isInAccession = false;
+                }
+                break;
+        }
+        ++data;
     }
 }
 
+// collects the accessions that are looked up in the second pass
+struct CollectAccessions {
+    CollectAccessions(AccessionTaxonMapping &accessions) : accessions(accessions) {}
+    bool accession(const char *start, size_t length) {
+        accessions.insert(start, length);
+        return true;
+    }
+    void species(const char *, size_t) {}
+    AccessionTaxonMapping &accessions;
+};
+
+struct LookupTaxa {
+    LookupTaxa(const AccessionTaxonMapping &accessions, const std::unordered_map<std::string, TaxID> &uniqueNames, std::vector<TaxID> &taxa)
+        : accessions(accessions), uniqueNames(uniqueNames), taxa(taxa) {}
+    bool accession(const char *start, size_t length) {
+        unsigned int id = accessions.find(start, length);
+        TaxID taxID = (id == AccessionTaxonMapping::NOT_FOUND) ? 0 : accessions.getTaxon(id);
+        if (taxID != 0) {
+            taxa.emplace_back(taxID);
+            return true;
+        }
+        return false;
+    }
+    void species(const char *start, size_t length) {
+        std::unordered_map<std::string, TaxID>::const_iterator it = uniqueNames.find(std::string(start, length));
+        if (it != uniqueNames.end()) {
+            taxa.emplace_back(it->second);
+        }
+    }
+    const AccessionTaxonMapping &accessions;
+    const std::unordered_map<std::string, TaxID> &uniqueNames;
+    std::vector<TaxID> &taxa;
+};
+
 int nrtotaxmapping(int argc, const char **argv, const Command& command) {
     Parameters &par = Parameters::getInstance();
     par.parseParameters(argc, argv, command, true, 0, 0);
@@ -59,29 +129,19 @@ int nrtotaxmapping(int argc, const char **argv, const Command& command) {
 
     Debug::Progress progress;
 
-    std::vector<std::pair<std::string, TaxID>> accessionMapping;
-    for (size_t i = 0; i < par.filenames.size(); i++) {
-        GzReader kbIn(par.filenames[i]);
-        if (kbIn.fail()) {
-            Debug(Debug::ERROR) << "File " << par.filenames[i] << " not found\n";
-            EXIT(EXIT_FAILURE);
-        }
+    DBReader<unsigned int> reader(seqHdrData.c_str(), seqHdrIndex.c_str(), par.threads, DBReader<unsigned int>::USE_INDEX | DBReader<unsigned int>::USE_DATA);
+    reader.open(DBReader<unsigned int>::LINEAR_ACCCESS);
+    size_t entries = reader.getSize();
 
-        std::string line;
-        const char *entry[255];
-        while (kbIn.getline(line)) {
-            progress.updateProgress();
-            const size_t columns = Util::getWordsOfLine(line.c_str(), entry, 255);
-            if (columns < 4) {
-                Debug(Debug::ERROR) << "Invalid accession2taxid file " << par.filenames[i] << "\n";
-                EXIT(EXIT_FAILURE);
-            }
-            std::string accession(entry[0], entry[1] - entry[0] - 1);
-            unsigned int taxid = Util::fast_atoi<unsigned int>(entry[2]);
-            accessionMapping.emplace_back(accession, taxid);
-        }
+    // only the accessions occurring in the headers have to be kept from the accession2taxid files
+    AccessionTaxonMapping accessions(entries);
+    CollectAccessions collect(accessions);
+    progress.reset(entries);
+    for (size_t i = 0; i < entries; ++i) {
+        progress.updateProgress();
+        parseHeader(reader.getData(i, 0), collect);
     }
-    SORT_PARALLEL(accessionMapping.begin(), accessionMapping.end(), sortByFirstString);
+    accessions.readMappingFiles(par.filenames, par.threads);
 
     NcbiTaxonomy* taxonomy = NcbiTaxonomy::openTaxonomy(seqDbData);
 
@@ -90,29 +150,25 @@ int nrtotaxmapping(int argc, const char **argv, const Command& command) {
     SORT_PARALLEL(nodesCopy.begin(), nodesCopy.end(), SortByName(taxonomy));
 
     // get a sorted list of taxa that uniquely point to a taxid
-    std::vector<std::pair<std::string, TaxID>> uniqueNames;
+    std::unordered_map<std::string, TaxID> uniqueNames;
     size_t nodesSize = nodesCopy.size();
     if (nodesSize >= 2 && taxonomy->getString(nodesCopy[0].nameIdx) != taxonomy->getString(nodesCopy[1].nameIdx)) {
-        uniqueNames.emplace_back(taxonomy->getString(nodesCopy[0].nameIdx), nodesCopy[0].taxId);
+        uniqueNames.emplace(taxonomy->getString(nodesCopy[0].nameIdx), nodesCopy[0].taxId);
     }
     for (size_t i = 1; i < (nodesSize - 1); ++i) {
         if ((taxonomy->getString(nodesCopy[i - 1].nameIdx) != taxonomy->getString(nodesCopy[i].nameIdx)) && (taxonomy->getString(nodesCopy[i].nameIdx) != taxonomy->getString(nodesCopy[i + 1].nameIdx))) {
-            uniqueNames.emplace_back(taxonomy->getString(nodesCopy[i].nameIdx), nodesCopy[i].taxId);
+            uniqueNames.emplace(taxonomy->getString(nodesCopy[i].nameIdx), nodesCopy[i].taxId);
         }
     }
     if (nodesSize > 2 && (taxonomy->getString(nodesCopy[nodesSize - 1].nameIdx) != taxonomy->getString(nodesCopy[nodesSize - 2].nameIdx))) {
-        uniqueNames.emplace_back(taxonomy->getString(nodesCopy[nodesSize - 1].nameIdx), nodesCopy[nodesSize - 1].taxId);
+        uniqueNames.emplace(taxonomy->getString(nodesCopy[nodesSize - 1].nameIdx), nodesCopy[nodesSize - 1].taxId);
     }
     nodesCopy.clear();
 
-    DBReader<unsigned int> reader(seqHdrData.c_str(), seqHdrIndex.c_str(), par.threads, DBReader<unsigned int>::USE_INDEX | DBReader<unsigned int>::USE_DATA);
-    reader.open(DBReader<unsigned int>::LINEAR_ACCCESS);
-
     DBWriter writer(resultDbData.c_str(), resultDbIndex.c_str(), par.threads, false, Parameters::DBTYPE_OMIT_FILE);
     writer.open();
 
     size_t processed = 0;
-    size_t entries = reader.getSize();
     progress.reset(entries);
 #pragma omp parallel
     {
@@ -123,6 +179,7 @@ int nrtotaxmapping(int argc, const char **argv, const Command& command) {
 
         std::vector<TaxID> taxa;
         taxa.reserve(64);
+        LookupTaxa lookup(accessions, uniqueNames, taxa);
 
         std::string result;
 
@@ -131,65 +188,8 @@ int nrtotaxmapping(int argc, const char **argv, const Command& command) {
             progress.updateProgress();
 
             unsigned int key = reader.getDbKey(i);
-            char* data = reader.getData(i, thread_idx);
 
-            char* start = data;
-            bool isInAccession = true;
-            char* startName = NULL;
-            char* endName = NULL;
-            bool isInSpeciesName = false;
-            bool needSpeciesName = false;
-            bool done = false;
-            while (done == false) {
-                switch (*data) {
-                    case '\n':
-                        // FALLTHROUGH
-                    case '\0':
-                        done = true;
-                        // FALLTHROUGH
-                    case '\1':
-                        if (needSpeciesName == true && isInSpeciesName == true) {
-                            std::string species(startName, endName - startName);
-                            TaxID taxID = lookupTaxID(uniqueNames, species);
-                            if (taxID != 0) {
-                                taxa.emplace_back(taxID);
-                            }
-                        }
-                        start = ++data;
-                        isInAccession = true;
-                        needSpeciesName = false;
-                        isInSpeciesName = false;
-                        break;
-                    case '[':
-                        // take last bracket with space before instead of first
-                        // takes care of protein names with brackets
-                        if (*(data - 1) == ' ') {
-                            startName = ++data;
-                            endName = data;
-                            isInSpeciesName = true;
-                        }
-                        break;
-                    case ']':
-                        endName = data;
-                        break;
-                    // strip NR accession version
-                    case '.':
-                        // FALLTHROUGH
-                    case ' ':
-                        if (isInAccession) {
-                            std::string accession(start, data - start);
-                            TaxID taxID = lookupTaxID(accessionMapping, accession);
-                            if (taxID != 0) {
-                                taxa.emplace_back(taxID);
-                            } else {
-                                needSpeciesName = true;
-                            }
-                            isInAccession = false;
-                        }
-                        break;
-                }
-                ++data;
-            }
+            parseHeader(reader.getData(i, thread_idx), lookup);
 
             const TaxonNode* node = taxonomy->LCA(taxa);
             if (node != NULL) {
@@ -208,7 +208,6 @@ int nrtotaxmapping(int argc, const char **argv, const Command& command) {
     FileUtil::remove(resultDbIndex.c_str());
     reader.close();
     uniqueNames.clear();
-    accessionMapping.clear();
     delete taxonomy;
 
     // rewrite mapping to be sorted to avoid future on-the-fly sorting
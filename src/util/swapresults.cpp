@@ -6,15 +6,64 @@
 #include "Util.h"
 #include "QueryMatcher.h"
 #include "Parameters.h"
-#include "AlignmentSymmetry.h"
 #include "PrefilteringIndexReader.h"
 #include "IndexReader.h"
 #include "FastSort.h"
+#include "FileUtil.h"
 
 #ifdef OPENMP
 #include <omp.h>
 #endif
 
+// swapped result line as it is stored in the partitions, followed by length bytes of text
+struct SwapRecord {
+    unsigned int key;
+    unsigned int length;
+    double eval;
+    int score;
+    unsigned int dbLen;
+    unsigned int dbKey;
+
+    // same order as Matcher::compareHits
+    static bool compareHits(const std::pair<SwapRecord, const char *> &first, const std::pair<SwapRecord, const char *> &second) {
+        if (first.first.eval != second.first.eval) {
+            return first.first.eval < second.first.eval;
+        }
+        if (first.first.score != second.first.score) {
+            return first.first.score > second.first.score;
+        }
+        if (first.first.dbLen != second.first.dbLen) {
+            return first.first.dbLen < second.first.dbLen;
+        }
+        return first.first.dbKey < second.first.dbKey;
+    }
+};
+
+// all threads append their buffers of swapped records to one file per partition,
+// the offsets of the appended blocks are kept so that the partition can be read back in parallel
+struct SpillFile {
+    FILE *file;
+    size_t size;
+    std::vector<std::pair<size_t, size_t>> blocks;
+};
+
+static void writeSpill(SpillFile &spill, std::string &buffer) {
+    if (buffer.empty()) {
+        return;
+    }
+#pragma omp critical(swapresults_spill)
+    {
+        size_t written = fwrite(buffer.c_str(), sizeof(char), buffer.size(), spill.file);
+        if (written != buffer.size()) {
+            Debug(Debug::ERROR) << "Cannot write to spill file\n";
+            EXIT(EXIT_FAILURE);
+        }
+        spill.blocks.emplace_back(spill.size, buffer.size());
+        spill.size += buffer.size();
+    }
+    buffer.clear();
+}
+
 int doswap(Parameters& par, bool isGeneralMode) {
     const char * parResultDb;
     const char * parResultDbIndex;
@@ -133,6 +182,7 @@ int doswap(Parameters& par, bool isGeneralMode) {
                     size_t lineLen = nextLine - data;
                     lineLen -= targetKeyLen;
                     lineLen += queryKeyLen;
+                    lineLen += sizeof(SwapRecord) + sizeof(char *);
                     __sync_fetch_and_add(&(targetElementSize[dbKey]), lineLen);
                     data = nextLine;
                 }
@@ -158,81 +208,197 @@ int doswap(Parameters& par, bool isGeneralMode) {
         }
     }
     splits.push_back(std::make_pair(maxTargetId, bytesToWrite));
-    AlignmentSymmetry::computeOffsetFromCounts(targetElementSize, maxTargetId + 1);
+    delete[] targetElementSize;
 
-    const char empty = '\0';
+    bool isAlignmentResult = false;
+    bool hasBacktrace = false;
+    const char *entry[255];
+    for (size_t i = 0; i < resultDbr.getSize(); i++){
+        char *data = resultDbr.getData(i, 0);
+        if (*data == '\0'){
+            continue;
+        }
+        const size_t columns = Util::getWordsOfLine(data, entry, 255);
+        isAlignmentResult = columns >= Matcher::ALN_RES_WITHOUT_BT_COL_CNT;
+        hasBacktrace = columns >= Matcher::ALN_RES_WITH_BT_COL_CNT;
+        break;
+    }
 
-    unsigned int prevDbKeyToWrite = 0;
-    size_t prevBytesToWrite = 0;
-    for (size_t split = 0; split < splits.size(); split++) {
-        unsigned int dbKeyToWrite = splits[split].first;
-        size_t bytesToWrite = splits[split].second;
-        char *tmpData = new(std::nothrow) char[bytesToWrite];
-        Util::checkAllocation(tmpData, "Cannot allocate tmpData memory");
-        Debug(Debug::INFO) << "\nReading results.\n";
+    // every result line is swapped once and appended to the partition of its target key,
+    // partitions are kept in memory if there is only one, otherwise they are spilled to disk
+    const bool spill = splits.size() > 1;
+    const size_t spillBufferSize = 64 * 1024;
+    std::vector<std::string> partitions(splits.size() * par.threads);
+    std::vector<SpillFile> spillFiles(spill ? splits.size() : 0);
+    for (size_t i = 0; i < spillFiles.size(); i++) {
+        // the spill file is unlinked right away, it is only reachable through the open handle and does not outlive the process
+        std::string spillName = parOutDbStr + "_spill_" + SSTR(i);
+        spillFiles[i].file = FileUtil::openAndDelete(spillName.c_str(), "w+");
+        FileUtil::remove(spillName.c_str());
+        spillFiles[i].size = 0;
+    }
+    Debug(Debug::INFO) << "Reading results.\n";
+    {
         Debug::Progress progress(resultSize);
 #pragma omp parallel
         {
-            int thread_idx = 0;
+            unsigned int thread_idx = 0;
 #ifdef OPENMP
-            thread_idx = omp_get_thread_num();
+            thread_idx = (unsigned int) omp_get_thread_num();
 #endif
+            char buffer[1024 + 32768*4];
+            char dbKeyBuffer[255 + 1];
 
 #pragma omp for schedule(dynamic, 10)
             for (size_t i = 0; i < resultSize; ++i) {
                 progress.updateProgress();
                 char *data = resultDbr.getData(i, thread_idx);
-                unsigned int queryKey = resultDbr.getDbKey(i);
-                char queryKeyStr[1024];
-                char *tmpBuff = Itoa::u32toa_sse2((uint32_t) queryKey, queryKeyStr);
-                *(tmpBuff) = '\0';
-                size_t queryKeyLen = strlen(queryKeyStr);
-                char dbKeyBuffer[255 + 1];
+                const unsigned int queryKey = resultDbr.getDbKey(i);
                 while (*data != '\0') {
-                    Util::parseKey(data, dbKeyBuffer);
-                    size_t targetKeyLen = strlen(dbKeyBuffer);
                     char *nextLine = Util::skipLine(data);
-                    size_t oldLineLen = nextLine - data;
-                    size_t newLineLen = oldLineLen;
-                    newLineLen -= targetKeyLen;
-                    newLineLen += queryKeyLen;
-                    const unsigned int dbKey = (unsigned int) strtoul(dbKeyBuffer, NULL, 10);
-                    // update offset but do not copy memory
-                    size_t offset = __sync_fetch_and_add(&(targetElementSize[dbKey]), newLineLen) - prevBytesToWrite;
-                    if(dbKey >= prevDbKeyToWrite && dbKey <=  dbKeyToWrite){
-                        memcpy(&tmpData[offset], queryKeyStr, queryKeyLen);
-                        memcpy(&tmpData[offset + queryKeyLen], data + targetKeyLen, oldLineLen - targetKeyLen);
+                    SwapRecord record;
+                    if (isGeneralMode) {
+                        // the query key replaces the target key, the rest of the line is kept as it is
+                        Util::parseKey(data, dbKeyBuffer);
+                        size_t targetKeyLen = strlen(dbKeyBuffer);
+                        record.key = (unsigned int) strtoul(dbKeyBuffer, NULL, 10);
+                        size_t queryKeyLen = Itoa::u32toa_sse2((uint32_t) queryKey, buffer) - buffer - 1;
+                        record.length = queryKeyLen + (nextLine - data - targetKeyLen);
+                        record.eval = 0.0;
+                        record.score = 0;
+                        record.dbLen = 0;
+                        record.dbKey = queryKey;
+                        const size_t partition = std::lower_bound(splits.begin(), splits.end(), std::make_pair(record.key, (size_t) 0)) - splits.begin();
+                        std::string &out = partitions[partition * par.threads + thread_idx];
+                        out.append(reinterpret_cast<const char *>(&record), sizeof(SwapRecord));
+                        out.append(buffer, queryKeyLen);
+                        out.append(data + targetKeyLen, nextLine - data - targetKeyLen);
+                        if (spill && out.size() > spillBufferSize) {
+                            writeSpill(spillFiles[partition], out);
+                        }
+                        data = nextLine;
+                        continue;
+                    } else if (isAlignmentResult) {
+                        Matcher::result_t res = Matcher::parseAlignmentRecord(data, true);
+                        record.key = res.dbKey;
+                        res.dbKey = queryKey;
+                        Matcher::result_t::swapResult(res, *evaluer, hasBacktrace);
+                        if (res.eval > par.evalThr) {
+                            // an empty entry is written for targets with only filtered hits
+                            targetElementExists[record.key] = 1;
+                            data = nextLine;
+                            continue;
+                        }
+                        record.length = Matcher::resultToBuffer(buffer, res, hasBacktrace, false);
+                        record.eval = res.eval;
+                        record.score = res.score;
+                        record.dbLen = res.dbLen;
+                        record.dbKey = res.dbKey;
+                    } else {
+                        hit_t hit = QueryMatcher::parsePrefilterHit(data);
+                        record.key = hit.seqId;
+                        hit.seqId = queryKey;
+                        hit.diagonal = static_cast<unsigned short>(static_cast<short>(hit.diagonal) * -1);
+                        record.length = QueryMatcher::prefilterHitToBuffer(buffer, hit);
+                        record.eval = -static_cast<float>(hit.prefScore);
+                        record.score = hit.prefScore;
+                        record.dbLen = 0;
+                        record.dbKey = hit.seqId;
+                    }
+
+                    const size_t partition = std::lower_bound(splits.begin(), splits.end(), std::make_pair(record.key, (size_t) 0)) - splits.begin();
+                    std::string &out = partitions[partition * par.threads + thread_idx];
+                    out.append(reinterpret_cast<const char *>(&record), sizeof(SwapRecord));
+                    out.append(buffer, record.length);
+                    if (spill && out.size() > spillBufferSize) {
+                        writeSpill(spillFiles[partition], out);
                     }
                     data = nextLine;
                 }
             }
         }
-        //revert offsets
-        for (unsigned int i = maxTargetId + 1; i > 0; i--) {
-            targetElementSize[i] = targetElementSize[i - 1];
+    }
+    if (spill) {
+        for (size_t i = 0; i < partitions.size(); i++) {
+            writeSpill(spillFiles[i / par.threads], partitions[i]);
+            std::string().swap(partitions[i]);
         }
-        targetElementSize[0] = 0;
+        for (size_t i = 0; i < spillFiles.size(); i++) {
+            if (fflush(spillFiles[i].file) != 0) {
+                Debug(Debug::ERROR) << "Cannot write to spill file of " << parOutDbStr << "\n";
+                EXIT(EXIT_FAILURE);
+            }
+        }
+    }
+    resultDbr.close();
 
-        Debug(Debug::INFO) << "\nOutput database: " << parOutDbStr << "\n";
-        bool isAlignmentResult = false;
-        bool hasBacktrace = false;
-        const char *entry[255];
-        for (size_t i = 0; i < resultDbr.getSize(); i++){
-            char *data = resultDbr.getData(i, 0);
-            if (*data == '\0'){
-                continue;
+    const char empty = '\0';
+    unsigned int prevDbKeyToWrite = 0;
+    for (size_t split = 0; split < splits.size(); split++) {
+        unsigned int dbKeyToWrite = splits[split].first;
+
+        // the records of this partition, either in memory or mapped from its spill file
+        std::vector<std::pair<char *, size_t>> chunks;
+        char *spillData = NULL;
+        size_t spillSize = 0;
+        if (spill == false) {
+            for (size_t thread = 0; thread < (size_t) par.threads; thread++) {
+                std::string &partition = partitions[split * par.threads + thread];
+                if (partition.empty() == false) {
+                    chunks.emplace_back(&partition[0], partition.size());
+                }
+            }
+        } else if (spillFiles[split].size > 0) {
+            spillData = static_cast<char *>(FileUtil::mmapFile(spillFiles[split].file, &spillSize));
+            const std::vector<std::pair<size_t, size_t>> &blocks = spillFiles[split].blocks;
+            for (size_t i = 0; i < blocks.size(); i++) {
+                chunks.emplace_back(spillData + blocks[i].first, blocks[i].second);
+            }
+        }
+
+        // count records per target and assign each record its slot
+        const size_t keyCount = dbKeyToWrite - prevDbKeyToWrite + 1;
+        size_t *keyOffsets = new size_t[keyCount + 1];
+        memset(keyOffsets, 0, sizeof(size_t) * (keyCount + 1));
+#pragma omp parallel for schedule(dynamic, 1)
+        for (size_t i = 0; i < chunks.size(); i++) {
+            char *data = chunks[i].first;
+            char *end = data + chunks[i].second;
+            while (data < end) {
+                SwapRecord record;
+                memcpy(&record, data, sizeof(SwapRecord));
+                __sync_fetch_and_add(&(keyOffsets[record.key - prevDbKeyToWrite + 1]), 1);
+                data += sizeof(SwapRecord) + record.length;
+            }
+        }
+        for (size_t i = 0; i < keyCount; i++) {
+            keyOffsets[i + 1] += keyOffsets[i];
+        }
+        const size_t recordCount = keyOffsets[keyCount];
+        char **records = new(std::nothrow) char*[recordCount];
+        Util::checkAllocation(records, "Cannot allocate records memory");
+        size_t *keyFill = new size_t[keyCount];
+        memcpy(keyFill, keyOffsets, sizeof(size_t) * keyCount);
+#pragma omp parallel for schedule(dynamic, 1)
+        for (size_t i = 0; i < chunks.size(); i++) {
+            char *data = chunks[i].first;
+            char *end = data + chunks[i].second;
+            while (data < end) {
+                SwapRecord record;
+                memcpy(&record, data, sizeof(SwapRecord));
+                size_t slot = __sync_fetch_and_add(&(keyFill[record.key - prevDbKeyToWrite]), 1);
+                records[slot] = data;
+                data += sizeof(SwapRecord) + record.length;
             }
-            const size_t columns = Util::getWordsOfLine(data, entry, 255);
-            isAlignmentResult = columns >= Matcher::ALN_RES_WITHOUT_BT_COL_CNT;
-            hasBacktrace = columns >= Matcher::ALN_RES_WITH_BT_COL_CNT;
-            break;
         }
+        delete[] keyFill;
 
+        Debug(Debug::INFO) << "\nOutput database: " << parOutDbStr << "\n";
         std::string splitDbw = parOutDbStr + "_" + SSTR(split);
         std::pair<std::string, std::string> splitNamePair = (splits.size() > 1) ? std::make_pair(splitDbw, splitDbw + ".index") :
                                                             std::make_pair(parOutDb, parOutDbIndex) ;
         splitFileNames.push_back(splitNamePair);
-        Debug::Progress progress2(dbKeyToWrite - prevDbKeyToWrite  + 1);
+        Debug::Progress progress2(keyCount);
 
         DBWriter resultWriter(splitNamePair.first.c_str(), splitNamePair.second.c_str(), par.threads, par.compressed, resultDbr.getDbtype());
         resultWriter.open();
@@ -242,77 +408,33 @@ int doswap(Parameters& par, bool isGeneralMode) {
 #ifdef OPENMP
             thread_idx = (unsigned int) omp_get_thread_num();
 #endif
-            // we are reusing this vector also for the prefiltering results
-            // qcov is used for pScore because its the first float value
-            // and alnLength for diagonal because its the first int value after
-            std::vector<Matcher::result_t> curRes;
+            std::vector<std::pair<SwapRecord, const char *>> curRes;
             curRes.reserve(300);
-
-            char buffer[1024 + 32768*4];
             std::string ss;
             ss.reserve(100000);
 
 #pragma omp for schedule(dynamic, 100)
-            for (size_t i = prevDbKeyToWrite; i <= dbKeyToWrite; ++i) {
+            for (size_t i = 0; i < keyCount; ++i) {
                 progress2.updateProgress();
-
-                char *data = &tmpData[targetElementSize[i] - prevBytesToWrite];
-                size_t dataSize = targetElementSize[i + 1] - targetElementSize[i];
-
-                if (isGeneralMode) {
-                    if (dataSize > 0) {
-                        resultWriter.writeData(data, dataSize, i, thread_idx);
-                    }
-                    continue;
-                }
-
-                bool evalBreak = false;
-                while (dataSize > 0) {
-                    if (isAlignmentResult) {
-                        Matcher::result_t res = Matcher::parseAlignmentRecord(data, true);
-                        Matcher::result_t::swapResult(res, *evaluer, hasBacktrace);
-                        if (res.eval > par.evalThr) {
-                            evalBreak = true;
-                        } else {
-                            curRes.emplace_back(res);
-			}
-                    } else {
-                        hit_t hit = QueryMatcher::parsePrefilterHit(data);
-                        hit.diagonal = static_cast<unsigned short>(static_cast<short>(hit.diagonal) * -1);
-                        curRes.emplace_back(hit.seqId, hit.prefScore, 0, 0, 0, -static_cast<float>(hit.prefScore), hit.diagonal, 0, 0, 0, 0, 0, 0, "");
-                    }
-                    char *nextLine = Util::skipLine(data);
-                    size_t lineLen = nextLine - data;
-                    dataSize -= lineLen;
-                    data = nextLine;
+                const unsigned int key = prevDbKeyToWrite + i;
+                for (size_t j = keyOffsets[i]; j < keyOffsets[i + 1]; j++) {
+                    SwapRecord record;
+                    memcpy(&record, records[j], sizeof(SwapRecord));
+                    curRes.emplace_back(record, records[j] + sizeof(SwapRecord));
                 }
 
                 if (curRes.empty() == false) {
-                    if (curRes.size() > 1) {
-                        SORT_SERIAL(curRes.begin(), curRes.end(), Matcher::compareHits);
+                    if (isGeneralMode == false && curRes.size() > 1) {
+                        SORT_SERIAL(curRes.begin(), curRes.end(), SwapRecord::compareHits);
                     }
-
                     for (size_t j = 0; j < curRes.size(); j++) {
-                        const Matcher::result_t &res = curRes[j];
-                        if (isAlignmentResult) {
-                            size_t len = Matcher::resultToBuffer(buffer, res, hasBacktrace, false);
-                            ss.append(buffer, len);
-                        } else {
-                            hit_t hit;
-                            hit.seqId = res.dbKey;
-                            hit.prefScore = res.score;
-                            hit.diagonal = res.alnLength;
-                            size_t len = QueryMatcher::prefilterHitToBuffer(buffer, hit);
-                            ss.append(buffer, len);
-                        }
+                        ss.append(curRes[j].second, curRes[j].first.length);
                     }
-
-                    resultWriter.writeData(ss.c_str(), ss.size(), i, thread_idx);
+                    resultWriter.writeData(ss.c_str(), ss.size(), key, thread_idx);
                     ss.clear();
-
                     curRes.clear();
-                } else if (evalBreak == true || targetElementExists[i] == 1) {
-                    resultWriter.writeData(&empty, 0, i, thread_idx);
+                } else if (isGeneralMode == false && targetElementExists[key] == 1) {
+                    resultWriter.writeData(&empty, 0, key, thread_idx);
                 }
             }
         };
@@ -323,9 +445,22 @@ int doswap(Parameters& par, bool isGeneralMode) {
             resultWriter.close();
         }
 
+        delete[] records;
+        delete[] keyOffsets;
+        if (spill) {
+            if (spillData != NULL) {
+                FileUtil::munmapData(spillData, spillSize);
+            }
+            if (fclose(spillFiles[split].file) != 0) {
+                Debug(Debug::ERROR) << "Cannot close spill file of " << parOutDbStr << "\n";
+                EXIT(EXIT_FAILURE);
+            }
+        } else {
+            for (size_t thread = 0; thread < (size_t) par.threads; thread++) {
+                std::string().swap(partitions[split * par.threads + thread]);
+            }
+        }
         prevDbKeyToWrite = dbKeyToWrite + 1;
-        prevBytesToWrite += bytesToWrite;
-        delete[] tmpData;
     }
     if(splits.size() > 1){
         DBWriter::mergeResults(parOutDbStr, parOutDbIndexStr, splitFileNames);
@@ -339,11 +474,9 @@ int doswap(Parameters& par, bool isGeneralMode) {
         delete subMat;
     }
 
-    resultDbr.close();
     if (targetElementExists != NULL) {
         delete[] targetElementExists;
     }
-    delete[] targetElementSize;
     return EXIT_SUCCESS;
 }
 
@@ -52,6 +52,7 @@ int clusterupdate(int argc, const char **argv, const Command& command) {
     CommandCaller cmd;
     cmd.addVariable("REMOVE_TMP", par.removeTmpFiles ? "TRUE" : NULL);
     cmd.addVariable("RECOVER_DELETED", par.recoverDeleted ? "TRUE" : NULL);
+    cmd.addVariable("KEEP_REP_INDEX", par.keepRepIndex ? "TRUE" : NULL);
 
     cmd.addVariable("RUNNER", par.runner.c_str());
     cmd.addVariable("DIFF_PAR", par.createParameterString(par.diff).c_str());
@@ -64,6 +65,10 @@ int clusterupdate(int argc, const char **argv, const Command& command) {
 
     cmd.addVariable("THREADS_PAR", par.createParameterString(par.onlythreads).c_str());
     cmd.addVariable("RESULT2REPSEQ_PAR", par.createParameterString(par.result2repseq).c_str());
+    int indexSubset = par.indexSubset;
+    par.indexSubset = Parameters::INDEX_SUBSET_NO_HEADERS;
+    cmd.addVariable("CREATEINDEX_PAR", par.createParameterString(par.createindex).c_str());
+    par.indexSubset = indexSubset;
 
     cmd.addVariable("CLUST_PAR", par.createParameterString(par.clusterworkflow, true).c_str());
 
@@ -265,6 +265,12 @@ int search(int argc, const char **argv, const Command& command) {
         EXIT(EXIT_FAILURE);
     }
 
+    if (par.lcaEarlyExit && par.lcaSearch == false) {
+        par.printUsageMessage(command, MMseqsParameter::COMMAND_ALIGN | MMseqsParameter::COMMAND_PREFILTER);
+        Debug(Debug::ERROR) << "Cannot use --lca-early-exit without --lca-search\n";
+        EXIT(EXIT_FAILURE);
+    }
+
     if (isUngappedMode && par.lcaSearch) {
         par.printUsageMessage(command, MMseqsParameter::COMMAND_ALIGN | MMseqsParameter::COMMAND_PREFILTER);
         Debug(Debug::ERROR) << "Cannot use ungapped alignment mode with lca search\n";
@@ -318,6 +324,7 @@ int search(int argc, const char **argv, const Command& command) {
     } else {
         cmd.addVariable("ALIGN_MODULE", "align");
     }
+    std::vector<MMseqsParameter*> &alignPar = par.lcaSearch ? par.lcaalign : par.align;
 
     // GPU can only use the ungapped prefilter
     if (par.gpu == 1 && par.PARAM_PREF_MODE.wasSet == false) {
@@ -388,9 +395,9 @@ int search(int argc, const char **argv, const Command& command) {
             cmd.addVariable("ALIGNMENT_PAR", par.createParameterString(par.rescorediagonal).c_str());
             par.rescoreMode = originalRescoreMode;
         } else {
-            cmd.addVariable("ALIGNMENT_PAR", par.createParameterString(par.align).c_str());
+            cmd.addVariable("ALIGNMENT_PAR", par.createParameterString(alignPar).c_str());
             par.alignmentOutputMode = Parameters::ALIGNMENT_OUTPUT_CLUSTER;
-            cmd.addVariable("ALIGNMENT_IT_PAR", par.createParameterString(par.align).c_str());
+            cmd.addVariable("ALIGNMENT_IT_PAR", par.createParameterString(alignPar).c_str());
         }
 
         par.covMode = originalCovMode;
@@ -445,7 +452,7 @@ int search(int argc, const char **argv, const Command& command) {
                 par.rescoreMode = originalRescoreMode;
             } else {
                 cmd.addVariable(std::string("ALIGNMENT_PAR_" + SSTR(i)).c_str(),
-                                par.createParameterString(par.align).c_str());
+                                par.createParameterString(alignPar).c_str());
             }
         }
         FileUtil::writeFile(tmpDir + "/iterativepp.sh", iterativepp_sh, iterativepp_sh_len);
@@ -466,7 +473,7 @@ int search(int argc, const char **argv, const Command& command) {
             cmd.addVariable("ALIGNMENT_PAR", par.createParameterString(par.rescorediagonal).c_str());
             par.rescoreMode = originalRescoreMode;
         } else {
-            cmd.addVariable("ALIGNMENT_PAR", par.createParameterString(par.align).c_str());
+            cmd.addVariable("ALIGNMENT_PAR", par.createParameterString(alignPar).c_str());
         }
         par.covMode = originalCovMode;
         par.maxResListLen = maxResListLen;
@@ -513,7 +520,7 @@ int search(int argc, const char **argv, const Command& command) {
                 par.rescoreMode = originalRescoreMode;
             } else {
                 cmd.addVariable(std::string("ALIGNMENT_PAR_" + SSTR(i)).c_str(),
-                                par.createParameterString(par.align).c_str());
+                                par.createParameterString(alignPar).c_str());
             }
             cmd.addVariable(std::string("PROFILE_PAR_" + SSTR(i)).c_str(),
                             par.createParameterString(par.result2profile).c_str());
@@ -558,6 +565,16 @@ int search(int argc, const char **argv, const Command& command) {
         }
         if (par.prefMode == Parameters::PREF_MODE_KMER) {
             cmd.addVariable("PREFILTER_PAR", par.createParameterString(prefilterWithoutS).c_str());
+            // the fused module runs all splits in one process, so it cannot be distributed by a runner
+            if (par.fusedPrefilterAlign && par.runner.empty() && par.sensSteps <= 1 && isUngappedMode == false && par.lcaSearch == false) {
+                std::vector<MMseqsParameter*> prefilterAlignWithoutS;
+                for (size_t i = 0; i < par.prefilteralign.size(); i++) {
+                    if (par.prefilteralign[i]->uniqid != par.PARAM_S.uniqid) {
+                        prefilterAlignWithoutS.push_back(par.prefilteralign[i]);
+                    }
+                }
+                cmd.addVariable("PREFILTER_ALIGN_PAR", par.createParameterString(prefilterAlignWithoutS).c_str());
+            }
         } else if (par.prefMode == Parameters::PREF_MODE_UNGAPPED ||
                    par.prefMode == Parameters::PREF_MODE_UNGAPPED_AND_GAPPED) {
             cmd.addVariable("UNGAPPEDPREFILTER_PAR", par.createParameterString(par.ungappedprefilter).c_str());
@@ -567,7 +584,7 @@ int search(int argc, const char **argv, const Command& command) {
             cmd.addVariable("ALIGNMENT_PAR", par.createParameterString(par.rescorediagonal).c_str());
             par.rescoreMode = originalRescoreMode;
         } else {
-            cmd.addVariable("ALIGNMENT_PAR", par.createParameterString(par.align).c_str());
+            cmd.addVariable("ALIGNMENT_PAR", par.createParameterString(alignPar).c_str());
         }
         FileUtil::writeFile(tmpDir + "/blastp.sh", blastp_sh, blastp_sh_len);
         program = std::string(tmpDir + "/blastp.sh");